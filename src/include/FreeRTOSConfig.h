@@ -40,9 +40,27 @@
   * See http://www.freertos.org/a00110.html
   *----------------------------------------------------------*/
  
+ /* Build SMP (TRAFFIC_SMP=1, opção do CMake): os dois núcleos do RP2040 com
+  * afinidade por tarefa (ver CORE_MASK_* em config.h). */
+ #ifndef TRAFFIC_SMP
+ #define TRAFFIC_SMP                             0
+ #endif
+
+ /* Build estático (TRAFFIC_STATIC=1, opção do CMake): pilhas, TCBs, fila,
+  * event group e memória das tarefas idle/timer em .bss; sem heap do FreeRTOS. */
+ #ifndef TRAFFIC_STATIC
+ #define TRAFFIC_STATIC                          0
+ #endif
+
  /* Scheduler Related */
  #define configUSE_PREEMPTION                    1
+ #if TRAFFIC_SMP
+ /* Tickless idle não é suportado pelo escalonador SMP: sem sono, power_stats
+  * registra só o tempo ativo. */
  #define configUSE_TICKLESS_IDLE                 0
+ #else
+ #define configUSE_TICKLESS_IDLE                 1
+ #endif
  #define configUSE_IDLE_HOOK                     0
  #define configUSE_TICK_HOOK                     0
  #define configTICK_RATE_HZ                      ( ( TickType_t ) 1000 )
@@ -52,6 +70,17 @@
  
  #define configIDLE_SHOULD_YIELD                 1
  
+ /* Tickless idle: dorme (WFI) até o próximo prazo de tarefa; os ganchos
+  * alimentam a contabilidade de energia (power_stats.c). */
+ #define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+ #ifndef __ASSEMBLER__
+ #include <stdint.h>
+ void power_stats_pre_sleep(uint32_t expected_idle_ticks);
+ void power_stats_post_sleep(uint32_t expected_idle_ticks);
+ #endif
+ #define configPRE_SLEEP_PROCESSING(x)           power_stats_pre_sleep(x)
+ #define configPOST_SLEEP_PROCESSING(x)          power_stats_post_sleep(x)
+ 
  /* Synchronization Related */
  #define configUSE_MUTEXES                       1
  #define configUSE_RECURSIVE_MUTEXES             1
@@ -69,18 +98,24 @@
  #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
  
  /* Memory allocation related definitions. */
+ #if TRAFFIC_STATIC
+ #define configSUPPORT_STATIC_ALLOCATION         1
+ #define configSUPPORT_DYNAMIC_ALLOCATION        0
+ #define configKERNEL_PROVIDED_STATIC_MEMORY     0  /* idle/timer: static_memory.c */
+ #else
  #define configSUPPORT_STATIC_ALLOCATION         0
  #define configSUPPORT_DYNAMIC_ALLOCATION        1
+ #endif
  #define configTOTAL_HEAP_SIZE                   (128*1024)
  #define configAPPLICATION_ALLOCATED_HEAP        0
  
  /* Hook function related definitions. */
- #define configCHECK_FOR_STACK_OVERFLOW          0
+ #define configCHECK_FOR_STACK_OVERFLOW          2
  #define configUSE_MALLOC_FAILED_HOOK            0
  #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
  
  /* Run time and task stats gathering related definitions. */
- #define configGENERATE_RUN_TIME_STATS           0
+ #define configGENERATE_RUN_TIME_STATS           1
  #define configUSE_TRACE_FACILITY                1
  #define configUSE_STATS_FORMATTING_FUNCTIONS    0
  
@@ -102,8 +137,15 @@
  */
  
  /* SMP port only */
- #define configNUM_CORES                         1
- #define configTICK_CORE                         1
+ #if TRAFFIC_SMP
+ #define configNUMBER_OF_CORES                   2
+ #define configUSE_CORE_AFFINITY                 1
+ #define configUSE_PASSIVE_IDLE_HOOK             0
+ #else
+ #define configNUMBER_OF_CORES                   1
+ #endif
+ #define configNUM_CORES                         configNUMBER_OF_CORES
+ #define configTICK_CORE                         0
  #define configRUN_MULTIPLE_PRIORITIES           1
  
  /* RP2040 specific */
@@ -133,6 +175,25 @@
  #define INCLUDE_xTaskResumeFromISR              1
  #define INCLUDE_xQueueGetMutexHolder            1
  
+ /* Run-time stats com base no timer de 1 us do RP2040 (já rodando desde o boot) */
+ #ifndef __ASSEMBLER__
+ #include "hardware/timer.h"
+ #endif
+ #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+ #define portGET_RUN_TIME_COUNTER_VALUE()        time_us_32()
+ 
  /* A header file that defines trace macro can be included here. */
+ #if TRAFFIC_SMP && !defined(__ASSEMBLER__)
+ /* Ocupação por núcleo sem fixar as idles: soma o idle nas trocas de contexto (task_stats.c) */
+ void task_stats_switched_in(void);
+ void task_stats_switched_out(void);
+ #define traceTASK_SWITCHED_IN()                 task_stats_switched_in()
+ #define traceTASK_SWITCHED_OUT()                task_stats_switched_out()
+ #endif
+
+ /* Simulação no host (alvo traffic_sim): ajustes para a porta POSIX. */
+ #ifdef TRAFFIC_SIM
+ #include "sim_freertos_config.h"
+ #endif
  
  #endif /* FREERTOS_CONFIG_H */
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "adaptive_timing.h"
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "config.h"
+#include <stdio.h>
+
+/*
+ * Tudo em inteiros (ms, por hora, por mil): uma atualização é uma passada
+ * pelos passos do plano, barata o bastante para rodar na tarefa de controle
+ * na fronteira do ciclo. As chegadas vêm de interrupção (detectores) e da
+ * tarefa dos botões (chamadas); a leitura e o zeramento usam seção crítica.
+ */
+
+static bool is_green_step(const signal_plan_t *plan, uint8_t step) {
+    uint8_t interval = plan->steps[step].interval;
+    return step != plan->night_step &&
+           (interval == SIGNAL_INTERVAL_GREEN || interval == SIGNAL_INTERVAL_WALK);
+}
+
+static uint16_t min_duration_ms(const signal_plan_t *plan, uint8_t step) {
+    return plan->steps[step].interval == SIGNAL_INTERVAL_WALK ? ADAPTIVE_MIN_WALK_MS : ADAPTIVE_MIN_GREEN_MS;
+}
+
+static void load_table(adaptive_timing_t *timing) {
+    const signal_plan_t *plan = timing->plan;
+    timing->cycle_ms = timing->lost_ms;
+    for (uint8_t step = 0; step < plan->step_count; ++step) {
+        timing->duration_ms[step] = plan->steps[step].duration_ms;
+    }
+    for (uint8_t i = 0; i < timing->green_step_count; ++i) {
+        timing->cycle_ms += timing->duration_ms[timing->green_steps[i]];
+    }
+}
+
+// Primeiro grupo servido (verde/travessia) por um passo ajustável sem detector
+static uint8_t find_unmeasured_group(const adaptive_timing_t *timing) {
+    const signal_plan_t *plan = timing->plan;
+    for (uint8_t i = 0; i < timing->green_step_count; ++i) {
+        for (uint8_t group = 0; group < plan->group_count; ++group) {
+            signal_indication_t indication = signal_plan_indication(plan, timing->green_steps[i], group);
+            if ((indication == SIGNAL_GREEN || indication == SIGNAL_WALK) &&
+                !(timing->detector_groups & (1u << group))) {
+                return group;
+            }
+        }
+    }
+    return SIGNAL_MAX_GROUPS;
+}
+
+/**
+ * @brief Percorre um ciclo do plano (do primeiro passo que abre ciclo até voltar
+ *        a ele) separando os passos ajustáveis do tempo perdido, e começa com as
+ *        durações da tabela.
+ * @param detector_groups Grupos com demanda medida (bit n = grupo n). Se algum
+ *        grupo servido por um passo ajustável ficar de fora, o ajuste não liga.
+ */
+void adaptive_timing_init(adaptive_timing_t *timing, const signal_plan_t *plan, bool enabled,
+                          uint16_t detector_groups) {
+    *timing = (adaptive_timing_t){ .plan = plan, .detector_groups = detector_groups };
+    uint8_t first = plan->start_step;
+    for (uint8_t step = 0; step < plan->step_count; ++step) {
+        if (plan->steps[step].cycle_start) {
+            first = step;
+            break;
+        }
+    }
+    uint8_t step = first;
+    for (uint8_t n = 0; n < plan->step_count; ++n) {
+        if (is_green_step(plan, step)) {
+            timing->green_steps[timing->green_step_count++] = step;
+        } else {
+            timing->lost_ms += plan->steps[step].duration_ms;
+        }
+        step = plan->steps[step].next;
+        if (step == first) {
+            break;
+        }
+    }
+    load_table(timing);
+    timing->unmeasured_group = find_unmeasured_group(timing);
+    adaptive_timing_set_enabled(timing, enabled);
+}
+
+/**
+ * @brief Liga ou desliga o ajuste; vale a partir do próximo ciclo.
+ * @return false se pediu para ligar e algum grupo servido não tem detector
+ *         (o ajuste fica desligado e valem as durações da tabela).
+ */
+bool adaptive_timing_set_enabled(adaptive_timing_t *timing, bool enabled) {
+    if (enabled && timing->unmeasured_group < SIGNAL_MAX_GROUPS) {
+        timing->enabled = false;
+        return false;
+    }
+    timing->enabled = enabled;
+    return true;
+}
+
+/**
+ * @brief Uma chegada (veículo detectado ou chamada de pedestre) no grupo.
+ */
+void adaptive_timing_arrival(adaptive_timing_t *timing, uint8_t group) {
+    if (group >= timing->plan->group_count) {
+        return;
+    }
+    taskENTER_CRITICAL();
+    if (timing->arrivals[group] < UINT16_MAX) {
+        timing->arrivals[group]++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void adaptive_timing_arrival_from_isr(adaptive_timing_t *timing, uint8_t group) {
+    if (group >= timing->plan->group_count) {
+        return;
+    }
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    if (timing->arrivals[group] < UINT16_MAX) {
+        timing->arrivals[group]++;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+// Razão de fluxo crítica do passo (por mil): o grupo mais carregado entre os que ele serve
+static uint32_t step_flow_ratio(const adaptive_timing_t *timing, uint8_t step) {
+    const signal_plan_t *plan = timing->plan;
+    uint32_t ratio = 0;
+    for (uint8_t group = 0; group < plan->group_count; ++group) {
+        signal_indication_t indication = signal_plan_indication(plan, step, group);
+        uint32_t saturation;
+        if (indication == SIGNAL_GREEN) {
+            saturation = ADAPTIVE_SAT_FLOW_VEH_PER_H;
+        } else if (indication == SIGNAL_WALK) {
+            saturation = ADAPTIVE_SAT_FLOW_PED_PER_H;
+        } else {
+            continue;
+        }
+        uint32_t group_ratio = timing->flow_per_hour[group] * 1000u / saturation;
+        if (group_ratio > ratio) {
+            ratio = group_ratio;
+        }
+    }
+    return ratio;
+}
+
+/**
+ * @brief Fim de um ciclo de cycle_ms: atualiza a demanda de cada grupo e
+ *        recalcula o ciclo e os verdes do próximo. Chamada pelo controle na
+ *        fronteira do passo que abre o ciclo.
+ */
+void adaptive_timing_cycle(adaptive_timing_t *timing, uint32_t cycle_ms) {
+    const signal_plan_t *plan = timing->plan;
+    uint32_t start_us = time_us_32();
+    uint16_t arrivals[SIGNAL_MAX_GROUPS];
+
+    taskENTER_CRITICAL();
+    for (uint8_t group = 0; group < plan->group_count; ++group) {
+        arrivals[group] = timing->arrivals[group];
+        timing->arrivals[group] = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    // Demanda suavizada: média móvel exponencial da taxa medida em cada ciclo
+    if (cycle_ms > 0) {
+        for (uint8_t group = 0; group < plan->group_count; ++group) {
+            int32_t measured = (int32_t)((uint64_t)arrivals[group] * 3600000u / cycle_ms);
+            int32_t flow = (int32_t)timing->flow_per_hour[group];
+            timing->flow_per_hour[group] = (uint32_t)(flow + ((measured - flow) >> ADAPTIVE_FLOW_SMOOTHING_SHIFT));
+        }
+    }
+
+    uint32_t ratios[SIGNAL_MAX_STEPS];
+    uint32_t total_ratio = 0;
+    for (uint8_t i = 0; i < timing->green_step_count; ++i) {
+        ratios[i] = step_flow_ratio(timing, timing->green_steps[i]);
+        total_ratio += ratios[i];
+    }
+    timing->flow_ratio_permille = (uint16_t)(total_ratio > UINT16_MAX ? UINT16_MAX : total_ratio);
+
+    if (!timing->enabled || total_ratio == 0) {
+        // Sem ajuste ou ainda sem demanda medida: a tabela vale
+        load_table(timing);
+    } else {
+        // Saturado (Y perto de 1) o ciclo ótimo diverge: limita Y e deixa o ciclo no máximo
+        uint32_t capped_ratio = total_ratio < ADAPTIVE_MAX_FLOW_RATIO_PERMILLE ? total_ratio
+                                                                               : ADAPTIVE_MAX_FLOW_RATIO_PERMILLE;
+        uint32_t cycle = (timing->lost_ms * 3u / 2u + 5000u) * 1000u / (1000u - capped_ratio);
+        if (cycle < ADAPTIVE_CYCLE_MIN_MS) {
+            cycle = ADAPTIVE_CYCLE_MIN_MS;
+        } else if (cycle > ADAPTIVE_CYCLE_MAX_MS) {
+            cycle = ADAPTIVE_CYCLE_MAX_MS;
+        }
+        uint32_t effective_green = cycle > timing->lost_ms ? cycle - timing->lost_ms : 0;
+
+        // Divide o verde útil na proporção das razões críticas, dentro dos limites de segurança
+        timing->cycle_ms = timing->lost_ms;
+        for (uint8_t i = 0; i < timing->green_step_count; ++i) {
+            uint8_t step = timing->green_steps[i];
+            uint32_t green = (uint32_t)((uint64_t)effective_green * ratios[i] / total_ratio);
+            uint32_t minimum = min_duration_ms(plan, step);
+            if (green < minimum) {
+                green = minimum;
+            } else if (green > ADAPTIVE_MAX_GREEN_MS) {
+                green = ADAPTIVE_MAX_GREEN_MS;
+            }
+            timing->duration_ms[step] = (uint16_t)green;
+            timing->cycle_ms += green;
+        }
+    }
+
+    timing->updates++;
+    uint32_t elapsed_us = time_us_32() - start_us;
+    if (elapsed_us > timing->update_max_us) {
+        timing->update_max_us = elapsed_us;
+    }
+}
+
+/**
+ * @brief Imprime o ciclo calculado, a demanda por grupo e os verdes em uso.
+ */
+void adaptive_timing_print(const adaptive_timing_t *timing) {
+    adaptive_timing_t t;
+    taskENTER_CRITICAL();
+    t = *timing;
+    taskEXIT_CRITICAL();
+
+    printf("Tempos %s: ciclo %lu ms (perdido %lu ms), Y = %u.%03u, %lu atualizacoes (max %lu us)\n",
+           t.enabled ? "adaptativos" : "da tabela", (unsigned long)t.cycle_ms, (unsigned long)t.lost_ms,
+           t.flow_ratio_permille / 1000u, t.flow_ratio_permille % 1000u,
+           (unsigned long)t.updates, (unsigned long)t.update_max_us);
+    if (t.unmeasured_group < SIGNAL_MAX_GROUPS) {
+        printf("Ajuste indisponivel: grupo %u sem detector\n", t.unmeasured_group);
+    }
+    printf("Demanda (por hora):");
+    for (uint8_t group = 0; group < t.plan->group_count; ++group) {
+        printf(" %lu", (unsigned long)t.flow_per_hour[group]);
+    }
+    printf("\n");
+    for (uint8_t i = 0; i < t.green_step_count; ++i) {
+        uint8_t step = t.green_steps[i];
+        printf("  %-32s %5u ms (tabela %u ms)\n", t.plan->steps[step].name,
+               t.duration_ms[step], t.plan->steps[step].duration_ms);
+    }
+}
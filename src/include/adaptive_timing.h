@@ -0,0 +1,65 @@
+#ifndef ADAPTIVE_TIMING_H
+#define ADAPTIVE_TIMING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "signal_plan.h"
+
+/*
+ * Tempos adaptativos pelo método de Webster. Cada grupo semafórico acumula as
+ * chegadas do ciclo em andamento (detectores veiculares, chamadas de pedestre);
+ * no início de cada ciclo a demanda suavizada de cada grupo vira uma razão de
+ * fluxo y = q / s e os passos de verde e de travessia são redimensionados:
+ *   C0 = (1,5 L + 5) / (1 - Y)      ciclo ótimo, L = tempo perdido, Y = soma dos y críticos
+ *   g_i = (C0 - L) y_i / Y          verde de cada passo, proporcional à demanda
+ * com o ciclo e cada verde presos aos limites de segurança do config.h.
+ * Passos de amarelo, vermelho geral e limpeza não mudam: são o tempo perdido L.
+ *
+ * Um grupo sem detector tem demanda medida sempre 0, e Webster daria a ele só o
+ * verde mínimo em todo ciclo. Por isso o ajuste só liga se todo grupo servido
+ * por um passo ajustável tem detector (detector_groups); senão vale a tabela.
+ */
+
+/**
+ * @brief Estado do ajuste adaptativo de um controle (um plano).
+ */
+typedef struct {
+    const signal_plan_t *plan;
+    bool enabled;                               // false: durações da tabela
+    uint16_t detector_groups;                   // bit n: a demanda do grupo n é medida
+    uint8_t unmeasured_group;                   // grupo servido sem detector (ou SIGNAL_MAX_GROUPS)
+    volatile uint16_t arrivals[SIGNAL_MAX_GROUPS]; // chegadas no ciclo em andamento
+    uint32_t flow_per_hour[SIGNAL_MAX_GROUPS];  // demanda suavizada de cada grupo
+    uint16_t duration_ms[SIGNAL_MAX_STEPS];     // duração em uso de cada passo
+    uint8_t green_steps[SIGNAL_MAX_STEPS];      // passos ajustáveis (verde/travessia), na ordem do ciclo
+    uint8_t green_step_count;
+    uint32_t lost_ms;                           // L: soma dos passos fixos de um ciclo
+    uint32_t cycle_ms;                          // ciclo calculado na última atualização
+    uint16_t flow_ratio_permille;               // Y da última atualização
+    uint32_t updates;
+    uint32_t update_max_us;                     // maior custo de uma atualização
+} adaptive_timing_t;
+
+void adaptive_timing_init(adaptive_timing_t *timing, const signal_plan_t *plan, bool enabled,
+                          uint16_t detector_groups);
+bool adaptive_timing_set_enabled(adaptive_timing_t *timing, bool enabled);
+void adaptive_timing_arrival(adaptive_timing_t *timing, uint8_t group);
+void adaptive_timing_arrival_from_isr(adaptive_timing_t *timing, uint8_t group);
+void adaptive_timing_cycle(adaptive_timing_t *timing, uint32_t cycle_ms);
+void adaptive_timing_print(const adaptive_timing_t *timing);
+
+/**
+ * @brief Detector veicular (laço, câmera, contador) em contexto de interrupção.
+ *        Implementada pela aplicação (main.c), que sabe qual controle recebe a
+ *        entrada. Na placa não há detector ligado; o alvo traffic_sim a chama.
+ */
+void detector_arrival_from_isr(uint8_t group);
+
+/**
+ * @brief Duração em uso do passo (a da tabela, com o ajuste desligado).
+ */
+static inline uint16_t adaptive_timing_duration(const adaptive_timing_t *timing, uint8_t step) {
+    return timing->duration_ms[step];
+}
+
+#endif // ADAPTIVE_TIMING_H
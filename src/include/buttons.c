@@ -1,72 +1,218 @@
-#include "hardware/gpio.h"
-#include "hardware/irq.h"
 #include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "queue.h"
 #include "buttons.h"
 #include "config.h"
 #include "debouncer.h"
-#include "pico/bootrom.h"
-
-static volatile bool flag_button_a = false; //Flag volátil indicando se o botão A foi pressionado
-//static volatile bool flag_button_b = false; //Flag volátil indicando se o botão B foi pressionado
-static uint32_t last_press_time_a = 0;
-static uint32_t last_press_time_b = 0;
-
- /**  * @brief Callback da interrupção dos pinos dos botões.
-  *        Chamada quando ocorre uma borda de descida (GPIO_IRQ_EDGE_FALL).
-  *        Verifica qual botão gerou a interrupção, aplica debounce e
-  *        ativa a flag correspondente. O botão B também aciona o reset para bootloader USB.
-  *
-  * @param gpio O número do pino GPIO que gerou a interrupção.
-  * @param events Máscara de bits indicando os eventos que ocorreram (ex: GPIO_IRQ_EDGE_FALL).
-  */
- static void buttons_irq_callback(uint gpio, uint32_t events) {
-     // Verifica se o evento foi uma borda de descida
-     if (events & GPIO_IRQ_EDGE_FALL) {
-         switch (gpio) {
-             case BUTTON_A_PIN:
-                 // Aplica debounce e ativa a flag do botão A se válido
-                 if (check_debounce(&last_press_time_a, DEBOUNCE_TIME_US)) {
-                     flag_button_a = true;
-                 }
-                 break;
-             default:
-                 // Ignora outros pinos, se houver
-                 break;
-         }
-     }
- }
- 
- /**
-  * @brief Inicializa os pinos GPIO dos botões A e B.
-  *        Configura os pinos como entrada com resistores de pull-up internos.
-  *        Habilita as interrupções por borda de descida para ambos os botões,
-  *        associando a função de callback `buttons_irq_callback`.
-  */
- void buttons_init() {
-     // Configura botão A
-     gpio_init(BUTTON_A_PIN);
-     gpio_set_dir(BUTTON_A_PIN, GPIO_IN);
-     gpio_pull_up(BUTTON_A_PIN);
-
- 
-     // Habilita interrupções por borda de descida para ambos os botões
-     gpio_set_irq_enabled_with_callback(BUTTON_A_PIN, GPIO_IRQ_EDGE_FALL, true, &buttons_irq_callback);
-     gpio_set_irq_enabled_with_callback(BUTTON_B_PIN, GPIO_IRQ_EDGE_FALL, true, &buttons_irq_callback);
- }
- 
- /**
-  * @brief Verifica se o botão A foi pressionado desde a última chamada.
-  *        Lê a flag `flag_button_a` (que é ativada pela ISR) e a reseta
-  *        se estiver ativa, para indicar que o pressionamento foi consumido.
-  *
-  * @return true Se o botão A foi pressionado e ainda não foi consumido.
-  * @return false Caso contrário.
-  */
- bool button_a_pressed() {
-     if (flag_button_a) {
-         flag_button_a = false; // Reseta a flag (consome o evento)
-         return true;
-     }
-     return false;
- }
+#include "trace.h"
 
+/*
+ * O debouncer (debouncer.c) entrega só bordas limpas, em interrupção, e elas
+ * vão para a fila com botão, nível e instante; a tarefa consumidora bloqueia
+ * na fila e classifica os gestos:
+ *   - toque: se o botão só tem BUTTON_GESTURE_PRESS, sai já na borda de descida;
+ *     com toque longo habilitado sai ao soltar; com toque duplo, só depois da
+ *     janela do segundo toque;
+ *   - toque longo: ao completar BUTTON_LONG_PRESS_MS pressionado;
+ *   - toque duplo: segundo aperto dentro de BUTTON_DOUBLE_PRESS_MS após soltar.
+ */
+
+typedef enum {
+    GESTURE_IDLE = 0,    // solto, nenhum gesto em andamento
+    GESTURE_HELD,        // pressionado, gesto ainda não decidido
+    GESTURE_WAIT_SECOND, // soltou; aguardando um possível segundo toque
+    GESTURE_DONE,        // gesto já emitido; aguardando soltar
+} gesture_phase_t;
+
+typedef struct {
+    uint pin;
+    uint8_t gestures;        // BUTTON_GESTURE_* habilitados
+    // estado do classificador (só na tarefa consumidora)
+    gesture_phase_t phase;
+    bool deadline_armed;
+    uint32_t deadline_us;    // fim da espera do toque longo ou do segundo toque
+} button_state_t;
+
+static button_state_t buttons[BUTTON_COUNT] = {
+    [BUTTON_A] = { .pin = BUTTON_A_PIN, .gestures = BUTTON_A_GESTURES },
+    [BUTTON_B] = { .pin = BUTTON_B_PIN, .gestures = BUTTON_B_GESTURES },
+};
+
+static QueueHandle_t edge_queue = NULL;
+static volatile uint32_t dropped_edges = 0; // fila cheia (escrito só pela ISR)
+
+/**
+ * @brief Borda limpa vinda do debouncer (contexto de interrupção): envia a
+ *        borda com o instante estimado para a fila.
+ */
+static void buttons_edge(uint8_t button, bool pressed, uint32_t time_us) {
+    button_edge_t edge = { .button = button, .pressed = pressed, .time_us = time_us };
+    BaseType_t higher_priority_woken = pdFALSE;
+    if (xQueueSendFromISR(edge_queue, &edge, &higher_priority_woken) != pdTRUE) {
+        dropped_edges++;
+    }
+    portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+/**
+ * @brief Inicializa a fila de bordas e o debounce dos botões A e B
+ *        (PIO ou interrupção de GPIO, conforme DEBOUNCE_USE_PIO).
+ */
+void buttons_init() {
+#if configSUPPORT_STATIC_ALLOCATION
+    static StaticQueue_t edge_queue_buffer;
+    static uint8_t edge_queue_storage[BUTTON_EDGE_QUEUE_LEN * sizeof(button_edge_t)];
+    edge_queue = xQueueCreateStatic(BUTTON_EDGE_QUEUE_LEN, sizeof(button_edge_t), edge_queue_storage, &edge_queue_buffer);
+#else
+    edge_queue = xQueueCreate(BUTTON_EDGE_QUEUE_LEN, sizeof(button_edge_t));
+#endif
+    configASSERT(edge_queue != NULL);
+
+    uint pins[BUTTON_COUNT];
+    for (uint8_t button = 0; button < BUTTON_COUNT; ++button) {
+        pins[button] = buttons[button].pin;
+    }
+    debouncer_init(pins, BUTTON_COUNT, buttons_edge);
+}
+
+static void emit(button_gesture_event_t *out, uint8_t button, uint8_t gesture, uint32_t time_us) {
+    out->button = button;
+    out->gesture = gesture;
+    out->time_us = time_us;
+    trace_event(TRACE_CTX_BUTTON, TRACE_EV_BUTTON_GESTURE, (uint16_t)((button << 8) | gesture));
+}
+
+static void arm(button_state_t *state, uint32_t from_us, uint32_t delay_ms) {
+    state->deadline_armed = true;
+    state->deadline_us = from_us + delay_ms * 1000u;
+}
+
+// Aplica uma borda ao classificador; devolve true se decidiu um gesto
+static bool classify_edge(const button_edge_t *edge, button_gesture_event_t *out) {
+    button_state_t *state = &buttons[edge->button];
+    if (edge->pressed) {
+        if (state->phase == GESTURE_WAIT_SECOND) {
+            state->deadline_armed = false;
+            state->phase = GESTURE_DONE;
+            emit(out, edge->button, BUTTON_GESTURE_DOUBLE_PRESS, edge->time_us);
+            return true;
+        }
+        if (state->gestures == BUTTON_GESTURE_PRESS) {
+            state->phase = GESTURE_DONE;
+            emit(out, edge->button, BUTTON_GESTURE_PRESS, edge->time_us);
+            return true;
+        }
+        state->phase = GESTURE_HELD;
+        state->deadline_armed = false;
+        if (state->gestures & BUTTON_GESTURE_LONG_PRESS) {
+            arm(state, edge->time_us, BUTTON_LONG_PRESS_MS);
+        }
+        return false;
+    }
+
+    // Soltou
+    if (state->phase != GESTURE_HELD) {
+        state->phase = GESTURE_IDLE; // gesto já emitido (ou borda sem aperto correspondente)
+        return false;
+    }
+    state->deadline_armed = false;
+    if (state->gestures & BUTTON_GESTURE_DOUBLE_PRESS) {
+        state->phase = GESTURE_WAIT_SECOND;
+        arm(state, edge->time_us, BUTTON_DOUBLE_PRESS_MS);
+        return false;
+    }
+    state->phase = GESTURE_IDLE;
+    if (state->gestures & BUTTON_GESTURE_PRESS) {
+        emit(out, edge->button, BUTTON_GESTURE_PRESS, edge->time_us);
+        return true;
+    }
+    return false;
+}
+
+// Prazo vencido: toque longo (ainda pressionado) ou toque simples (sem segundo toque)
+static bool classify_deadline(uint8_t button, button_gesture_event_t *out) {
+    button_state_t *state = &buttons[button];
+    state->deadline_armed = false;
+    if (state->phase == GESTURE_HELD) {
+        state->phase = GESTURE_DONE;
+        emit(out, button, BUTTON_GESTURE_LONG_PRESS, state->deadline_us);
+        return true;
+    }
+    if (state->phase == GESTURE_WAIT_SECOND) {
+        state->phase = GESTURE_IDLE;
+        if (state->gestures & BUTTON_GESTURE_PRESS) {
+            emit(out, button, BUTTON_GESTURE_PRESS, state->deadline_us);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Bloqueia na fila de bordas até decidir o próximo gesto ou até o timeout.
+ *        Enquanto há um gesto em andamento a espera é limitada pelo prazo dele,
+ *        então toques longos e simples (com duplo habilitado) saem sem polling.
+ *        Chamada por uma única tarefa.
+ * @return true se um gesto foi decidido, false se o tempo esgotou.
+ */
+bool buttons_wait_gesture(button_gesture_event_t *gesture, TickType_t timeout) {
+    TickType_t start = xTaskGetTickCount();
+    while (true) {
+        // Prazos vencidos primeiro
+        uint32_t now_us = time_us_32();
+        uint32_t next_deadline_us = UINT32_MAX;
+        for (uint8_t button = 0; button < BUTTON_COUNT; ++button) {
+            if (!buttons[button].deadline_armed) {
+                continue;
+            }
+            int32_t remaining_us = (int32_t)(buttons[button].deadline_us - now_us);
+            if (remaining_us <= 0) {
+                if (classify_deadline(button, gesture)) {
+                    return true;
+                }
+            } else if ((uint32_t)remaining_us < next_deadline_us) {
+                next_deadline_us = (uint32_t)remaining_us;
+            }
+        }
+
+        TickType_t wait = timeout;
+        if (timeout != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            wait = (elapsed >= timeout) ? 0 : timeout - elapsed;
+        }
+        bool limited_by_deadline = false;
+        if (next_deadline_us != UINT32_MAX) {
+            // Arredonda para cima: acordar antes do prazo só faria outra volta
+            TickType_t deadline_ticks = pdMS_TO_TICKS((next_deadline_us + 999u) / 1000u) + 1;
+            if (deadline_ticks < wait) {
+                wait = deadline_ticks;
+                limited_by_deadline = true;
+            }
+        }
+
+        button_edge_t edge;
+        if (xQueueReceive(edge_queue, &edge, wait) == pdTRUE) {
+            if (classify_edge(&edge, gesture)) {
+                return true;
+            }
+        } else if (!limited_by_deadline) {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Bordas perdidas porque a fila estava cheia.
+ */
+uint32_t buttons_dropped_edges() {
+    return dropped_edges;
+}
+
+const char *button_gesture_name(uint8_t gesture) {
+    switch (gesture) {
+        case BUTTON_GESTURE_PRESS:        return "toque";
+        case BUTTON_GESTURE_LONG_PRESS:   return "toque longo";
+        case BUTTON_GESTURE_DOUBLE_PRESS: return "toque duplo";
+        default:                          return "?";
+    }
+}
@@ -2,10 +2,43 @@
 #define BUTTONS_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
 
-void buttons_init();
-bool button_a_pressed();
-bool button_b_pressed();
+typedef enum {
+    BUTTON_A = 0,
+    BUTTON_B,
+    BUTTON_COUNT
+} button_id_t;
+
+// Gestos reconhecidos (bits, para a máscara de gestos habilitados de cada botão)
+#define BUTTON_GESTURE_PRESS        (1u << 0)
+#define BUTTON_GESTURE_LONG_PRESS   (1u << 1)
+#define BUTTON_GESTURE_DOUBLE_PRESS (1u << 2)
+
+/**
+ * @brief Borda aceita pela ISR, já com debounce: enviada à fila de eventos.
+ */
+typedef struct {
+    uint8_t button;    // button_id_t
+    bool pressed;      // true = apertou (borda de descida), false = soltou
+    uint32_t time_us;  // time_us_32() na ISR
+} button_edge_t;
 
+/**
+ * @brief Gesto classificado a partir das bordas.
+ *        time_us é o instante em que o gesto ficou decidido (a borda que o
+ *        completou ou o fim da janela de espera), base da medida de latência.
+ */
+typedef struct {
+    uint8_t button;    // button_id_t
+    uint8_t gesture;   // BUTTON_GESTURE_*
+    uint32_t time_us;
+} button_gesture_event_t;
+
+void buttons_init();
+bool buttons_wait_gesture(button_gesture_event_t *gesture, TickType_t timeout);
+uint32_t buttons_dropped_edges();
+const char *button_gesture_name(uint8_t gesture);
 
-#endif // BUTTONS_H
\ No newline at end of file
+#endif // BUTTONS_H
@@ -2,91 +2,238 @@
 #include "hardware/pwm.h"
 #include "hardware/clocks.h"
 #include "pico/stdlib.h"
+#include "pico/critical_section.h"
 #include "buzzer.h"
 #include "config.h"
 
+/*
+ * Sequenciador de tons não bloqueante. Os padrões (freq, on, off, repetições)
+ * entram em uma fila e são tocados por um alarme de hardware (alarm pool do
+ * pico_time), que liga/desliga o PWM nas bordas de cada ciclo. Quem chama
+ * recebe o controle de volta imediatamente.
+ *
+ * - Padrões finitos são tocados em ordem, um após o outro.
+ * - Um padrão com BUZZER_REPEAT_FOREVER é o "fundo": substitui o fundo anterior
+ *   e toca sempre que a fila está vazia. Um padrão finito que chega enquanto
+ *   o fundo toca o interrompe na hora; o fundo recomeça quando a fila esvazia.
+ */
+
+typedef struct {
+    buzzer_pattern_t pattern;
+    uint16_t cycles_left;   // ciclos restantes (padrões finitos)
+    bool in_off_phase;      // true durante a parte OFF do ciclo
+    bool is_background;
+    bool active;
+} buzzer_player_t;
+
+static critical_section_t buzzer_lock;
+static buzzer_pattern_t pattern_queue[BUZZER_QUEUE_LEN];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+static buzzer_pattern_t background;
+static bool background_set = false;
+static buzzer_player_t player;
+// Cada alarme agendado carrega a geração em que foi criado; alarmes de gerações
+// antigas (padrão interrompido) simplesmente terminam ao disparar.
+static uint32_t alarm_generation = 0;
+
+static uint buzzer_slice;
+static uint buzzer_channel;
+static buzzer_tone_t current_tone; // tom configurado no PWM (wrap 0 = mudo)
+
 /**
- * @brief Inicializa o pino GPIO conectado ao buzzer como saída.
- *        Opcionalmente, pode tocar uma melodia de inicialização.
+ * @brief Calcula o descritor de PWM para uma frequência arbitrária.
+ *
+ * Mesmo cálculo de BUZZER_TONE(), sem laço: duas divisões (divisor de hardware).
+ *
+ * @param freq Frequência do tom em Hz (0 para silêncio).
  */
-void buzzer_init() {
-    gpio_init(BUZZER_PIN_1);
-    gpio_set_dir(BUZZER_PIN_1, GPIO_OUT);
-    gpio_put(BUZZER_PIN_1, 0);
+buzzer_tone_t buzzer_tone(uint freq) {
+    buzzer_tone_t tone = { 0, 0 };
+    if (freq == 0) return tone;
+
+    uint32_t div = (BUZZER_CLK_HZ / freq + 0xFFFFu) >> 16;
+    if (div < 1) div = 1;
+    if (div > 255) div = 255; // Abaixo de ~8 Hz o período satura
+    uint32_t top = (BUZZER_CLK_HZ + div * freq / 2) / (div * freq);
+    if (top > 0x10000u) top = 0x10000u;
+    if (top < 2) top = 2;
+    tone.clk_div = (uint8_t)div;
+    tone.wrap = (uint16_t)(top - 1);
+    return tone;
 }
 
 /**
- * @brief Toca um único tom no buzzer com a frequência e duração especificadas.
- *        Configura o PWM para gerar o tom. Se a duração for maior que 0,
- *        bloqueia a execução durante esse tempo (usar vTaskDelay em contexto FreeRTOS).
- *        Se freq for 0, apenas pausa pela duração_ms (silêncio).
+ * @brief Aplica um tom ao PWM do buzzer (duty de 50%).
  *
- * @param freq Frequência do tom em Hz (0 para silêncio).
- * @param duration_ms Duração do tom em milissegundos (0 para não bloquear,
- *                    apenas configurar o PWM e retornar).
+ * Repetir o tom já configurado não toca no hardware. O slice fica sempre
+ * habilitado; silêncio é nível 0, o que deixa o pino em nível baixo.
  */
-static void play_tone_internal(uint freq, uint duration_ms) {
-    // Se a frequência for 0, representa silêncio.
-    if (freq == 0) {
-        // Se houver duração, pausa (atenção: sleep_ms bloqueia!)
-        if (duration_ms > 0) {
-            // IMPORTANTE: Se esta função for chamada de uma tarefa FreeRTOS,
-            // substituir sleep_ms por vTaskDelay(pdMS_TO_TICKS(duration_ms));
-            sleep_ms(duration_ms);
-        }
-        // Desliga o PWM explicitamente se estava ligado antes
-        uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN_1);
-        pwm_set_enabled(slice_num, false);
-        return; // Retorna após o silêncio
+static void buzzer_pwm_on(buzzer_tone_t tone) {
+    if (tone.wrap == current_tone.wrap && tone.clk_div == current_tone.clk_div) {
+        return;
+    }
+    current_tone = tone;
+    if (tone.wrap == 0) {
+        pwm_set_chan_level(buzzer_slice, buzzer_channel, 0);
+        return;
     }
+    pwm_set_clkdiv_int_frac(buzzer_slice, tone.clk_div, 0);
+    pwm_set_wrap(buzzer_slice, tone.wrap);
+    pwm_set_chan_level(buzzer_slice, buzzer_channel, (tone.wrap + 1) / 2);
+}
 
-    // Configura o pino GPIO para usar a função PWM.
-    gpio_set_function(BUZZER_PIN_1, GPIO_FUNC_PWM);
-    uint slice_num = pwm_gpio_to_slice_num(BUZZER_PIN_1);
-    uint channel = pwm_gpio_to_channel(BUZZER_PIN_1);
-
-    // Calcula os parâmetros do PWM (divisor de clock e valor de wrap)
-    // para gerar a frequência desejada.
-    uint32_t clock = clock_get_hz(clk_sys);
-    uint32_t divider16 = clock * 16 / freq; // Cálculo inicial do divisor (vezes 16)
-    uint32_t wrap_val = 65535; // Valor máximo de wrap inicial
-    uint clk_div = 1; // Divisor de clock inicial
-
-    // Ajusta o divisor de clock se necessário para caber no wrap_val
-    while (divider16 >= 16 * wrap_val && clk_div < 256) {
-        clk_div++;
-        divider16 = clock * 16 / (freq * clk_div);
+static void buzzer_pwm_off() {
+    buzzer_pwm_on((buzzer_tone_t){ 0, 0 });
+}
+
+// Carrega o próximo padrão (fila, depois fundo) e liga o tom. Retorna a duração
+// da parte ON em us, ou 0 se não há nada para tocar. Chamar com buzzer_lock.
+static int64_t player_load_next() {
+    if (queue_count > 0) {
+        player.pattern = pattern_queue[queue_head];
+        queue_head = (queue_head + 1) % BUZZER_QUEUE_LEN;
+        queue_count--;
+        player.is_background = false;
+        player.cycles_left = player.pattern.repeat;
+    } else if (background_set) {
+        player.pattern = background;
+        player.is_background = true;
+        player.cycles_left = 0;
+    } else {
+        player.active = false;
+        buzzer_pwm_off();
+        return 0;
     }
-    if (divider16 < 16) divider16 = 16; // Garante valor mínimo
-    wrap_val = divider16 / 16; // Calcula o valor final de wrap
-
-    // Configura o divisor de clock e o valor de wrap no hardware PWM.
-    pwm_set_clkdiv_int_frac(slice_num, clk_div, 0);
-    pwm_set_wrap(slice_num, wrap_val);
-    // Define o nível do canal para 50% do valor de wrap (duty cycle de 50%).
-    pwm_set_chan_level(slice_num, channel, wrap_val / 2);
-    // Habilita o PWM.
-    pwm_set_enabled(slice_num, true);
-
-    // Se uma duração foi especificada, aguarda esse tempo.
-    if (duration_ms > 0) {
-        // IMPORTANTE: Substituir por vTaskDelay se em contexto FreeRTOS.
-        sleep_ms(duration_ms);
-        // Desabilita o PWM após a duração.
-        pwm_set_enabled(slice_num, false);
+    player.active = true;
+    player.in_off_phase = false;
+    buzzer_pwm_on(player.pattern.tone);
+    // Tom contínuo (fundo sem parte OFF) não precisa de alarme
+    if (player.is_background && player.pattern.off_ms == 0) {
+        return 0;
+    }
+    return (int64_t)player.pattern.on_ms * 1000;
+}
+
+// Alarme das bordas ON/OFF. Retorno negativo reagenda relativo ao horário
+// previsto do disparo anterior, então o ritmo não acumula atraso.
+static int64_t buzzer_alarm_callback(alarm_id_t id, void *user_data) {
+    int64_t next_us = 0;
+    critical_section_enter_blocking(&buzzer_lock);
+    if ((uint32_t)(uintptr_t)user_data != alarm_generation || !player.active) {
+        critical_section_exit(&buzzer_lock);
+        return 0;
+    }
+
+    if (!player.in_off_phase && player.pattern.off_ms > 0) {
+        // Fim da parte ON: silêncio até o fim do ciclo
+        buzzer_pwm_off();
+        player.in_off_phase = true;
+        next_us = (int64_t)player.pattern.off_ms * 1000;
+    } else if (player.is_background ? queue_count == 0 : --player.cycles_left > 0) {
+        // Fim do ciclo: repete o mesmo padrão
+        player.in_off_phase = false;
+        buzzer_pwm_on(player.pattern.tone);
+        next_us = (int64_t)player.pattern.on_ms * 1000;
+    } else {
+        next_us = player_load_next();
+    }
+    critical_section_exit(&buzzer_lock);
+    return -next_us;
+}
+
+// Reinicia o sequenciador a partir do próximo padrão. Chamar com buzzer_lock.
+static void player_restart() {
+    alarm_generation++;
+    int64_t on_us = player_load_next();
+    if (on_us > 0 &&
+        add_alarm_in_us(on_us, buzzer_alarm_callback, (void *)(uintptr_t)alarm_generation, true) < 0) {
+        // Sem alarme livre ninguém desligaria o tom: cala e deixa o sequenciador
+        // parado; o próximo pedido recomeça pelo que ficou na fila
+        player.active = false;
+        buzzer_pwm_off();
     }
-    // Se duration_ms for 0, o PWM permanece habilitado e a função retorna.
-    // O chamador é responsável por desabilitá-lo depois, se necessário.
 }
 
 /**
- * @brief Toca um único tom no buzzer.
+ * @brief Inicializa o pino GPIO conectado ao buzzer e o sequenciador.
+ */
+void buzzer_init() {
+    // O pino fica no PWM desde o início; tons só mexem em divisor/wrap/nível.
+    gpio_set_function(BUZZER_PIN_1, GPIO_FUNC_PWM);
+    buzzer_slice = pwm_gpio_to_slice_num(BUZZER_PIN_1);
+    buzzer_channel = pwm_gpio_to_channel(BUZZER_PIN_1);
+    pwm_set_chan_level(buzzer_slice, buzzer_channel, 0);
+    pwm_set_enabled(buzzer_slice, true);
+    critical_section_init(&buzzer_lock);
+}
+
+/**
+ * @brief Coloca um padrão de tom na fila do sequenciador, sem bloquear.
+ *
+ * @param tone Descritor do tom (BUZZER_TONE() ou buzzer_tone()); wrap 0 = pausa.
+ * @param on_ms Duração da parte com som de cada ciclo.
+ * @param off_ms Duração da parte em silêncio de cada ciclo.
+ * @param repeat Número de ciclos, ou BUZZER_REPEAT_FOREVER para o padrão de fundo.
+ * @return false se a fila de padrões finitos estiver cheia.
+ */
+bool buzzer_play_tone_pattern(buzzer_tone_t tone, uint on_ms, uint off_ms, uint repeat) {
+    buzzer_pattern_t pattern = { tone, on_ms, off_ms, repeat };
+    bool queued = true;
+
+    critical_section_enter_blocking(&buzzer_lock);
+    if (repeat == BUZZER_REPEAT_FOREVER) {
+        background = pattern;
+        background_set = true;
+        // Novo fundo entra na hora, a menos que um padrão finito esteja tocando
+        if (!player.active || player.is_background) {
+            player_restart();
+        }
+    } else if (queue_count == BUZZER_QUEUE_LEN || on_ms == 0) {
+        queued = false;
+    } else {
+        pattern_queue[(queue_head + queue_count) % BUZZER_QUEUE_LEN] = pattern;
+        queue_count++;
+        // Interrompe o fundo (ou acorda o sequenciador parado)
+        if (!player.active || player.is_background) {
+            player_restart();
+        }
+    }
+    critical_section_exit(&buzzer_lock);
+    return queued;
+}
+
+/**
+ * @brief Como buzzer_play_tone_pattern(), com a frequência em Hz.
+ */
+bool buzzer_play_pattern(uint freq, uint on_ms, uint off_ms, uint repeat) {
+    return buzzer_play_tone_pattern(buzzer_tone(freq), on_ms, off_ms, repeat);
+}
+
+/**
+ * @brief Para o som e descarta a fila e o padrão de fundo.
+ */
+void buzzer_stop() {
+    critical_section_enter_blocking(&buzzer_lock);
+    queue_count = 0;
+    background_set = false;
+    player_restart();
+    critical_section_exit(&buzzer_lock);
+}
+
+/**
+ * @brief Toca um único tom no buzzer, sem bloquear.
  *
- * @param freq Frequência do tom em Hz (0 para desligar o PWM).
- * @param duration_ms Duração em milissegundos.
+ * @param freq Frequência do tom em Hz (0 para desligar).
+ * @param duration_ms Duração em milissegundos. Com 0, o tom fica contínuo
+ *                    (como padrão de fundo) até ser substituído ou parado.
  */
 void buzzer_play_tone(uint freq, uint duration_ms) {
-    // Chama a função interna que lida com a lógica do PWM.
-    // A função interna já trata freq=0 e duration_ms=0/ >0.
-    play_tone_internal(freq, duration_ms);
-}
\ No newline at end of file
+    if (duration_ms > 0) {
+        buzzer_play_pattern(freq, duration_ms, 0, 1);
+    } else if (freq > 0) {
+        buzzer_play_pattern(freq, 1, 0, BUZZER_REPEAT_FOREVER);
+    } else {
+        buzzer_stop();
+    }
+}
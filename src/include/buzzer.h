@@ -2,8 +2,52 @@
 #define BUZZER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+
+#ifndef SYS_CLK_KHZ
+#define SYS_CLK_KHZ 125000
+#endif
+#define BUZZER_CLK_HZ ((uint32_t)SYS_CLK_KHZ * 1000u)
+
+/**
+ * @brief Configuração de PWM de um tom: divisor inteiro e wrap (wrap 0 = silêncio).
+ *
+ * O divisor é o menor que faz o período caber em 16 bits (melhor resolução) e o
+ * wrap é arredondado para o contador mais próximo da frequência pedida.
+ */
+typedef struct {
+    uint16_t wrap;
+    uint8_t clk_div;
+} buzzer_tone_t;
+
+#define BUZZER_TONE_F(f)   ((uint32_t)((f) ? (f) : 1))
+#define BUZZER_TONE_DIV(f) ((BUZZER_CLK_HZ / BUZZER_TONE_F(f) + 0xFFFFu) >> 16)
+#define BUZZER_TONE_TOP(f) ((BUZZER_CLK_HZ + BUZZER_TONE_DIV(f) * BUZZER_TONE_F(f) / 2) \
+                            / (BUZZER_TONE_DIV(f) * BUZZER_TONE_F(f)) - 1)
+
+// Descritor calculado em tempo de compilação (f constante, entre ~8 Hz e 20 kHz)
+#define BUZZER_TONE(f) ((buzzer_tone_t){ .wrap = (f) ? BUZZER_TONE_TOP(f) : 0, \
+                                         .clk_div = (f) ? BUZZER_TONE_DIV(f) : 0 })
+
+#define BUZZER_REPEAT_FOREVER 0 // padrão de fundo, repete até ser substituído
+#define BUZZER_QUEUE_LEN      8 // padrões finitos aguardando na fila
+
+/**
+ * @brief Padrão de tom: repeat ciclos de on_ms com som seguidos de off_ms em silêncio.
+ */
+typedef struct {
+    buzzer_tone_t tone; // wrap 0 = pausa
+    uint16_t on_ms;
+    uint16_t off_ms;
+    uint16_t repeat;  // ciclos, ou BUZZER_REPEAT_FOREVER
+} buzzer_pattern_t;
 
 void buzzer_init();
+buzzer_tone_t buzzer_tone(uint freq);
+bool buzzer_play_tone_pattern(buzzer_tone_t tone, uint on_ms, uint off_ms, uint repeat);
+bool buzzer_play_pattern(uint freq, uint on_ms, uint off_ms, uint repeat);
+void buzzer_stop();
 void buzzer_play_tone(uint freq, uint duration_ms);
 
 #endif // BUZZER_H
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <string.h>
 #include "FreeRTOS.h"
 #include "task.h"
+#include "event_groups.h"
 #include <stdbool.h>
 #include "FreeRTOSConfig.h" 
 #include "buttons.h"
@@ -23,6 +24,16 @@
 #define BUTTON_A_PIN    5 // troca de modo
 #define BUTTON_B_PIN    6 
 
+// gestos dos botões (ver buttons.c)
+#define BUTTON_A_GESTURES          (BUTTON_GESTURE_PRESS) // só toque: a troca de modo sai já na borda
+// B é o botão público da travessia: só toque, para a chamada ser registrada e
+// confirmada já na borda (sem toque longo nem duplo; as estatísticas e o
+// reinício no bootloader ficam no console, comandos "stats" e "bootloader")
+#define BUTTON_B_GESTURES          (BUTTON_GESTURE_PRESS)
+#define BUTTON_LONG_PRESS_MS       1000
+#define BUTTON_DOUBLE_PRESS_MS     300 // janela para o segundo toque (atrasa o toque simples)
+#define BUTTON_EDGE_QUEUE_LEN      16
+
 // Buzzer
 #define BUZZER_PIN_1 10
 #define BUZZER_PIN_2 21
@@ -31,6 +42,8 @@
 #define MATRIX_WS2812_PIN 7
 #define MATRIX_SIZE       25
 #define MATRIX_DIM        5
+#define MATRIX_WORD_TIME_US 30 // 24 bits a 800 kHz
+#define MATRIX_LATCH_US     50 // tempo mínimo em nível baixo para o latch (reset)
 
 // Display
 #define I2C_PORT i2c1
@@ -39,7 +52,17 @@
 #define DISPLAY_ADDR 0x3C
 #define DISPLAY_WIDTH   128
 #define DISPLAY_HEIGHT  64
+// Cache de telas pré-renderizadas: 1 = troca de tela é uma cópia (~4,5 KB de RAM),
+// 0 = cada tela é desenhada a partir do texto na hora (sem RAM extra)
+#define DISPLAY_FRAME_CACHE      1
+#define DISPLAY_CACHE_MAX_PAGES  32 // páginas de 128 bytes reservadas para as telas
+
 
+// Plano de sinalização executado pelo controle (tabelas em signal_plan.c).
+// Pode vir de fora, ex.: -DSIGNAL_PLAN=signal_plan_nema8
+#ifndef SIGNAL_PLAN
+#define SIGNAL_PLAN signal_plan_pedestrian
+#endif
 
 // --- Tempos definidos (ms) conforme solicitado no enunciado ---
 // modo normal
@@ -50,6 +73,41 @@
 #define TIME_PEDS_FLASH_MS         3000
 #define TIME_PEDS_FLASH_INTERVAL_MS 500
 
+// modo atuado: a travessia só é servida com chamada (botão B); sem chamada o
+// verde veicular descansa, e uma chamada o encerra assim que cumprir o mínimo
+#ifndef SIGNAL_ACTUATED
+#define SIGNAL_ACTUATED            0
+#endif
+#define PED_CALL_MIN_GREEN_MS      4000 // espera máxima = este mínimo + amarelo + vermelho geral
+
+// tempos adaptativos (Webster): verdes e travessias recalculados a cada ciclo
+// pela demanda medida; amarelo, vermelho geral e limpeza continuam os da tabela
+#ifndef SIGNAL_ADAPTIVE
+#define SIGNAL_ADAPTIVE            0
+#endif
+#define ADAPTIVE_MIN_GREEN_MS      5000  // verde veicular mínimo de segurança
+#define ADAPTIVE_MIN_WALK_MS       4000  // travessia mínima (tempo para começar a atravessar)
+#define ADAPTIVE_MAX_GREEN_MS      30000
+#define ADAPTIVE_CYCLE_MIN_MS      20000
+#define ADAPTIVE_CYCLE_MAX_MS      90000
+#define ADAPTIVE_SAT_FLOW_VEH_PER_H 1800 // fluxo de saturação: 1 veículo a cada 2 s de verde
+#define ADAPTIVE_SAT_FLOW_PED_PER_H 3600
+#define ADAPTIVE_MAX_FLOW_RATIO_PERMILLE 900 // Y acima disso conta como saturado
+#define ADAPTIVE_FLOW_SMOOTHING_SHIFT 2      // média móvel: peso 1/4 para o último ciclo
+// detector veicular ligado a detector_arrival_from_isr no grupo veicular do plano.
+// Sem ele a demanda veicular não é medida e o modo adaptativo é recusado (daria
+// só o verde mínimo aos veículos); a travessia é medida pelas chamadas do botão B
+#ifndef ADAPTIVE_VEHICLE_DETECTOR
+#define ADAPTIVE_VEHICLE_DETECTOR  0 // a BitDogLab não tem detector
+#endif
+
+// cruzamentos controlados pela tarefa de controle (o 1o é o da placa; os
+// demais só têm a lógica, sem saídas) e a defasagem entre cruzamentos vizinhos
+#ifndef INTERSECTION_COUNT
+#define INTERSECTION_COUNT         1
+#endif
+#define INTERSECTION_OFFSET_MS     3000
+
 // modo noturno
 #define TIME_NIGHT_FLASH_ON_MS     500
 #define TIME_NIGHT_FLASH_OFF_MS    500
@@ -76,14 +134,53 @@
 #define BUZZER_NIGHT_ON_MS       200   // Beep LIGADO um pouco mais longo
 #define BUZZER_NIGHT_OFF_MS      1800  // Pausa DESLIGADO longa (200 + 1800 = 2000ms = 2s)
 
-// --- tempos de delay das tarefas ---
-#define DEBOUNCE_TIME_US           20000
-#define BUTTON_TASK_DELAY_MS       20
-#define DISPLAY_UPDATE_DELAY_MS    250
-#define RGB_LED_TASK_DELAY_MS      50
-#define MATRIX_TASK_DELAY_MS       100
-#define BUZZER_TASK_BASE_DELAY_MS  50
+// Tom do aviso de troca de modo
+#define BUZZER_MODE_FREQ           440
+#define BUZZER_MODE_ON_MS        30
 
+// Confirmação de chamada de pedestre (dois bipes curtos)
+#define BUZZER_CALL_FREQ           880
+#define BUZZER_CALL_ON_MS        60
+#define BUZZER_CALL_OFF_MS       60
+
+// Descritores de PWM calculados em tempo de compilação (divisor/wrap)
+#define BUZZER_WALK_TONE         BUZZER_TONE(BUZZER_WALK_FREQ)
+#define BUZZER_FLASH_TONE        BUZZER_TONE(BUZZER_FLASH_FREQ)
+#define BUZZER_STOP_TONE         BUZZER_TONE(BUZZER_STOP_FREQ)
+#define BUZZER_NIGHT_TONE        BUZZER_TONE(BUZZER_NIGHT_FREQ)
+#define BUZZER_MODE_TONE         BUZZER_TONE(BUZZER_MODE_FREQ)
+#define BUZZER_CALL_TONE         BUZZER_TONE(BUZZER_CALL_FREQ)
+
+// --- tempos de delay das tarefas ---
+#define DEBOUNCE_TIME_US           20000 // bloqueio após uma borda (debounce por software)
+// debounce por integração no PIO1 (0 = interrupção de GPIO + DEBOUNCE_TIME_US)
+#ifndef DEBOUNCE_USE_PIO
+#define DEBOUNCE_USE_PIO           1
+#endif
+// período de amostragem do pino: múltiplo de 3 µs, para o divisor do SM ser
+// inteiro a 125 MHz e o relógio de amostras não derivar do timer
+#define DEBOUNCE_PIO_SAMPLE_US     96
+#define DEBOUNCE_PIO_STABLE_SAMPLES 52 // amostras iguais seguidas para aceitar a borda (~5 ms)
+#define DEBOUNCER_MAX_CHANNELS     4   // SMs do PIO1
+#define DISPLAY_REFRESH_FALLBACK_MS 5000 // redesenho de segurança quando não há eventos
+#define DISPLAY_FLUSH_TIMEOUT_MS   100 // limite de espera pelo fim do envio via DMA
+#define STATS_STREAM_DEFAULT_MS    0   // período do quadro binário de estatísticas (0 = desligado)
+#define CONSOLE_LINE_MAX           32
+#define TRACE_ENABLED              1   // anéis de trace binário (0 remove as chamadas)
+#define TRACE_DRAIN_PERIOD_MS      100 // período do dreno dos anéis para a serial
+
+
+// assinantes das mudanças de estado/modo (um bit do event group por tarefa)
+#define STATE_EVENT_CONTROL        (1u << 0)
+#define STATE_EVENT_RGB_LED        (1u << 1)
+#define STATE_EVENT_MATRIX         (1u << 2)
+#define STATE_EVENT_BUZZER         (1u << 3)
+#define STATE_EVENT_DISPLAY        (1u << 4)
+#define STATE_EVENT_ALL            (STATE_EVENT_CONTROL | STATE_EVENT_RGB_LED | STATE_EVENT_MATRIX | \
+                                    STATE_EVENT_BUZZER | STATE_EVENT_DISPLAY)
+
+// eventos da tarefa do display (bits da notificação da tarefa)
+#define DISPLAY_EVENT_FLUSH_DONE    (1u << 1)
 
 // prioridades
 #define PRIORIDADE_CONTROLLER     (tskIDLE_PRIORITY + 4)
@@ -92,11 +189,19 @@
 #define PRIORIDADE_MATRIX         (tskIDLE_PRIORITY + 2)
 #define PRIORIDADE_BUZZER         (tskIDLE_PRIORITY + 1)
 #define PRIORIDADE_DISPLAY        (tskIDLE_PRIORITY + 0)
+#define PRIORIDADE_CONSOLE        (tskIDLE_PRIORITY + 0)
+#define PRIORIDADE_TRACE          (tskIDLE_PRIORITY + 0)
+
+// afinidade por núcleo (só tem efeito no build SMP, TRAFFIC_SMP=1)
+#define CORE_MASK_CONTROL         (1u << 0) // controle e botões: decidem o tempo das fases
+#define CORE_MASK_RENDER          (1u << 1) // LED RGB, matriz, buzzer e display
+#define CORE_MASK_ANY             (CORE_MASK_CONTROL | CORE_MASK_RENDER) // console e trace
 
 //tamanho das stacks
 #define STACK_MULTIPLIER_DEFAULT  2
 #define STACK_MULTIPLIER_DISPLAY  4
 #define STACK_SIZE_DEFAULT        (configMINIMAL_STACK_SIZE * STACK_MULTIPLIER_DEFAULT)
 #define STACK_SIZE_DISPLAY        (configMINIMAL_STACK_SIZE * STACK_MULTIPLIER_DISPLAY)
+#define STACK_SIZE_CONSOLE        (configMINIMAL_STACK_SIZE * STACK_MULTIPLIER_DISPLAY)
 
 #endif // HARDWARE_CONFIG_H
\ No newline at end of file
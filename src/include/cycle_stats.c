@@ -0,0 +1,83 @@
+#include "cycle_stats.h"
+#include "pico/stdlib.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Medição da deriva do controle. Cada fronteira de fase tem um prazo absoluto
+ * (base + soma das durações, em ticks); o controle informa o prazo logo ao
+ * acordar e aqui ele é comparado com time_us_64(). O atraso de cada fronteira
+ * é latência de escalonamento; o que importa para coordenação é que ele não
+ * se acumule de um ciclo para o outro.
+ */
+
+static cycle_stats_t stats;
+static uint64_t scheduled_us;       // prazo da última fronteira, em us na base de time_us_64
+static TickType_t last_tick;        // prazo da última fronteira, em ticks
+static bool cycle_open;             // já houve um início de ciclo desde a base
+static int64_t cycle_start_lateness_us;
+
+/**
+ * @brief Inicia uma nova base de tempo (partida ou volta do modo noturno).
+ *        Deve ser chamada logo depois de ler o tick que serve de base.
+ */
+void cycle_stats_rebase(TickType_t base_tick) {
+    taskENTER_CRITICAL();
+    memset(&stats, 0, sizeof(stats));
+    scheduled_us = time_us_64();
+    last_tick = base_tick;
+    cycle_open = false;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Registra uma fronteira de fase. Chamada pelo controle ao acordar,
+ *        com o prazo absoluto em que deveria ter acordado.
+ * @param cycle_start true se a fase que começa abre um novo ciclo.
+ */
+void cycle_stats_boundary(TickType_t boundary_tick, bool cycle_start) {
+    uint64_t now = time_us_64();
+
+    taskENTER_CRITICAL();
+    // Diferença em ticks sem sinal: continua certa quando o contador dá a volta
+    scheduled_us += (uint64_t)(TickType_t)(boundary_tick - last_tick) * portTICK_PERIOD_MS * 1000u;
+    last_tick = boundary_tick;
+    int64_t lateness_us = (int64_t)(now - scheduled_us);
+    if (lateness_us > (int64_t)stats.lateness_max_us) {
+        stats.lateness_max_us = (uint32_t)lateness_us;
+    }
+
+    if (cycle_start) {
+        if (cycle_open) {
+            // Erro deste ciclo = variação do atraso entre dois inícios consecutivos
+            int32_t error_us = (int32_t)(lateness_us - cycle_start_lateness_us);
+            if (stats.cycles == 0 || error_us < stats.jitter_min_us) stats.jitter_min_us = error_us;
+            if (stats.cycles == 0 || error_us > stats.jitter_max_us) stats.jitter_max_us = error_us;
+            stats.jitter_abs_sum_us += (uint64_t)(error_us < 0 ? -error_us : error_us);
+            stats.drift_us += error_us;
+            stats.cycles++;
+        }
+        cycle_start_lateness_us = lateness_us;
+        cycle_open = true;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void cycle_stats_get(cycle_stats_t *out) {
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Imprime ciclos medidos, deriva acumulada, jitter por ciclo e o maior atraso de fronteira.
+ */
+void cycle_stats_print() {
+    cycle_stats_t s;
+    cycle_stats_get(&s);
+    printf("Ciclos: %lu  deriva(us): %ld  jitter(us) min/max/medio: %ld/%ld/%lu  atraso max(us): %lu\n",
+           (unsigned long)s.cycles, (long)s.drift_us, (long)s.jitter_min_us, (long)s.jitter_max_us,
+           (unsigned long)(s.cycles ? s.jitter_abs_sum_us / s.cycles : 0),
+           (unsigned long)s.lateness_max_us);
+}
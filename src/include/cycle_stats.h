@@ -0,0 +1,26 @@
+#ifndef CYCLE_STATS_H
+#define CYCLE_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+
+/**
+ * @brief Precisão do escalonamento das fases em relação à base de tempo absoluta.
+ *        Erro de ciclo = duração medida - duração programada de um ciclo completo.
+ */
+typedef struct {
+    uint32_t cycles;             // ciclos completos medidos desde a última base
+    int32_t drift_us;            // erro acumulado: soma dos erros de ciclo desde a base
+    int32_t jitter_min_us;       // menor erro de ciclo
+    int32_t jitter_max_us;       // maior erro de ciclo
+    uint64_t jitter_abs_sum_us;  // soma dos |erro de ciclo| (média = soma / cycles)
+    uint32_t lateness_max_us;    // maior atraso de uma fronteira de fase em relação ao prazo
+} cycle_stats_t;
+
+void cycle_stats_rebase(TickType_t base_tick);
+void cycle_stats_boundary(TickType_t boundary_tick, bool cycle_start);
+void cycle_stats_get(cycle_stats_t *out);
+void cycle_stats_print();
+
+#endif // CYCLE_STATS_H
@@ -1,5 +1,30 @@
 #include "debouncer.h"
 #include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "config.h"
+#include "trace.h"
+#if DEBOUNCE_USE_PIO
+#include "hardware/pio.h"
+#include "button_debounce.pio.h"
+#endif
+
+/*
+ * Debounce dos botões com duas implementações e a mesma API:
+ *   - PIO (DEBOUNCE_USE_PIO = 1): um SM por pino faz a integração
+ *     (button_debounce.pio) e só bordas limpas chegam ao FIFO RX, então há uma
+ *     interrupção por borda, por mais que o contato oscile; cada palavra traz
+ *     o relógio de amostras do SM, que data a borda;
+ *   - software: interrupção de GPIO em cada borda, inclusive as de oscilação,
+ *     com bloqueio por tempo (check_debounce).
+ * Os contadores de interrupções e de bordas aceitas permitem comparar as duas.
+ */
+
+static uint debounce_pins[DEBOUNCER_MAX_CHANNELS];
+static uint8_t channel_count = 0;
+static debouncer_edge_cb_t edge_cb = NULL;
+static volatile uint32_t irq_count = 0;  // interrupções atendidas
+static volatile uint32_t edge_count = 0; // bordas limpas entregues
 
 bool check_debounce(uint32_t *last_event_time_us, uint32_t debounce_interval_us) {
     uint32_t current_time_us = time_us_32();
@@ -8,4 +33,139 @@ bool check_debounce(uint32_t *last_event_time_us, uint32_t debounce_interval_us)
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
+
+static void deliver(uint8_t channel, bool pressed, uint32_t time_us) {
+    trace_event(TRACE_CTX_ISR, TRACE_EV_BUTTON_EDGE, debounce_pins[channel]);
+    edge_count++;
+    edge_cb(channel, pressed, time_us);
+}
+
+#if DEBOUNCE_USE_PIO
+
+#ifndef SYS_CLK_KHZ
+#define SYS_CLK_KHZ 125000
+#endif
+#if (SYS_CLK_KHZ * DEBOUNCE_PIO_SAMPLE_US) % (1000 * BUTTON_DEBOUNCE_CYCLES_PER_SAMPLE) != 0
+#error "DEBOUNCE_PIO_SAMPLE_US deixa o divisor do SM fracionário: o relógio de amostras derivaria do timer"
+#endif
+
+#define DEBOUNCE_PIO_WORD_MASK 0x7FFFFFFFu // relógio de amostras da palavra: 31 bits
+
+static const PIO debounce_pio = pio1;
+static uint channel_sm[DEBOUNCER_MAX_CHANNELS];
+static uint64_t channel_origin_us[DEBOUNCER_MAX_CHANNELS]; // instante do intervalo 0 do SM
+
+/**
+ * @brief Instante da borda de uma palavra do FIFO: a primeira das N amostras
+ *        estáveis, pelo relógio de amostras do SM (bits 31..1, X = -(m+1) no
+ *        intervalo m da aceitação). A volta dos 31 bits (~57 h) é resolvida pelo
+ *        intervalo atual, calculado do timer; a latência da interrupção não entra.
+ */
+static uint32_t pio_edge_time_us(uint8_t channel, uint32_t word) {
+    uint32_t accepted = ~(word >> 1) & DEBOUNCE_PIO_WORD_MASK;
+    uint64_t now_slot = (time_us_64() - channel_origin_us[channel]) / DEBOUNCE_PIO_SAMPLE_US;
+    // Diferença em 31 bits com sinal: a palavra é sempre de pouco antes de agora
+    int32_t age = (int32_t)(((uint32_t)now_slot - accepted) << 1) >> 1;
+    uint64_t first_stable = now_slot - age - (DEBOUNCE_PIO_STABLE_SAMPLES - 1);
+    return (uint32_t)(channel_origin_us[channel] + first_stable * DEBOUNCE_PIO_SAMPLE_US);
+}
+
+// FIFO RX não vazio em algum SM: bit 0 da palavra = nível novo (0 = apertou)
+static void debouncer_pio_irq_handler() {
+    irq_count++;
+    for (uint8_t channel = 0; channel < channel_count; ++channel) {
+        while (!pio_sm_is_rx_fifo_empty(debounce_pio, channel_sm[channel])) {
+            uint32_t word = pio_sm_get(debounce_pio, channel_sm[channel]);
+            deliver(channel, (word & 1u) == 0, pio_edge_time_us(channel, word));
+        }
+    }
+}
+
+#else
+
+static bool channel_pressed[DEBOUNCER_MAX_CHANNELS];
+static uint32_t last_edge_us[DEBOUNCER_MAX_CHANNELS];
+
+/**
+ * @brief Interrupção de GPIO em cada borda. Descarta bordas que não mudam o
+ *        nível aceito e as que chegam dentro do tempo de debounce.
+ */
+static void debouncer_gpio_irq_callback(uint gpio, uint32_t events) {
+    irq_count++;
+    uint32_t now_us = time_us_32();
+    for (uint8_t channel = 0; channel < channel_count; ++channel) {
+        if (debounce_pins[channel] != gpio) {
+            continue;
+        }
+        // Pull-up: descida = apertou. Com as duas bordas pendentes vale o nível atual
+        bool pressed;
+        if ((events & GPIO_IRQ_EDGE_FALL) && (events & GPIO_IRQ_EDGE_RISE)) {
+            pressed = !gpio_get(gpio);
+        } else {
+            pressed = (events & GPIO_IRQ_EDGE_FALL) != 0;
+        }
+        if (pressed == channel_pressed[channel]) {
+            return;
+        }
+        if (!check_debounce(&last_edge_us[channel], DEBOUNCE_TIME_US)) {
+            trace_event(TRACE_CTX_ISR, TRACE_EV_DEBOUNCE_REJECT, gpio);
+            return;
+        }
+        channel_pressed[channel] = pressed;
+        deliver(channel, pressed, now_us);
+        return;
+    }
+}
+
+#endif
+
+/**
+ * @brief Configura os pinos (entrada com pull-up) e inicia o debounce.
+ *        on_edge é chamada em contexto de interrupção a cada borda limpa.
+ */
+void debouncer_init(const uint *pins, uint8_t count, debouncer_edge_cb_t on_edge) {
+    configASSERT(count <= DEBOUNCER_MAX_CHANNELS);
+    edge_cb = on_edge;
+    channel_count = count;
+    for (uint8_t channel = 0; channel < count; ++channel) {
+        debounce_pins[channel] = pins[channel];
+        gpio_init(pins[channel]);
+        gpio_set_dir(pins[channel], GPIO_IN);
+        gpio_pull_up(pins[channel]);
+    }
+
+#if DEBOUNCE_USE_PIO
+    uint offset = pio_add_program(debounce_pio, &button_debounce_program);
+    for (uint8_t channel = 0; channel < count; ++channel) {
+        channel_sm[channel] = (uint)pio_claim_unused_sm(debounce_pio, true);
+        uint64_t start_us = button_debounce_program_init(debounce_pio, channel_sm[channel], offset, pins[channel],
+                                                         DEBOUNCE_PIO_SAMPLE_US, DEBOUNCE_PIO_STABLE_SAMPLES);
+        channel_origin_us[channel] = start_us + BUTTON_DEBOUNCE_PROLOGUE_CYCLES * DEBOUNCE_PIO_SAMPLE_US
+                                                / BUTTON_DEBOUNCE_CYCLES_PER_SAMPLE;
+        pio_set_irq0_source_enabled(debounce_pio,
+                                    pio_get_rx_fifo_not_empty_interrupt_source(channel_sm[channel]), true);
+    }
+    irq_set_exclusive_handler(PIO1_IRQ_0, debouncer_pio_irq_handler);
+    irq_set_enabled(PIO1_IRQ_0, true);
+#else
+    for (uint8_t channel = 0; channel < count; ++channel) {
+        gpio_set_irq_enabled_with_callback(pins[channel], GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE,
+                                           true, &debouncer_gpio_irq_callback);
+    }
+#endif
+}
+
+/**
+ * @brief Interrupções de botão atendidas desde o boot (inclui as de oscilação no modo software).
+ */
+uint32_t debouncer_irq_count() {
+    return irq_count;
+}
+
+/**
+ * @brief Bordas limpas entregues desde o boot.
+ */
+uint32_t debouncer_edge_count() {
+    return edge_count;
+}
@@ -3,7 +3,19 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "pico/stdlib.h"
 
+/**
+ * @brief Borda limpa de um canal (índice em `pins` de debouncer_init).
+ *        Chamada em contexto de interrupção; time_us é o instante da borda
+ *        (time_us_32): no PIO, a primeira amostra estável pelo relógio de
+ *        amostras do SM; no software, a hora da interrupção de GPIO.
+ */
+typedef void (*debouncer_edge_cb_t)(uint8_t channel, bool pressed, uint32_t time_us);
+
+void debouncer_init(const uint *pins, uint8_t count, debouncer_edge_cb_t on_edge);
+uint32_t debouncer_irq_count();
+uint32_t debouncer_edge_count();
 bool check_debounce(uint32_t *last_event_time_us, uint32_t debounce_interval_us);
 
-#endif // DEBOUNCER_H
\ No newline at end of file
+#endif // DEBOUNCER_H
@@ -1,5 +1,6 @@
 #include "display.h"
 #include "config.h"
+#include "lib/ssd1306/ssd1306_dma.h"
 #include <string.h>
 #include <stdio.h>
 #include "pico/stdlib.h"
@@ -11,6 +12,29 @@
 #define ICON_LIGHT_SQUARE    10
 #define ICON_LIGHT_PAD        2
 
+// Telas de estado: uma por passo do plano (o modo noturno é o passo noturno)
+#define SCREEN_COUNT          SIGNAL_MAX_STEPS
+#define FRAME_BYTES           (WIDTH * SSD1306_MAX_PAGES)
+
+#if DISPLAY_FRAME_CACHE
+/*
+ * Cache das telas de estado. Todas compartilham a moldura e a divisória
+ * (quadro base); cada tela guarda só as páginas que diferem da base, em
+ * sequência no pool, com um bit por página em page_mask.
+ */
+typedef struct {
+    uint8_t page_mask;   // Páginas guardadas (bit n = página n)
+    uint16_t offset;     // Início das páginas da tela em cache_pool
+    bool valid;          // false se a tela não coube no pool
+} cached_screen_t;
+
+static uint8_t base_frame[FRAME_BYTES];
+static uint8_t cache_pool[DISPLAY_CACHE_MAX_PAGES * WIDTH];
+static cached_screen_t cached_screens[SCREEN_COUNT];
+#endif
+
+static const signal_plan_t *screen_plan; // plano cujos textos estão nas telas
+
 /**
   * @brief Desenha um ícone de semáforo no display OLED.
   *
@@ -36,6 +60,137 @@
     ssd1306_rect(ssd, light_y_coord, luz_amarela_x_coord, ICON_LIGHT_SQUARE, ICON_LIGHT_SQUARE, true, false);
     ssd1306_rect(ssd, light_y_coord, luz_verde_x_coord, ICON_LIGHT_SQUARE, ICON_LIGHT_SQUARE, true, false);
 }
+/**
+  * @brief Desenha a moldura e a divisória comuns às telas de estado.
+  */
+ static void draw_state_frame(ssd1306_t *ssd) {
+    ssd1306_fill(ssd, false);
+    ssd1306_rect(ssd, 0, 0, 127, 63, true, 0);
+    ssd1306_hline(ssd, 1, 126, 31, true);
+}
+
+/**
+  * @brief Converte modo/passo no índice da tela correspondente.
+  */
+ static uint8_t screen_index(bool night_mode, uint8_t step) {
+    if (night_mode || step >= screen_plan->step_count) {
+        return screen_plan->night_step;
+    }
+    return step;
+}
+
+/**
+  * @brief Desenha por completo a tela de uma combinação de modo e estado.
+  *
+  * @param ssd Ponteiro para a estrutura de controle do display SSD1306.
+  * @param screen Índice da tela (passo do plano).
+  */
+ static void render_state_screen(ssd1306_t *ssd, uint8_t screen) {
+    // O texto de cada tela vem da tabela do plano
+    const char *mode_str = (screen == screen_plan->night_step) ? "MODO: NOTURNO" : "MODO: NORMAL ";
+    const char *state_str = screen_plan->steps[screen].text;
+
+    draw_state_frame(ssd);
+    ssd1306_draw_string(ssd, mode_str, 5, 8);
+    ssd1306_draw_string(ssd, state_str, 5, 36);
+}
+
+/**
+  * @brief Pré-renderiza as telas de estado no cache (se DISPLAY_FRAME_CACHE = 1).
+  *        Cada tela é desenhada uma vez e comparada página a página com o
+  *        quadro base; só as páginas diferentes vão para o pool. Telas que não
+  *        couberem no pool continuam sendo desenhadas na hora.
+  *        Deve ser chamada antes das tarefas, com o display livre.
+  *
+  * @param ssd Ponteiro para a estrutura de controle do display SSD1306.
+  * @param plan Plano de sinalização cujos passos viram telas.
+  */
+ void display_frame_cache_init(ssd1306_t *ssd, const signal_plan_t *plan) {
+    screen_plan = plan;
+#if DISPLAY_FRAME_CACHE
+    uint8_t *frame = ssd->ram_buffer + 1;
+    uint16_t used_pages = 0;
+
+    draw_state_frame(ssd);
+    memcpy(base_frame, frame, FRAME_BYTES);
+
+    for (uint8_t screen = 0; screen < plan->step_count; ++screen) {
+        cached_screen_t *entry = &cached_screens[screen];
+        render_state_screen(ssd, screen);
+
+        // Descobre as páginas que diferem da base (layout coluna a coluna)
+        uint8_t mask = 0;
+        for (uint8_t page = 0; page < ssd->pages; ++page) {
+            for (uint8_t x = 0; x < ssd->width; ++x) {
+                uint16_t index = (x << 3) + page;
+                if (frame[index] != base_frame[index]) {
+                    mask |= 1u << page;
+                    break;
+                }
+            }
+        }
+
+        uint8_t count = __builtin_popcount(mask);
+        entry->valid = (used_pages + count) <= DISPLAY_CACHE_MAX_PAGES;
+        if (!entry->valid) {
+            continue;
+        }
+        entry->page_mask = mask;
+        entry->offset = used_pages * WIDTH;
+        uint8_t *dst = &cache_pool[entry->offset];
+        for (uint8_t page = 0; page < ssd->pages; ++page) {
+            if (mask & (1u << page)) {
+                for (uint8_t x = 0; x < ssd->width; ++x) {
+                    *dst++ = frame[(x << 3) + page];
+                }
+            }
+        }
+        used_pages += count;
+    }
+
+    ssd1306_fill(ssd, false);
+    printf("Cache de telas: %u telas, %u paginas, RAM %u bytes (base %u + pool %u de %u)\n",
+           plan->step_count, used_pages,
+           (unsigned)(sizeof(base_frame) + used_pages * WIDTH + sizeof(cached_screens)),
+           (unsigned)sizeof(base_frame), (unsigned)(used_pages * WIDTH), (unsigned)sizeof(cache_pool));
+#else
+    printf("Cache de telas desabilitado: telas desenhadas a cada mudanca.\n");
+#endif
+}
+
+/**
+  * @brief Coloca no framebuffer a tela do modo/estado informado.
+  *        Com o cache, é uma cópia do quadro base mais as páginas da tela;
+  *        sem ele (ou se a tela não coube no cache), a tela é desenhada.
+  *        O envio fica por conta de ssd1306_flush/ssd1306_flush_async.
+  *
+  * @param ssd Ponteiro para a estrutura de controle do display SSD1306.
+  * @param night_mode true se o modo noturno está ativo.
+  * @param step Passo atual do plano de sinalização.
+  */
+ void display_show_state(ssd1306_t *ssd, bool night_mode, uint8_t step) {
+    uint8_t screen = screen_index(night_mode, step);
+#if DISPLAY_FRAME_CACHE
+    const cached_screen_t *entry = &cached_screens[screen];
+    if (entry->valid) {
+        uint8_t *frame = ssd->ram_buffer + 1;
+        const uint8_t *src = &cache_pool[entry->offset];
+        memcpy(frame, base_frame, FRAME_BYTES);
+        for (uint8_t page = 0; page < ssd->pages; ++page) {
+            if (entry->page_mask & (1u << page)) {
+                for (uint8_t x = 0; x < ssd->width; ++x) {
+                    frame[(x << 3) + page] = *src++;
+                }
+            }
+            // O flush recorta contra o que já está no painel
+            ssd1306_mark_dirty(ssd, page, 0, ssd->width - 1);
+        }
+        return;
+    }
+#endif
+    render_state_screen(ssd, screen);
+}
+
 /**
   * @brief Inicializa a comunicação I2C e o display OLED SSD1306.
   *        Configura os pinos SDA e SCL, inicializa o periférico I2C e
@@ -58,6 +213,8 @@
     ssd1306_config(ssd);
     ssd1306_fill(ssd, false);
     ssd1306_send_data(ssd);
+     // Habilita o envio assíncrono (DMA) usado pela tarefa do display
+    ssd1306_dma_init(ssd);
     printf("Display inicializado.\n");
 }
 
@@ -85,10 +242,10 @@
     
     // Desenha o semáforo
     draw_trafficlight(ssd);
-    ssd1306_send_data(ssd);
+    ssd1306_flush(ssd);
     // Mantém a tela visível por um tempo
     sleep_ms(2500);
     // Limpa o display após a tela de inicialização
     ssd1306_fill(ssd, false);
-    ssd1306_send_data(ssd);
+    ssd1306_flush(ssd);
 }
\ No newline at end of file
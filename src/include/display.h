@@ -4,8 +4,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "lib/ssd1306/ssd1306.h" 
+#include "signal_plan.h"
 
 void display_init(ssd1306_t *ssd); 
 void display_startup_screen(ssd1306_t *ssd);
+void display_frame_cache_init(ssd1306_t *ssd, const signal_plan_t *plan);
+void display_show_state(ssd1306_t *ssd, bool night_mode, uint8_t step);
 
 #endif // DISPLAY_H
\ No newline at end of file
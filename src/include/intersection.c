@@ -0,0 +1,232 @@
+#include "intersection.h"
+#include "pico/stdlib.h"
+#include "config.h"
+#include <stdio.h>
+
+/*
+ * Tudo aqui roda na tarefa do escalonador: as instâncias só mudam nela. As
+ * outras tarefas falam com um cruzamento pela chamada de pedestre (com seção
+ * crítica, em ped_call.c) e pelas trocas de modo, que a tarefa aplica com
+ * intersection_set_mode ao acordar.
+ */
+
+// a vem antes de b (ticks com volta)
+static bool tick_before(TickType_t a, TickType_t b) {
+    return (TickType_t)(a - b) > (portMAX_DELAY / 2);
+}
+
+static void heap_place(intersection_scheduler_t *scheduler, uint16_t index, intersection_t *intersection) {
+    scheduler->heap[index] = intersection;
+    intersection->heap_index = index;
+}
+
+static void sift_up(intersection_scheduler_t *scheduler, uint16_t index) {
+    intersection_t *intersection = scheduler->heap[index];
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (!tick_before(intersection->deadline, scheduler->heap[parent]->deadline)) {
+            break;
+        }
+        heap_place(scheduler, index, scheduler->heap[parent]);
+        index = parent;
+    }
+    heap_place(scheduler, index, intersection);
+}
+
+static void sift_down(intersection_scheduler_t *scheduler, uint16_t index) {
+    intersection_t *intersection = scheduler->heap[index];
+    while (true) {
+        uint16_t child = 2 * index + 1;
+        if (child >= scheduler->count) {
+            break;
+        }
+        if (child + 1 < scheduler->count &&
+            tick_before(scheduler->heap[child + 1]->deadline, scheduler->heap[child]->deadline)) {
+            child++;
+        }
+        if (!tick_before(scheduler->heap[child]->deadline, intersection->deadline)) {
+            break;
+        }
+        heap_place(scheduler, index, scheduler->heap[child]);
+        index = child;
+    }
+    heap_place(scheduler, index, intersection);
+}
+
+static void heap_push(intersection_scheduler_t *scheduler, intersection_t *intersection) {
+    configASSERT(intersection->heap_index == INTERSECTION_NOT_QUEUED);
+    configASSERT(scheduler->count < scheduler->capacity);
+    scheduler->heap[scheduler->count] = intersection;
+    sift_up(scheduler, scheduler->count++);
+}
+
+static intersection_t *heap_pop(intersection_scheduler_t *scheduler) {
+    intersection_t *first = scheduler->heap[0];
+    first->heap_index = INTERSECTION_NOT_QUEUED;
+    if (--scheduler->count > 0) {
+        scheduler->heap[0] = scheduler->heap[scheduler->count];
+        sift_down(scheduler, 0);
+    }
+    return first;
+}
+
+static uint32_t step_duration_ms(const intersection_t *intersection, uint8_t step) {
+    if (intersection->timing != NULL) {
+        return adaptive_timing_duration(intersection->timing, step);
+    }
+    return intersection->engine.plan->steps[step].duration_ms;
+}
+
+static void notify(intersection_t *intersection, TickType_t boundary, intersection_event_t event) {
+    if (intersection->output != NULL) {
+        intersection->output(intersection, boundary, event);
+    }
+}
+
+/**
+ * @brief Prepara uma instância parada (fora do heap) para o plano.
+ *        timing pode ser NULL (durações da tabela); output pode ser NULL (sem saídas).
+ */
+void intersection_init(intersection_t *intersection, const signal_plan_t *plan,
+                       adaptive_timing_t *timing, intersection_output_t output) {
+    *intersection = (intersection_t){
+        .timing = timing,
+        .output = output,
+        .heap_index = INTERSECTION_NOT_QUEUED,
+    };
+    signal_engine_start(&intersection->engine, plan);
+    ped_call_init(&intersection->calls);
+}
+
+void intersection_scheduler_init(intersection_scheduler_t *scheduler, intersection_t **storage, uint16_t capacity) {
+    *scheduler = (intersection_scheduler_t){ .heap = storage, .capacity = capacity };
+}
+
+/**
+ * @brief Põe o cruzamento no passo seguro do plano com base de tempo em now.
+ *        offset_ms alonga esse primeiro passo (defasagem entre cruzamentos).
+ */
+void intersection_start(intersection_scheduler_t *scheduler, intersection_t *intersection,
+                        TickType_t now, uint32_t offset_ms) {
+    signal_engine_start(&intersection->engine, intersection->engine.plan);
+    intersection->resting = false;
+    intersection->cycle_begin_valid = false;
+    intersection->step_start = now;
+    intersection->deadline = now + pdMS_TO_TICKS(offset_ms + step_duration_ms(intersection, intersection->engine.step));
+    heap_push(scheduler, intersection);
+    notify(intersection, now, INTERSECTION_EVENT_RESTART);
+}
+
+/**
+ * @brief Aplica o modo pedido. O modo noturno entra na próxima fronteira de
+ *        passo e, ao sair, o cruzamento recomeça do passo seguro. Um verde em
+ *        descanso termina já se chegou chamada, se entrou o modo noturno ou se
+ *        o modo atuado foi desligado.
+ */
+void intersection_set_mode(intersection_scheduler_t *scheduler, intersection_t *intersection,
+                           bool night, bool actuated, TickType_t now) {
+    const signal_plan_t *plan = intersection->engine.plan;
+    intersection->actuated = actuated && signal_plan_actuated(plan);
+    if (night != intersection->night) {
+        intersection->night = night;
+        if (!night && intersection->engine.step == plan->night_step) {
+            intersection_start(scheduler, intersection, now, 0);
+            return;
+        }
+    }
+    if (intersection->resting &&
+        (intersection->night || !intersection->actuated || ped_call_pending(&intersection->calls))) {
+        intersection->resting = false;
+        intersection->deadline = now;
+        heap_push(scheduler, intersection);
+    }
+}
+
+// Prazo vencido: encerra o passo atual na fronteira e agenda o próximo
+// (false: o verde atuado entrou em descanso, sem fronteira)
+static bool finish_step(intersection_scheduler_t *scheduler, intersection_t *intersection) {
+    signal_engine_t *engine = &intersection->engine;
+    const signal_plan_t *plan = engine->plan;
+    TickType_t boundary = intersection->deadline;
+    bool call_pending = ped_call_pending(&intersection->calls);
+
+    // Verde atuado depois do mínimo, sem chamada: sai do heap até set_mode acordá-lo
+    if (intersection->actuated && !intersection->night && engine->step == plan->rest_step && !call_pending) {
+        intersection->resting = true;
+        return false;
+    }
+
+    ped_call_account(&intersection->calls,
+                     signal_plan_indication(plan, engine->step, plan->vehicle_group) == SIGNAL_GREEN,
+                     boundary - intersection->step_start);
+    intersection->step_start = boundary;
+
+    if (intersection->night) {
+        // Fica no passo noturno, fora do heap, até a troca de modo
+        signal_engine_enter_night(engine);
+        notify(intersection, boundary, INTERSECTION_EVENT_NIGHT);
+        return true;
+    }
+
+    // No modo atuado a travessia só entra com chamada registrada
+    signal_engine_advance(engine, !intersection->actuated || call_pending);
+    if (engine->step == plan->call_step) {
+        ped_call_serve(&intersection->calls);
+    }
+    if (signal_engine_current(engine)->cycle_start) {
+        // Ciclo completo: recalcula os verdes do próximo com a demanda medida
+        if (intersection->timing != NULL && intersection->cycle_begin_valid) {
+            adaptive_timing_cycle(intersection->timing, (boundary - intersection->cycle_begin) * portTICK_PERIOD_MS);
+        }
+        intersection->cycle_begin = boundary;
+        intersection->cycle_begin_valid = true;
+    }
+
+    uint32_t duration_ms = (intersection->actuated && engine->step == plan->rest_step)
+                           ? PED_CALL_MIN_GREEN_MS : step_duration_ms(intersection, engine->step);
+    intersection->deadline = boundary + pdMS_TO_TICKS(duration_ms);
+    heap_push(scheduler, intersection);
+    notify(intersection, boundary, INTERSECTION_EVENT_STEP);
+    return true;
+}
+
+/**
+ * @brief Prazo mais próximo entre os cruzamentos no heap.
+ * @return false se nenhum cruzamento tem prazo (todos noturnos ou em descanso).
+ */
+bool intersection_scheduler_next(const intersection_scheduler_t *scheduler, TickType_t *deadline) {
+    if (scheduler->count == 0) {
+        return false;
+    }
+    *deadline = scheduler->heap[0]->deadline;
+    return true;
+}
+
+/**
+ * @brief Encerra todos os passos com prazo até now, na ordem dos prazos.
+ *        Cada fronteira usa o próprio prazo, não now, então atrasos da tarefa
+ *        não se acumulam na base de tempo.
+ */
+void intersection_scheduler_run(intersection_scheduler_t *scheduler, TickType_t now) {
+    uint32_t start_us = time_us_32();
+    uint16_t transitions = 0;
+    while (scheduler->count > 0 && !tick_before(now, scheduler->heap[0]->deadline)) {
+        if (finish_step(scheduler, heap_pop(scheduler))) {
+            transitions++;
+        }
+    }
+    scheduler->transitions += transitions;
+    uint32_t elapsed_us = time_us_32() - start_us;
+    if (elapsed_us > scheduler->run_max_us) {
+        scheduler->run_max_us = elapsed_us;
+    }
+    if (transitions > scheduler->run_max_transitions) {
+        scheduler->run_max_transitions = transitions;
+    }
+}
+
+void intersection_scheduler_print(const intersection_scheduler_t *scheduler) {
+    printf("Cruzamentos: %u com prazo, %lu fronteiras, passada max %lu us (%u fronteiras), %u bytes por cruzamento\n",
+           scheduler->count, (unsigned long)scheduler->transitions, (unsigned long)scheduler->run_max_us,
+           scheduler->run_max_transitions, (unsigned)(sizeof(intersection_t) + sizeof(intersection_t *)));
+}
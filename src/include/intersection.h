@@ -0,0 +1,84 @@
+#ifndef INTERSECTION_H
+#define INTERSECTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "adaptive_timing.h"
+#include "ped_call.h"
+#include "signal_plan.h"
+
+/*
+ * Controle de um cruzamento como instância: posição no plano, prazo do passo,
+ * chamada de pedestre, tempos (tabela ou adaptativos) e as saídas ligadas a
+ * ele. Uma única tarefa avança todas as instâncias pelo escalonador, um heap
+ * mínimo ordenado pelo próximo prazo: cada fronteira de passo custa O(log N),
+ * sem tarefa nem pilha por cruzamento.
+ */
+
+#define INTERSECTION_NOT_QUEUED 0xFFFF // fora do heap: modo noturno ou verde em descanso
+
+/**
+ * @brief O que levou à chamada das saídas.
+ */
+typedef enum {
+    INTERSECTION_EVENT_STEP,    /**< Fronteira normal de passo. */
+    INTERSECTION_EVENT_RESTART, /**< Partida ou volta do modo noturno: nova base de tempo. */
+    INTERSECTION_EVENT_NIGHT,   /**< Entrada no modo noturno. */
+} intersection_event_t;
+
+typedef struct intersection intersection_t;
+
+// Saídas de um cruzamento: chamada a cada mudança de passo, na tarefa do escalonador
+typedef void (*intersection_output_t)(intersection_t *intersection, TickType_t boundary, intersection_event_t event);
+
+struct intersection {
+    signal_engine_t engine;
+    adaptive_timing_t *timing;      // NULL: durações da tabela
+    intersection_output_t output;   // NULL: cruzamento sem saídas na placa
+    ped_call_t calls;
+    TickType_t step_start;          // início do passo atual
+    TickType_t deadline;            // fim do passo atual (prazo absoluto)
+    TickType_t cycle_begin;         // início do ciclo em andamento
+    uint16_t heap_index;            // posição no heap ou INTERSECTION_NOT_QUEUED
+    bool night;
+    bool actuated;
+    bool resting;                   // verde atuado esperando chamada
+    bool cycle_begin_valid;         // o passo seguro não abre ciclo: o primeiro é parcial
+};
+
+/**
+ * @brief Heap mínimo de instâncias pelo prazo (o armazenamento é de quem chama).
+ */
+typedef struct {
+    intersection_t **heap;
+    uint16_t count;
+    uint16_t capacity;
+    uint32_t transitions;           // fronteiras de passo processadas
+    uint32_t run_max_us;            // maior tempo de uma passada do escalonador
+    uint16_t run_max_transitions;   // mais fronteiras vencidas numa mesma passada
+} intersection_scheduler_t;
+
+void intersection_init(intersection_t *intersection, const signal_plan_t *plan,
+                       adaptive_timing_t *timing, intersection_output_t output);
+void intersection_scheduler_init(intersection_scheduler_t *scheduler, intersection_t **storage, uint16_t capacity);
+void intersection_start(intersection_scheduler_t *scheduler, intersection_t *intersection,
+                        TickType_t now, uint32_t offset_ms);
+void intersection_set_mode(intersection_scheduler_t *scheduler, intersection_t *intersection,
+                           bool night, bool actuated, TickType_t now);
+bool intersection_scheduler_next(const intersection_scheduler_t *scheduler, TickType_t *deadline);
+void intersection_scheduler_run(intersection_scheduler_t *scheduler, TickType_t now);
+void intersection_scheduler_print(const intersection_scheduler_t *scheduler);
+
+/*
+ * Implementadas pela aplicação (main.c), que é dona das instâncias: o
+ * cruzamento da placa e o escalonador, para relatórios (ex.: o resumo do traffic_sim).
+ */
+intersection_t *intersection_board(void);
+const intersection_scheduler_t *intersection_scheduler(void);
+
+static inline uint8_t intersection_step(const intersection_t *intersection) {
+    return intersection->engine.step;
+}
+
+#endif // INTERSECTION_H
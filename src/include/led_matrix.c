@@ -1,125 +1,204 @@
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "pico/critical_section.h"
 #include "led_matrix.h"
 #include "config.h"
 #include "pico/stdlib.h"
 #include "led_matrix.pio.h"
-#include <math.h>
+#include "trace.h"
 #include <string.h>
 
 static PIO pio_instance = pio0;
 static uint pio_sm = 0;
-static uint32_t pixel_buffer[MATRIX_SIZE]; 
-
-typedef struct { 
-    float r; 
-    float g; 
-    float b; 
-} ws2812b_color_t;
-
-//define os leds apagados com cor devido o controle de brilho através do pio.
-static const ws2812b_color_t COLOR_BLACK = { 0.0f, 0.0f, 0.0f };
-static const ws2812b_color_t COLOR_RED   = { 0.25f, 0.0f, 0.0f };
-static const ws2812b_color_t COLOR_GREEN = { 0.0f, 0.25f, 0.0f };
-
-//posição real dos leds da matrix na BitDogLab
-static const uint8_t Leds_Matrix_postion[MATRIX_DIM][MATRIX_DIM] = {
-    {   24,    23,    22,    21,    20 }, 
-    {   15,    16,    17,    18,    19 }, 
-    {   14,    13,    12,    11,    10 }, 
-    {    5,     6,     7,     8,     9 }, 
-    {    4,     3,     2,     1,     0 }  
-};
-
-//determinar a posição de cada led para fazer a manipulação
-static inline int posicao_leds(int lin, int col) {
-    if (lin >= 1 && lin <= MATRIX_DIM &&
-        col >= 1 && col <= MATRIX_DIM) {
-        return Leds_Matrix_postion[lin - 1][col - 1];
+static uint32_t pixel_buffer[MATRIX_SIZE];   // quadro sendo desenhado pelas funções abaixo
+static uint32_t pending_frame[MATRIX_SIZE];  // próximo quadro a enviar (copiado em update_matrix)
+static uint32_t tx_frame[MATRIX_SIZE];       // quadro em envio pelo DMA
+
+static int dma_chan = -1;
+static volatile bool frame_busy = false;     // DMA ou latch em andamento
+static volatile bool frame_pending = false;  // pending_frame aguardando o fim do quadro atual
+// Protege frame_busy/frame_pending/pending_frame entre a tarefa da matriz e o
+// alarme do latch. Spinlock: no build SMP a tarefa roda no núcleo 1 e o alarme
+// no núcleo 0, então só desabilitar as interrupções locais não bastaria.
+static critical_section_t frame_lock;
+
+#define ICON_COLOR_Q8       64 // cor base 0.25 (os leds ficam fortes demais em 1.0)
+#define ICON_BRIGHTNESS_Q8  64 // brilho 0.25 usado nos ícones de pedestre
+
+//paleta pré-calculada: palavras prontas para o FIFO do PIO
+static const uint32_t COLOR_BLACK = PIO_GRB(0, 0, 0);
+static const uint32_t COLOR_RED   = PIO_GRB(COLOR_LEVEL(ICON_COLOR_Q8, ICON_BRIGHTNESS_Q8), 0, 0);
+static const uint32_t COLOR_GREEN = PIO_GRB(0, COLOR_LEVEL(ICON_COLOR_Q8, ICON_BRIGHTNESS_Q8), 0);
+static const uint32_t COLOR_AMBER = PIO_GRB(COLOR_LEVEL(ICON_COLOR_Q8, ICON_BRIGHTNESS_Q8),
+                                            COLOR_LEVEL(ICON_COLOR_Q8, ICON_BRIGHTNESS_Q8) / 2, 0);
+
+/*
+ * Posição real dos leds da matriz na BitDogLab (ligação em serpentina):
+ *     {   24,    23,    22,    21,    20 },
+ *     {   15,    16,    17,    18,    19 },
+ *     {   14,    13,    12,    11,    10 },
+ *     {    5,     6,     7,     8,     9 },
+ *     {    4,     3,     2,     1,     0 }
+ * Contando as linhas de baixo para cima, as pares vão da direita para a
+ * esquerda e as ímpares da esquerda para a direita. MATRIX_LED_BIT converte
+ * (linha, coluna) 1-based no bit da posição física, em tempo de compilação.
+ */
+#define MATRIX_LED_INDEX(lin, col) \
+    ((MATRIX_DIM - (lin)) * MATRIX_DIM + \
+     (((MATRIX_DIM - (lin)) & 1) ? ((col) - 1) : (MATRIX_DIM - (col))))
+#define MATRIX_LED_BIT(lin, col) (1u << MATRIX_LED_INDEX(lin, col))
+
+// Sprites: máscaras de 25 bits já na ordem física dos leds
+static const uint32_t SPRITE_PED_WALK =
+    MATRIX_LED_BIT(1, 3) | MATRIX_LED_BIT(1, 5) | MATRIX_LED_BIT(3, 1) |
+    MATRIX_LED_BIT(2, 2) | MATRIX_LED_BIT(2, 3) | MATRIX_LED_BIT(2, 4) |
+    MATRIX_LED_BIT(3, 3) | MATRIX_LED_BIT(4, 3) |
+    MATRIX_LED_BIT(5, 2) | MATRIX_LED_BIT(5, 4);
+
+static const uint32_t SPRITE_PED_STOP =
+    MATRIX_LED_BIT(1, 3) |
+    MATRIX_LED_BIT(2, 2) | MATRIX_LED_BIT(2, 3) | MATRIX_LED_BIT(2, 4) |
+    MATRIX_LED_BIT(3, 3) | MATRIX_LED_BIT(4, 3) |
+    MATRIX_LED_BIT(5, 2) | MATRIX_LED_BIT(5, 4);
+
+// Lâmpada "aguarde" (chamada de pedestre registrada): cantos de baixo, fora dos sprites
+static const uint32_t SPRITE_CALL_LAMP = MATRIX_LED_BIT(5, 1) | MATRIX_LED_BIT(5, 5);
+static uint32_t call_lamp_mask = 0;
+
+// Último sprite publicado, para não reenviar quadros idênticos
+static uint32_t last_sprite_mask = 0;
+static uint32_t last_sprite_color = 0;
+static bool last_sprite_valid = false;
+
+// Inicia o envio de tx_frame: o DMA alimenta o FIFO TX do PIO no ritmo do DREQ
+static void matrix_dma_start() {
+    frame_busy = true;
+    dma_channel_set_read_addr(dma_chan, tx_frame, true);
+}
+
+// Fim do latch (>= 50 us de linha em nível baixo após o último bit)
+static int64_t matrix_latch_done(alarm_id_t id, void *user_data) {
+    critical_section_enter_blocking(&frame_lock);
+    trace_event(TRACE_CTX_ISR, TRACE_EV_MATRIX_LATCH, frame_pending);
+    if (frame_pending) {
+        // Quadro que chegou durante o envio: sai logo em seguida
+        memcpy(tx_frame, pending_frame, sizeof(tx_frame));
+        frame_pending = false;
+        matrix_dma_start();
+    } else {
+        frame_busy = false;
     }
-    return -1;
+    critical_section_exit(&frame_lock);
+    return 0;
 }
 
-// faz as modoficações para definir o brilho como float
-static inline uint32_t color_to_pio_format(ws2812b_color_t color, float brightness) {
-    float r = fmaxf(0.0f, fminf(1.0f, color.r * brightness));
-    float g = fmaxf(0.0f, fminf(1.0f, color.g * brightness));
-    float b = fmaxf(0.0f, fminf(1.0f, color.b * brightness));
-    unsigned char R_val = (unsigned char)(r * 255.0f);
-    unsigned char G_val = (unsigned char)(g * 255.0f);
-    unsigned char B_val = (unsigned char)(b * 255.0f);
-    return ((uint32_t)(G_val) << 24) | ((uint32_t)(R_val) << 16) | ((uint32_t)(B_val) << 8);
+// O DMA terminou de preencher o FIFO; agenda o latch para depois do último bit
+static void matrix_dma_irq_handler() {
+    if (!dma_channel_get_irq0_status(dma_chan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(dma_chan);
+    // Palavras ainda no FIFO + a que está no OSR, cada uma com 24 bits de 1,25 us
+    uint32_t words_left = pio_sm_get_tx_fifo_level(pio_instance, pio_sm) + 1;
+    uint32_t latch_us = words_left * MATRIX_WORD_TIME_US + MATRIX_LATCH_US;
+    if (add_alarm_in_us(latch_us, matrix_latch_done, NULL, true) < 0) {
+        // Sem alarme livre: espera o latch aqui (no máximo ~200 us). Sem isso
+        // frame_busy nunca seria limpo e a matriz pararia de atualizar
+        busy_wait_us(latch_us);
+        matrix_latch_done(0, NULL);
+    }
 }
 
+/*
+ * Publica o conteúdo de pixel_buffer. Não bloqueia: se a matriz estiver livre
+ * o envio começa na hora; se não, o quadro fica pendente e é enviado assim que
+ * o latch do atual terminar (quadros pendentes mais antigos são substituídos).
+ * Chamada só a partir da tarefa da matriz (anel de trace TRACE_CTX_MATRIX).
+ */
 static void update_matrix() {
-    for (int i = 0; i < MATRIX_SIZE; ++i) {
-        pio_sm_put_blocking(pio_instance, pio_sm, pixel_buffer[i]);
+    critical_section_enter_blocking(&frame_lock);
+    trace_event(TRACE_CTX_MATRIX, TRACE_EV_MATRIX_FRAME, frame_busy);
+    if (frame_busy) {
+        memcpy(pending_frame, pixel_buffer, sizeof(pending_frame));
+        frame_pending = true;
+    } else {
+        memcpy(tx_frame, pixel_buffer, sizeof(tx_frame));
+        matrix_dma_start();
     }
-    busy_wait_us(50);
+    critical_section_exit(&frame_lock);
 }
 
-// Helper to set a pixel using PHYSICAL coordinates (1-based row/col)
-static void led_active_position(int lin, int col, uint32_t color) {
-    int logical_index = posicao_leds(lin, col);
-    if (logical_index != -1) {
-        pixel_buffer[logical_index] = color;
+/*
+ * Desenha um sprite (máscara na ordem física) em uma cor e publica o quadro.
+ * Se o quadro resultante for igual ao último publicado, nada é enviado ao PIO.
+ */
+static void show_sprite(uint32_t mask, uint32_t color) {
+    if (color == COLOR_BLACK) {
+        mask = 0; // sprite apagado (só a lâmpada de chamada, se houver, continua)
+    }
+    if (last_sprite_valid && mask == last_sprite_mask && color == last_sprite_color) {
+        return;
     }
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        pixel_buffer[i] = ((mask >> i) & 1u) ? color :
+                          ((call_lamp_mask >> i) & 1u) ? COLOR_AMBER : COLOR_BLACK;
+    }
+    last_sprite_mask = mask;
+    last_sprite_color = color;
+    last_sprite_valid = true;
+    update_matrix();
 }
 
 //inicia a matriz
 void led_matrix_init() {
     uint offset = pio_add_program(pio_instance, &led_matrix_program);
     led_matrix_program_init(pio_instance, pio_sm, offset, MATRIX_WS2812_PIN);
+
+    critical_section_init(&frame_lock);
+
+    // Canal DMA: memória -> FIFO TX do PIO, 32 bits por LED
+    dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pio_instance, pio_sm, true));
+    dma_channel_configure(dma_chan, &cfg, &pio_instance->txf[pio_sm], tx_frame, MATRIX_SIZE, false);
+    dma_channel_set_irq0_enabled(dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_0, matrix_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
     led_matrix_clear();
 }
 
+// true enquanto um quadro está sendo enviado ou no latch
+bool led_matrix_busy() {
+    return frame_busy;
+}
+
+// Acende ou apaga a lâmpada de chamada registrada; vale a partir do próximo sprite
+void led_matrix_set_call_lamp(bool on) {
+    uint32_t mask = on ? SPRITE_CALL_LAMP : 0;
+    if (mask != call_lamp_mask) {
+        call_lamp_mask = mask;
+        last_sprite_valid = false;
+    }
+}
+
 //apaga os leds da matriz
 void led_matrix_clear() {
-    uint32_t pio_black = color_to_pio_format(COLOR_BLACK, 1.0f);
-    for (int i = 0; i < MATRIX_SIZE; ++i) {
-        pixel_buffer[i] = pio_black;
-    }
-    update_matrix();
+    show_sprite(0, COLOR_BLACK);
 }
 
 // Desenha um pedestre andando em cor verde
 void led_matrix_ped_walk() {
-    uint32_t pio_green = color_to_pio_format(COLOR_GREEN, 0.25f);
-    uint32_t pio_black = color_to_pio_format(COLOR_BLACK, 1.0f);
-
-    //apaga antes para evitar erro de cores
-    for (int i = 0; i < MATRIX_SIZE; ++i) { pixel_buffer[i] = pio_black; }
-
-    led_active_position(1, 3, pio_green);
-    led_active_position(3, 1, pio_green);
-    led_active_position(1, 5, pio_green);
-    led_active_position(2, 3, pio_green);
-    led_active_position(3, 3, pio_green);
-    led_active_position(4, 3, pio_green);
-    led_active_position(2, 2, pio_green);
-    led_active_position(2, 4, pio_green);
-    led_active_position(5, 2, pio_green);
-    led_active_position(5, 4, pio_green);
-
-    update_matrix();
+    show_sprite(SPRITE_PED_WALK, COLOR_GREEN);
 }
 
 // Desenha um pedestre parado em vermelho
 void led_matrix_ped_dont_walk(bool flash_state) {
-    uint32_t pio_red = flash_state ? color_to_pio_format(COLOR_RED, 0.25f) : color_to_pio_format(COLOR_BLACK, 1.0f);
-    uint32_t pio_black = color_to_pio_format(COLOR_BLACK, 1.0f);
-    
-    //apaga antes para evitar erro de cores
-    for (int i = 0; i < MATRIX_SIZE; ++i) { pixel_buffer[i] = pio_black; }
-
-    led_active_position(1, 3, pio_red); 
-    led_active_position(2, 3, pio_red); 
-    led_active_position(3, 3, pio_red);
-    led_active_position(4, 3, pio_red); 
-    led_active_position(2, 2, pio_red); 
-    led_active_position(2, 4, pio_red); 
-    led_active_position(5, 2, pio_red); 
-    led_active_position(5, 4, pio_red); 
-
-    update_matrix();
-}
\ No newline at end of file
+    show_sprite(SPRITE_PED_STOP, flash_state ? COLOR_RED : COLOR_BLACK);
+}
@@ -4,9 +4,17 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Monta a palavra no formato do PIO: G-R-B nos 24 bits mais significativos
+#define PIO_GRB(r, g, b) (((uint32_t)(g) << 24) | ((uint32_t)(r) << 16) | ((uint32_t)(b) << 8))
+// Nível de 8 bits de (cor * brilho * 255), com cor e brilho em Q8 (256 = 1.0).
+// Igual, bit a bit, ao antigo cálculo em float truncado para unsigned char.
+#define COLOR_LEVEL(color_q8, brightness_q8) ((uint8_t)(((uint32_t)(color_q8) * (brightness_q8) * 255u) >> 16))
+
 void led_matrix_init();
+bool led_matrix_busy();
 void led_matrix_clear();
 void led_matrix_ped_walk();
 void led_matrix_ped_dont_walk(bool flash_state);
+void led_matrix_set_call_lamp(bool on);
 
 #endif // LED_MATRIX_H
\ No newline at end of file
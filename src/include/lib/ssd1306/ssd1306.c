@@ -1,5 +1,9 @@
 #include "ssd1306.h"
 #include "font.h"
+#include <string.h>
+
+// Buffer de uma janela de página (byte de controle 0x40 + até WIDTH colunas)
+static uint8_t window_buffer[WIDTH + 1];
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->width = width;
@@ -8,8 +12,18 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
   ssd->address = address;
   ssd->i2c_port = i2c;
   ssd->bufsize = ssd->pages * ssd->width + 1;
-  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
+  if (ssd->bufsize > SSD1306_BUFSIZE)
+    panic("ssd1306: %ux%u excede o buffer de %ux%u", width, height, WIDTH, HEIGHT);
+  ssd->ram_buffer = ssd->ram_storage;
+  memset(ssd->ram_buffer, 0, ssd->bufsize);
   ssd->ram_buffer[0] = 0x40;
+  ssd->shadow_buffer = ssd->shadow_storage;
+  memset(ssd->shadow_buffer, 0, ssd->bufsize);
+  ssd->shadow_valid = false;
+  ssd->dirty_pages = 0;
+  ssd->bus = NULL;
+  ssd->async_buffer = ssd->async_storage;
+  ssd->busy = false;
   ssd->port_buffer[0] = 0x80;
 }
 
@@ -52,13 +66,18 @@ void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   );
 }
 
-void ssd1306_send_data(ssd1306_t *ssd) {
+static void ssd1306_set_window(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
   ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
+  ssd1306_command(ssd, x0);
+  ssd1306_command(ssd, x1);
   ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
+  ssd1306_command(ssd, page0);
+  ssd1306_command(ssd, page1);
+}
+
+// Envia o framebuffer inteiro, independente do que foi alterado
+void ssd1306_send_data(ssd1306_t *ssd) {
+  ssd1306_set_window(ssd, 0, ssd->width - 1, 0, ssd->pages - 1);
   i2c_write_blocking(
     ssd->i2c_port,
     ssd->address,
@@ -66,55 +85,267 @@ void ssd1306_send_data(ssd1306_t *ssd) {
     ssd->bufsize,
     false
   );
+  memcpy(ssd->shadow_buffer, ssd->ram_buffer, ssd->bufsize);
+  ssd->shadow_valid = true;
+  ssd->dirty_pages = 0;
+}
+
+// Marca as colunas x0..x1 da página como alteradas
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t page, uint8_t x0, uint8_t x1) {
+  if (page >= ssd->pages || x0 >= ssd->width)
+    return;
+  if (x1 >= ssd->width)
+    x1 = ssd->width - 1;
+  uint8_t bit = 1u << page;
+  if (!(ssd->dirty_pages & bit)) {
+    ssd->dirty_pages |= bit;
+    ssd->dirty_x0[page] = x0;
+    ssd->dirty_x1[page] = x1;
+    return;
+  }
+  if (x0 < ssd->dirty_x0[page])
+    ssd->dirty_x0[page] = x0;
+  if (x1 > ssd->dirty_x1[page])
+    ssd->dirty_x1[page] = x1;
+}
+
+// Recorta a janela suja da página contra o shadow; retorna false se nada mudou
+static bool ssd1306_dirty_window(ssd1306_t *ssd, uint8_t page, uint8_t *x0_out, uint8_t *x1_out) {
+  if (!(ssd->dirty_pages & (1u << page)))
+    return false;
+
+  const uint8_t *ram = ssd->ram_buffer + 1 + page;
+  const uint8_t *shadow = ssd->shadow_buffer + 1 + page;
+  int x0 = ssd->dirty_x0[page];
+  int x1 = ssd->dirty_x1[page];
+  while (x0 <= x1 && ram[x0 << 3] == shadow[x0 << 3])
+    ++x0;
+  while (x1 >= x0 && ram[x1 << 3] == shadow[x1 << 3])
+    --x1;
+  if (x0 > x1)
+    return false;
+
+  *x0_out = x0;
+  *x1_out = x1;
+  return true;
+}
+
+/*
+ * Envia somente as janelas (página x colunas) que mudaram desde o último envio.
+ * A janela marcada como suja é recortada nas pontas comparando com o conteúdo
+ * já enviado, de forma que apagar e redesenhar a mesma tela não gera tráfego.
+ * Retorna o número de bytes transmitidos no barramento (0 se nada mudou).
+ */
+size_t ssd1306_flush(ssd1306_t *ssd) {
+  if (!ssd->shadow_valid) {
+    ssd1306_send_data(ssd);
+    return 6 * sizeof(ssd->port_buffer) + ssd->bufsize;
+  }
+
+  size_t sent = 0;
+  uint8_t x0, x1;
+  for (uint8_t page = 0; page < ssd->pages; ++page) {
+    if (!ssd1306_dirty_window(ssd, page, &x0, &x1))
+      continue;
+
+    // Layout do buffer é coluna a coluna: a página fica espaçada de 8 em 8 bytes
+    const uint8_t *ram = ssd->ram_buffer + 1 + page;
+    uint8_t *shadow = ssd->shadow_buffer + 1 + page;
+    size_t len = 0;
+    window_buffer[len++] = 0x40;
+    for (int x = x0; x <= x1; ++x) {
+      window_buffer[len++] = ram[x << 3];
+      shadow[x << 3] = ram[x << 3];
+    }
+
+    ssd1306_set_window(ssd, x0, x1, page, page);
+    i2c_write_blocking(ssd->i2c_port, ssd->address, window_buffer, len, false);
+    sent += 6 * sizeof(ssd->port_buffer) + len;
+  }
+  ssd->dirty_pages = 0;
+  return sent;
+}
+
+void ssd1306_set_bus(ssd1306_t *ssd, const ssd1306_bus_t *bus) {
+  ssd->bus = bus;
+}
+
+bool ssd1306_busy(ssd1306_t *ssd) {
+  return ssd->busy;
+}
+
+// Codifica uma janela como duas transações I2C no formato IC_DATA_CMD:
+// a sequência de endereçamento (controle 0x00) e os dados (controle 0x40).
+static size_t ssd1306_encode_window(ssd1306_t *ssd, uint16_t *out, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+  size_t n = 0;
+  out[n++] = 0x00;
+  out[n++] = SET_COL_ADDR;
+  out[n++] = x0;
+  out[n++] = x1;
+  out[n++] = SET_PAGE_ADDR;
+  out[n++] = page0;
+  out[n++] = page1 | SSD1306_WORD_STOP;
+  out[n++] = 0x40;
+  for (int x = x0; x <= x1; ++x) {
+    for (int page = page0; page <= page1; ++page) {
+      uint16_t index = (x << 3) + page + 1;
+      out[n++] = ssd->ram_buffer[index];
+      ssd->shadow_buffer[index] = ssd->ram_buffer[index];
+    }
+  }
+  out[n - 1] |= SSD1306_WORD_STOP;
+  return n;
+}
+
+/*
+ * Versão assíncrona de ssd1306_flush: copia as janelas alteradas para o buffer
+ * de transmissão, entrega ao barramento e retorna sem esperar. O framebuffer
+ * pode ser redesenhado logo em seguida. done_cb é chamado uma vez quando o
+ * quadro termina de ser enviado (normalmente a partir de uma interrupção), ou
+ * imediatamente, no contexto de quem chamou, se não havia nada para enviar.
+ * Retorna false, sem alterar nada, se ainda há um quadro em andamento; as
+ * regiões sujas continuam marcadas e entram no próximo envio.
+ */
+bool ssd1306_flush_async(ssd1306_t *ssd, ssd1306_done_cb_t done_cb, void *user_data) {
+  if (!ssd->bus || ssd->busy)
+    return false;
+
+  size_t count = 0;
+  if (!ssd->shadow_valid) {
+    count = ssd1306_encode_window(ssd, ssd->async_buffer, 0, ssd->width - 1, 0, ssd->pages - 1);
+    ssd->shadow_valid = true;
+  } else {
+    uint8_t x0, x1;
+    for (uint8_t page = 0; page < ssd->pages; ++page) {
+      if (ssd1306_dirty_window(ssd, page, &x0, &x1))
+        count += ssd1306_encode_window(ssd, ssd->async_buffer + count, x0, x1, page, page);
+    }
+  }
+  ssd->dirty_pages = 0;
+
+  if (count == 0) {
+    if (done_cb)
+      done_cb(user_data);
+    return true;
+  }
+
+  ssd->done_cb = done_cb;
+  ssd->done_user_data = user_data;
+  ssd->busy = true;
+  if (!ssd->bus->start(ssd->bus->ctx, ssd->async_buffer, count)) {
+    // Barramento recusou: o conteúdo do display é desconhecido, reenvia tudo depois
+    ssd->busy = false;
+    ssd->shadow_valid = false;
+    return false;
+  }
+  return true;
+}
+
+// Chamado pela implementação do barramento ao fim (ou aborto) da transferência
+void ssd1306_transfer_done(ssd1306_t *ssd, bool ok) {
+  if (!ok)
+    ssd->shadow_valid = false;
+  ssd->busy = false;
+  if (ssd->done_cb)
+    ssd->done_cb(ssd->done_user_data);
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
+  if (x >= ssd->width || y >= ssd->height)
+    return;
   uint16_t index = (y >> 3) + (x << 3) + 1;
   uint8_t pixel = (y & 0b111);
+  uint8_t old = ssd->ram_buffer[index];
   if (value)
     ssd->ram_buffer[index] |= (1 << pixel);
   else
     ssd->ram_buffer[index] &= ~(1 << pixel);
+  if (ssd->ram_buffer[index] != old)
+    ssd1306_mark_dirty(ssd, y >> 3, x, x);
 }
 
 /*
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
+ * Núcleo de rasterização por spans. O buffer é organizado coluna a coluna
+ * (índice 1 + x*8 + página), então:
+ *  - um span horizontal é a mesma máscara de bit aplicada a um byte a cada 8;
+ *  - um span vertical é uma sequência de bytes contíguos da mesma coluna,
+ *    com máscaras parciais só na primeira e na última página.
+ * As funções internas assumem coordenadas já recortadas ao display.
+ */
+static inline void ssd1306_apply_mask(uint8_t *byte, uint8_t mask, bool value) {
+  if (value)
+    *byte |= mask;
+  else
+    *byte &= ~mask;
+}
 
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+static void ssd1306_hspan(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
+  uint8_t mask = 1u << (y & 7);
+  uint8_t *byte = ssd->ram_buffer + 1 + (y >> 3) + (x0 << 3);
+  for (int x = x0; x <= x1; ++x, byte += 8)
+    ssd1306_apply_mask(byte, mask, value);
+  ssd1306_mark_dirty(ssd, y >> 3, x0, x1);
 }
 
+static void ssd1306_vspan(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+  uint8_t page0 = y0 >> 3;
+  uint8_t page1 = y1 >> 3;
+  uint8_t first = 0xFF << (y0 & 7);
+  uint8_t last = 0xFF >> (7 - (y1 & 7));
+  uint8_t *column = ssd->ram_buffer + 1 + (x << 3);
+
+  if (page0 == page1) {
+    ssd1306_apply_mask(&column[page0], first & last, value);
+  } else {
+    ssd1306_apply_mask(&column[page0], first, value);
+    for (uint8_t page = page0 + 1; page < page1; ++page)
+      column[page] = value ? 0xFF : 0x00;
+    ssd1306_apply_mask(&column[page1], last, value);
+  }
+  for (uint8_t page = page0; page <= page1; ++page)
+    ssd1306_mark_dirty(ssd, page, x, x);
+}
 
+void ssd1306_fill(ssd1306_t *ssd, bool value) {
+  memset(ssd->ram_buffer + 1, value ? 0xFF : 0x00, ssd->bufsize - 1);
+  for (uint8_t page = 0; page < ssd->pages; ++page)
+    ssd1306_mark_dirty(ssd, page, 0, ssd->width - 1);
+}
 
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
+  if (width == 0 || height == 0 || left >= ssd->width || top >= ssd->height)
+    return;
+  int right = left + width - 1;
+  int bottom = top + height - 1;
+  int x1 = right < ssd->width ? right : ssd->width - 1;
+  int y1 = bottom < ssd->height ? bottom : ssd->height - 1;
 
   if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
+    // Contorno e interior têm a mesma cor: o retângulo vira uma coluna cheia por x
+    for (int x = left; x <= x1; ++x)
+      ssd1306_vspan(ssd, x, top, y1, value);
+    return;
   }
+
+  ssd1306_hspan(ssd, left, x1, top, value);
+  if (bottom == y1)
+    ssd1306_hspan(ssd, left, x1, bottom, value);
+  ssd1306_vspan(ssd, left, top, y1, value);
+  if (right == x1)
+    ssd1306_vspan(ssd, right, top, y1, value);
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    // Linhas retas usam os spans
+    if (y0 == y1) {
+      ssd1306_hline(ssd, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, value);
+      return;
+    }
+    if (x0 == x1) {
+      ssd1306_vline(ssd, x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, value);
+      return;
+    }
+
     int dx = abs(x1 - x0);
     int dy = abs(y1 - y0);
 
@@ -144,16 +375,27 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
 
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  if (y >= ssd->height || x0 >= ssd->width)
+    return;
+  if (x1 >= ssd->width)
+    x1 = ssd->width - 1;
+  if (x0 <= x1)
+    ssd1306_hspan(ssd, x0, x1, y, value);
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  if (x >= ssd->width || y0 >= ssd->height)
+    return;
+  if (y1 >= ssd->height)
+    y1 = ssd->height - 1;
+  if (y0 <= y1)
+    ssd1306_vspan(ssd, x, y0, y1, value);
 }
 
 // Função para desenhar um caractere
+// A fonte já é armazenada coluna a coluna (bit j = linha j), igual às páginas do
+// SSD1306: com y alinhado a 8 cada coluna do glifo é um único byte; fora do
+// alinhamento, cada coluna se divide entre duas páginas com deslocamento e máscara.
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
 {
   uint16_t index = 0;
@@ -169,15 +411,38 @@ void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
     index = 0; // Índice 0 corresponde ao caractere "nada" (espaço)
   }
 
-  // Desenha o caractere na tela
-  for (uint8_t i = 0; i < 8; ++i)
+  if (x >= ssd->width || y >= ssd->height)
+    return;
+
+  // Recorta na borda direita
+  uint8_t columns = (ssd->width - x < 8) ? ssd->width - x : 8;
+  const uint8_t *glyph = &font[index];
+  uint8_t page = y >> 3;
+  uint8_t shift = y & 7;
+  uint8_t *dst = ssd->ram_buffer + 1 + (x << 3) + page;
+
+  if (shift == 0)
+  {
+    for (uint8_t i = 0; i < columns; ++i)
+      dst[i << 3] = glyph[i];
+  }
+  else
   {
-    uint8_t line = font[index + i]; // Acessa a linha correspondente do caractere na fonte
-    for (uint8_t j = 0; j < 8; ++j)
+    // Bits da página inferior só existem se ela estiver dentro do display
+    bool lower_page = (page + 1) < ssd->pages;
+    uint8_t keep_upper = 0xFF >> (8 - shift);
+    uint8_t keep_lower = 0xFF << shift;
+    for (uint8_t i = 0; i < columns; ++i)
     {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j)); // Desenha cada pixel do caractere
+      uint8_t *column = &dst[i << 3];
+      column[0] = (column[0] & keep_upper) | (uint8_t)(glyph[i] << shift);
+      if (lower_page)
+        column[1] = (column[1] & keep_lower) | (glyph[i] >> (8 - shift));
     }
+    if (lower_page)
+      ssd1306_mark_dirty(ssd, page + 1, x, x + columns - 1);
   }
+  ssd1306_mark_dirty(ssd, page, x, x + columns - 1);
 }
 
 // Função para desenhar uma string
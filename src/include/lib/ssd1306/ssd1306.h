@@ -1,9 +1,34 @@
+#ifndef SSD1306_H
+#define SSD1306_H
+
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 
 #define WIDTH 128
 #define HEIGHT 64
+#define SSD1306_MAX_PAGES (HEIGHT / 8)
+// Quadro com o byte de controle 0x40 na frente
+#define SSD1306_BUFSIZE (SSD1306_MAX_PAGES * WIDTH + 1)
+
+// Bit de STOP no formato do registrador IC_DATA_CMD do RP2040
+#define SSD1306_WORD_STOP I2C_IC_DATA_CMD_STOP_BITS
+// Pior caso do buffer assíncrono: uma janela completa por página (7 palavras
+// de endereçamento + byte de controle + WIDTH colunas)
+#define SSD1306_ASYNC_WORDS (SSD1306_MAX_PAGES * (8 + WIDTH))
+
+typedef void (*ssd1306_done_cb_t)(void *user_data);
+
+/*
+ * Interface do barramento usado pelo envio assíncrono. start() recebe uma
+ * sequência de palavras IC_DATA_CMD (byte nos bits 0..7, STOP no bit 9), deve
+ * retornar imediatamente e, ao terminar, chamar ssd1306_transfer_done().
+ * Permite trocar o I2C+DMA do RP2040 por um substituto no host.
+ */
+typedef struct {
+  bool (*start)(void *ctx, const uint16_t *words, size_t count);
+  void *ctx;
+} ssd1306_bus_t;
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -30,8 +55,23 @@ typedef struct {
   i2c_inst_t *i2c_port;
   bool external_vcc;
   uint8_t *ram_buffer;
+  uint8_t *shadow_buffer;   // Cópia do que já está no display (mesmo layout de ram_buffer)
+  bool shadow_valid;        // false até o primeiro envio completo
+  uint8_t dirty_pages;      // Bit n = página n alterada desde o último envio
+  uint8_t dirty_x0[SSD1306_MAX_PAGES]; // Primeira coluna alterada de cada página
+  uint8_t dirty_x1[SSD1306_MAX_PAGES]; // Última coluna alterada de cada página
   size_t bufsize;
   uint8_t port_buffer[2];
+  const ssd1306_bus_t *bus; // Barramento do envio assíncrono (NULL = desabilitado)
+  uint16_t *async_buffer;   // Palavras IC_DATA_CMD do quadro em envio
+  volatile bool busy;       // true enquanto um quadro assíncrono está em andamento
+  ssd1306_done_cb_t done_cb;
+  void *done_user_data;
+  // Memória dos buffers acima, dentro da própria estrutura: sem calloc, o
+  // display ocupa só o lugar onde ela for declarada (estática em main.c)
+  uint8_t ram_storage[SSD1306_BUFSIZE];
+  uint8_t shadow_storage[SSD1306_BUFSIZE];
+  uint16_t async_storage[SSD1306_ASYNC_WORDS];
 } ssd1306_t;
 
 // === Protótipos de Funções ===
@@ -40,6 +80,13 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
 void ssd1306_send_data(ssd1306_t *ssd);
+size_t ssd1306_flush(ssd1306_t *ssd);
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t page, uint8_t x0, uint8_t x1);
+
+void ssd1306_set_bus(ssd1306_t *ssd, const ssd1306_bus_t *bus);
+bool ssd1306_flush_async(ssd1306_t *ssd, ssd1306_done_cb_t done_cb, void *user_data);
+bool ssd1306_busy(ssd1306_t *ssd);
+void ssd1306_transfer_done(ssd1306_t *ssd, bool ok);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
@@ -48,4 +95,6 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
\ No newline at end of file
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+
+#endif // SSD1306_H
@@ -0,0 +1,83 @@
+#include "ssd1306_dma.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+/*
+ * Barramento assíncrono do SSD1306 no RP2040: um canal DMA alimenta o FIFO TX
+ * do I2C com as palavras IC_DATA_CMD. Quando o DMA termina, a interrupção
+ * TX_EMPTY do I2C (com TX_EMPTY_CTRL, habilitado pelo i2c_init) indica que o
+ * último byte saiu do FIFO, e só então o quadro é dado como concluído.
+ */
+
+static ssd1306_t *dma_ssd;
+static int dma_chan = -1;
+static ssd1306_bus_t dma_bus;
+
+static void ssd1306_dma_irq_handler(void) {
+  if (!dma_channel_get_irq1_status(dma_chan))
+    return;
+  dma_channel_acknowledge_irq1(dma_chan);
+  // FIFO já tem os últimos bytes: espera ele esvaziar
+  i2c_get_hw(dma_ssd->i2c_port)->intr_mask |= I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+}
+
+static void ssd1306_i2c_irq_handler(void) {
+  i2c_hw_t *hw = i2c_get_hw(dma_ssd->i2c_port);
+  uint32_t status = hw->intr_stat;
+
+  if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+    // NACK ou perda de arbitragem: o FIFO foi descartado pelo hardware
+    dma_channel_abort(dma_chan);
+    (void)hw->clr_tx_abrt;
+    hw->intr_mask = 0;
+    ssd1306_transfer_done(dma_ssd, false);
+  } else if (status & I2C_IC_INTR_STAT_R_TX_EMPTY_BITS) {
+    hw->intr_mask = 0;
+    ssd1306_transfer_done(dma_ssd, true);
+  }
+}
+
+static bool ssd1306_dma_start(void *ctx, const uint16_t *words, size_t count) {
+  ssd1306_t *ssd = ctx;
+  if (dma_channel_is_busy(dma_chan))
+    return false;
+
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  hw->enable = 0;
+  hw->tar = ssd->address;
+  hw->enable = 1;
+  // Abortos só são tratados aqui durante o envio; fora dele quem trata é i2c_write_blocking
+  (void)hw->clr_tx_abrt;
+  hw->intr_mask = I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+  dma_channel_config cfg = dma_channel_get_default_config(dma_chan);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, true);
+  channel_config_set_write_increment(&cfg, false);
+  channel_config_set_dreq(&cfg, i2c_get_dreq(ssd->i2c_port, true));
+  dma_channel_configure(dma_chan, &cfg, &hw->data_cmd, words, count, true);
+  return true;
+}
+
+// Configura o DMA e as interrupções e registra o barramento no driver.
+// Deve ser chamada depois de ssd1306_init/ssd1306_config.
+void ssd1306_dma_init(ssd1306_t *ssd) {
+  dma_ssd = ssd;
+  dma_chan = dma_claim_unused_channel(true);
+
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  hw->intr_mask = 0;
+  hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+
+  dma_channel_set_irq1_enabled(dma_chan, true);
+  irq_add_shared_handler(DMA_IRQ_1, ssd1306_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+
+  uint i2c_irq = i2c_get_index(ssd->i2c_port) ? I2C1_IRQ : I2C0_IRQ;
+  irq_set_exclusive_handler(i2c_irq, ssd1306_i2c_irq_handler);
+  irq_set_enabled(i2c_irq, true);
+
+  dma_bus.start = ssd1306_dma_start;
+  dma_bus.ctx = ssd;
+  ssd1306_set_bus(ssd, &dma_bus);
+}
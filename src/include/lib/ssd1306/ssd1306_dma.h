@@ -0,0 +1,8 @@
+#ifndef SSD1306_DMA_H
+#define SSD1306_DMA_H
+
+#include "ssd1306.h"
+
+void ssd1306_dma_init(ssd1306_t *ssd);
+
+#endif // SSD1306_DMA_H
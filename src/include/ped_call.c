@@ -0,0 +1,87 @@
+#include "ped_call.h"
+#include "pico/stdlib.h"
+#include "task.h"
+#include <stdio.h>
+
+/*
+ * Trava de chamada de pedestre. O botão registra, o controle consome ao abrir
+ * a travessia; as duas pontas rodam em tarefas diferentes (e, no build SMP, em
+ * núcleos diferentes), por isso tudo passa por seção crítica.
+ */
+
+void ped_call_init(ped_call_t *call) {
+    *call = (ped_call_t){ 0 };
+}
+
+/**
+ * @brief Registra uma chamada no instante time_us (time_us_32).
+ * @return true se a chamada é nova; false se já havia uma registrada.
+ */
+bool ped_call_register(ped_call_t *call, uint32_t time_us) {
+    bool is_new;
+    taskENTER_CRITICAL();
+    is_new = !call->latched;
+    if (is_new) {
+        call->latched = true;
+        call->time_us = time_us;
+        call->stats.calls++;
+    } else {
+        call->stats.repeats++;
+    }
+    taskEXIT_CRITICAL();
+    return is_new;
+}
+
+bool ped_call_pending(const ped_call_t *call) {
+    return call->latched;
+}
+
+/**
+ * @brief A travessia começou: atende a chamada registrada (se houver) e mede a espera.
+ */
+void ped_call_serve(ped_call_t *call) {
+    uint32_t now_us = time_us_32();
+    taskENTER_CRITICAL();
+    if (call->latched) {
+        uint32_t wait_ms = (now_us - call->time_us) / 1000u;
+        call->latched = false;
+        call->stats.served++;
+        call->stats.wait_sum_ms += wait_ms;
+        if (wait_ms > call->stats.wait_max_ms) {
+            call->stats.wait_max_ms = wait_ms;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Contabiliza um passo encerrado em modo normal (ocupação do verde veicular).
+ */
+void ped_call_account(ped_call_t *call, bool vehicle_green, TickType_t elapsed_ticks) {
+    uint32_t elapsed_ms = elapsed_ticks * portTICK_PERIOD_MS;
+    taskENTER_CRITICAL();
+    call->stats.total_ms += elapsed_ms;
+    if (vehicle_green) {
+        call->stats.green_ms += elapsed_ms;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void ped_call_get(const ped_call_t *call, ped_call_stats_t *out) {
+    taskENTER_CRITICAL();
+    *out = call->stats;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Imprime chamadas, esperas e a fração do tempo com verde veicular.
+ */
+void ped_call_print(const ped_call_t *call) {
+    ped_call_stats_t s;
+    ped_call_get(call, &s);
+    uint32_t green_permille = s.total_ms ? (uint32_t)(s.green_ms * 1000u / s.total_ms) : 0;
+    printf("Chamadas: %lu (+%lu repetidas)  servidas: %lu  espera(ms) max/media: %lu/%lu  verde veicular: %lu.%lu%%\n",
+           (unsigned long)s.calls, (unsigned long)s.repeats, (unsigned long)s.served,
+           (unsigned long)s.wait_max_ms, (unsigned long)(s.served ? s.wait_sum_ms / s.served : 0),
+           (unsigned long)(green_permille / 10), (unsigned long)(green_permille % 10));
+}
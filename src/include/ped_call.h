@@ -0,0 +1,39 @@
+#ifndef PED_CALL_H
+#define PED_CALL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+
+/**
+ * @brief Chamadas de pedestre (botão B) e o efeito delas no cruzamento.
+ *        Espera = do registro da chamada até o início da travessia que a serve.
+ */
+typedef struct {
+    uint32_t calls;          // chamadas registradas
+    uint32_t repeats;        // toques com a chamada já registrada (não contam de novo)
+    uint32_t served;         // travessias que atenderam uma chamada
+    uint32_t wait_max_ms;    // maior espera
+    uint64_t wait_sum_ms;    // soma das esperas (média = soma / served)
+    uint64_t green_ms;       // tempo em verde do grupo veicular (modo normal)
+    uint64_t total_ms;       // tempo total em modo normal
+} ped_call_stats_t;
+
+/**
+ * @brief Trava de chamada e estatísticas de uma travessia (uma por cruzamento).
+ */
+typedef struct {
+    ped_call_stats_t stats;
+    bool latched;
+    uint32_t time_us;        // instante do registro da chamada travada
+} ped_call_t;
+
+void ped_call_init(ped_call_t *call);
+bool ped_call_register(ped_call_t *call, uint32_t time_us);
+bool ped_call_pending(const ped_call_t *call);
+void ped_call_serve(ped_call_t *call);
+void ped_call_account(ped_call_t *call, bool vehicle_green, TickType_t elapsed_ticks);
+void ped_call_get(const ped_call_t *call, ped_call_stats_t *out);
+void ped_call_print(const ped_call_t *call);
+
+#endif // PED_CALL_H
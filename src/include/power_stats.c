@@ -0,0 +1,94 @@
+#include "power_stats.h"
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Contabilidade do idle tickless. Os ganchos configPRE/POST_SLEEP_PROCESSING
+ * do FreeRTOS chamam power_stats_pre_sleep/post_sleep com as interrupções
+ * desabilitadas, logo antes e logo depois do WFI; o tempo de cada sono é
+ * somado no passo do plano em que o semáforo está.
+ */
+
+static power_phase_stats_t phase_stats[SIGNAL_MAX_STEPS];
+static volatile uint8_t current_phase = 0;
+static uint64_t phase_start_us = 0;
+static uint64_t sleep_start_us = 0;
+
+static uint8_t depth_bucket(uint32_t expected_idle_ticks) {
+    if (expected_idle_ticks < 4)  return 0;
+    if (expected_idle_ticks < 16) return 1;
+    if (expected_idle_ticks < 64) return 2;
+    return 3;
+}
+
+/**
+ * @brief Fecha o tempo da fase anterior e passa a contar na nova fase.
+ */
+void power_stats_set_phase(uint8_t phase) {
+    if (phase >= SIGNAL_MAX_STEPS) return;
+
+    taskENTER_CRITICAL();
+    uint64_t now = time_us_64();
+    if (phase_start_us != 0) {
+        phase_stats[current_phase].phase_us += now - phase_start_us;
+    }
+    phase_start_us = now;
+    current_phase = phase;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Gancho antes do WFI (configPRE_SLEEP_PROCESSING).
+ */
+void power_stats_pre_sleep(uint32_t expected_idle_ticks) {
+    phase_stats[current_phase].depth[depth_bucket(expected_idle_ticks)]++;
+    sleep_start_us = time_us_64();
+}
+
+/**
+ * @brief Gancho depois do WFI (configPOST_SLEEP_PROCESSING).
+ */
+void power_stats_post_sleep(uint32_t expected_idle_ticks) {
+    (void)expected_idle_ticks;
+    power_phase_stats_t *stats = &phase_stats[current_phase];
+    stats->sleep_us += time_us_64() - sleep_start_us;
+    stats->wakeups++;
+}
+
+/**
+ * @brief Copia os contadores de uma fase, incluindo o tempo da fase em andamento.
+ */
+void power_stats_get(uint8_t phase, power_phase_stats_t *out) {
+    if (phase >= SIGNAL_MAX_STEPS) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    taskENTER_CRITICAL();
+    *out = phase_stats[phase];
+    if (phase == current_phase && phase_start_us != 0) {
+        out->phase_us += time_us_64() - phase_start_us;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Imprime, por fase, acordadas por segundo, residência em idle e o
+ *        histograma de profundidade do sono.
+ */
+void power_stats_print() {
+    printf("Energia: fase  tempo(ms)  acordadas/s  idle(%%)  sono[2-3 4-15 16-63 64+]\n");
+    for (uint8_t phase = 0; phase < SIGNAL_MAX_STEPS; phase++) {
+        power_phase_stats_t s;
+        power_stats_get(phase, &s);
+        if (s.phase_us == 0) continue;
+        printf("Energia: %d  %lu  %lu  %lu  %lu %lu %lu %lu\n", phase,
+               (unsigned long)(s.phase_us / 1000),
+               (unsigned long)((uint64_t)s.wakeups * 1000000u / s.phase_us),
+               (unsigned long)(s.sleep_us * 100u / s.phase_us),
+               (unsigned long)s.depth[0], (unsigned long)s.depth[1],
+               (unsigned long)s.depth[2], (unsigned long)s.depth[3]);
+    }
+}
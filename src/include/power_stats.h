@@ -0,0 +1,26 @@
+#ifndef POWER_STATS_H
+#define POWER_STATS_H
+
+#include <stdint.h>
+#include "signal_plan.h"
+
+// Faixas do histograma de profundidade do sono (ticks suprimidos por entrada)
+#define POWER_DEPTH_BUCKETS 4 // [2-3], [4-15], [16-63], [64+]
+
+/**
+ * @brief Contadores do idle tickless acumulados em um passo do plano de sinalização.
+ */
+typedef struct {
+    uint32_t wakeups;                       // saídas do sono (tick ou interrupção)
+    uint64_t sleep_us;                      // tempo dormindo (WFI)
+    uint64_t phase_us;                      // tempo total na fase
+    uint32_t depth[POWER_DEPTH_BUCKETS];    // entradas por ticks esperados de idle
+} power_phase_stats_t;
+
+void power_stats_set_phase(uint8_t phase);
+void power_stats_pre_sleep(uint32_t expected_idle_ticks);
+void power_stats_post_sleep(uint32_t expected_idle_ticks);
+void power_stats_get(uint8_t phase, power_phase_stats_t *out);
+void power_stats_print();
+
+#endif // POWER_STATS_H
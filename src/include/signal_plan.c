@@ -0,0 +1,190 @@
+#include "signal_plan.h"
+#include "traffic_light.h"
+#include "config.h"
+
+// Abreviações das indicações, só para deixar as tabelas legíveis
+#define OFF SIGNAL_DARK
+#define R   SIGNAL_RED
+#define Y   SIGNAL_YELLOW
+#define G   SIGNAL_GREEN
+#define FY  SIGNAL_FLASH_YELLOW
+#define FR  SIGNAL_FLASH_RED
+#define DW  SIGNAL_DONT_WALK
+#define W   SIGNAL_WALK
+#define FDW SIGNAL_FLASH_DONT_WALK
+
+/*
+ * Semáforo da BitDogLab: um grupo veicular (LED RGB) e uma travessia de
+ * pedestres (matriz e buzzer). Os índices são os TrafficLight_states.
+ */
+static const signal_step_t pedestrian_steps[] = {
+    //                     descrição                                                       display                            duração               intervalo                  próximo                ciclo   carro ped
+    [CARS_GREEN_LIGHT]    = { "Carro: Sinal Verde / Pedestre Vermelho",                     "Carro: Siga    \nPed: Pare",      TIME_CARS_GREEN_MS,   SIGNAL_INTERVAL_GREEN,     CARS_YELLOW_LIGHT,     true,  { G,  DW  } },
+    [CARS_YELLOW_LIGHT]   = { "Carro: Sinal Amarelo / Pedestre Vermelho",                   "Carro: Atenção!  \nPed: Pare",    TIME_CARS_YELLOW_MS,  SIGNAL_INTERVAL_YELLOW,    CARS_PED_RED_LIGHT,    false, { Y,  DW  } },
+    [CARS_PED_RED_LIGHT]  = { "Todos Vermelhos (Troca Segura)",                             "Carro: Pare \nPed: Pare",         TIME_ALL_RED_MS,      SIGNAL_INTERVAL_ALL_RED,   CARS_RED_PEDS_WALK,    false, { R,  DW  } },
+    [CARS_RED_PEDS_WALK]  = { "Carro: Sinal Vermelho / Pedestre: Sinal Verde (Andando)",    "Carro: Pare \nPed: Siga",         TIME_PEDS_WALK_MS,    SIGNAL_INTERVAL_WALK,      CARS_RED_PEDS_FLASH,   false, { R,  W   } },
+    [CARS_RED_PEDS_FLASH] = { "Carro: Sinal Vermelho / Pedestre: Sinal Vermelho (Piscando)", "Carro: Pare \nPed: Piscando",     TIME_PEDS_FLASH_MS,   SIGNAL_INTERVAL_CLEARANCE, CARS_GREEN_LIGHT,      false, { R,  FDW } },
+    [CARS_NIGHT_FLASHING] = { "Modo Noturno (Amarelo Piscando)",                            "Carro: Amarelo Piscando.",        0,                    SIGNAL_INTERVAL_FLASH,     CARS_NIGHT_FLASHING,   false, { FY, OFF } },
+};
+
+const signal_plan_t signal_plan_pedestrian = {
+    .name = "semaforo + travessia",
+    .steps = pedestrian_steps,
+    .step_count = TRAFFIC_LIGHT_STATE_COUNT,
+    .group_count = 2,
+    .start_step = CARS_PED_RED_LIGHT,
+    .night_step = CARS_NIGHT_FLASHING,
+    .vehicle_group = SIGNAL_GROUP_CARS,
+    .pedestrian_group = SIGNAL_GROUP_PEDS,
+    // Modo atuado: sem chamada o vermelho geral volta ao verde, que descansa
+    .call_step = CARS_RED_PEDS_WALK,
+    .skip_step = CARS_GREEN_LIGHT,
+    .rest_step = CARS_GREEN_LIGHT,
+};
+
+/*
+ * Cruzamento de quatro aproximações com oito fases veiculares (numeração NEMA:
+ * ímpares = conversões à esquerda, pares = movimentos diretos) e as travessias
+ * paralelas às fases 2, 4, 6 e 8, em anel duplo com barreira:
+ *   anel 1: 1 -> 2 | 3 -> 4      anel 2: 5 -> 6 | 7 -> 8
+ * Fases do mesmo lado da barreira rodam em par (1+5, 2+6, 3+7, 4+8).
+ * Na placa aparecem a fase 2 (LED RGB) e a travessia P2 (matriz e buzzer).
+ */
+#define NEMA8_MAIN_LEFT_GREEN_MS    5000
+#define NEMA8_MAIN_WALK_MS          7000
+#define NEMA8_MAIN_CLEARANCE_MS     5000
+#define NEMA8_SIDE_LEFT_GREEN_MS    4000
+#define NEMA8_SIDE_WALK_MS          5000
+#define NEMA8_SIDE_CLEARANCE_MS     4000
+#define NEMA8_YELLOW_MS             3000
+#define NEMA8_ALL_RED_MS            1500
+
+enum {
+    NEMA8_GROUP_P2 = 8, // grupos 0..7 = fases 1..8
+    NEMA8_GROUP_P4,
+    NEMA8_GROUP_P6,
+    NEMA8_GROUP_P8,
+    NEMA8_GROUP_COUNT
+};
+
+static const signal_step_t nema8_steps[] = {
+    //  descrição                        display                      duração                    intervalo                  próx. ciclo    F1  F2  F3  F4  F5  F6  F7  F8   P2   P4   P6   P8
+    { "Fases 1+5: conversoes L-O",      "Fases 1+5\nConversao L-O",   NEMA8_MAIN_LEFT_GREEN_MS,  SIGNAL_INTERVAL_GREEN,     1,  true,  { G,  R,  R,  R,  G,  R,  R,  R,  DW,  DW,  DW,  DW  } },
+    { "Fases 1+5: amarelo",             "Fases 1+5\nAmarelo",         NEMA8_YELLOW_MS,           SIGNAL_INTERVAL_YELLOW,    2,  false, { Y,  R,  R,  R,  Y,  R,  R,  R,  DW,  DW,  DW,  DW  } },
+    { "Fases 1+5: vermelho geral",      "Fases 1+5\nVermelho geral",  NEMA8_ALL_RED_MS,          SIGNAL_INTERVAL_ALL_RED,   3,  false, { R,  R,  R,  R,  R,  R,  R,  R,  DW,  DW,  DW,  DW  } },
+    { "Fases 2+6: direto L-O, P2/P6",   "Fases 2+6\nPed: Siga",       NEMA8_MAIN_WALK_MS,        SIGNAL_INTERVAL_WALK,      4,  false, { R,  G,  R,  R,  R,  G,  R,  R,  W,   DW,  W,   DW  } },
+    { "Fases 2+6: limpeza P2/P6",       "Fases 2+6\nPed: Piscando",   NEMA8_MAIN_CLEARANCE_MS,   SIGNAL_INTERVAL_CLEARANCE, 5,  false, { R,  G,  R,  R,  R,  G,  R,  R,  FDW, DW,  FDW, DW  } },
+    { "Fases 2+6: amarelo",             "Fases 2+6\nAmarelo",         NEMA8_YELLOW_MS,           SIGNAL_INTERVAL_YELLOW,    6,  false, { R,  Y,  R,  R,  R,  Y,  R,  R,  DW,  DW,  DW,  DW  } },
+    { "Barreira L-O -> N-S",            "Barreira\nVermelho geral",   NEMA8_ALL_RED_MS,          SIGNAL_INTERVAL_ALL_RED,   7,  false, { R,  R,  R,  R,  R,  R,  R,  R,  DW,  DW,  DW,  DW  } },
+    { "Fases 3+7: conversoes N-S",      "Fases 3+7\nConversao N-S",   NEMA8_SIDE_LEFT_GREEN_MS,  SIGNAL_INTERVAL_GREEN,     8,  false, { R,  R,  G,  R,  R,  R,  G,  R,  DW,  DW,  DW,  DW  } },
+    { "Fases 3+7: amarelo",             "Fases 3+7\nAmarelo",         NEMA8_YELLOW_MS,           SIGNAL_INTERVAL_YELLOW,    9,  false, { R,  R,  Y,  R,  R,  R,  Y,  R,  DW,  DW,  DW,  DW  } },
+    { "Fases 3+7: vermelho geral",      "Fases 3+7\nVermelho geral",  NEMA8_ALL_RED_MS,          SIGNAL_INTERVAL_ALL_RED,   10, false, { R,  R,  R,  R,  R,  R,  R,  R,  DW,  DW,  DW,  DW  } },
+    { "Fases 4+8: direto N-S, P4/P8",   "Fases 4+8\nPed: Siga",       NEMA8_SIDE_WALK_MS,        SIGNAL_INTERVAL_WALK,      11, false, { R,  R,  R,  G,  R,  R,  R,  G,  DW,  W,   DW,  W   } },
+    { "Fases 4+8: limpeza P4/P8",       "Fases 4+8\nPed: Piscando",   NEMA8_SIDE_CLEARANCE_MS,   SIGNAL_INTERVAL_CLEARANCE, 12, false, { R,  R,  R,  G,  R,  R,  R,  G,  DW,  FDW, DW,  FDW } },
+    { "Fases 4+8: amarelo",             "Fases 4+8\nAmarelo",         NEMA8_YELLOW_MS,           SIGNAL_INTERVAL_YELLOW,    13, false, { R,  R,  R,  Y,  R,  R,  R,  Y,  DW,  DW,  DW,  DW  } },
+    { "Barreira N-S -> L-O",            "Barreira\nVermelho geral",   NEMA8_ALL_RED_MS,          SIGNAL_INTERVAL_ALL_RED,   0,  false, { R,  R,  R,  R,  R,  R,  R,  R,  DW,  DW,  DW,  DW  } },
+    { "Modo noturno: principal amarelo", "Pisca amarelo\nna via L-O",    0,                      SIGNAL_INTERVAL_FLASH,     14, false, { FR, FY, FR, FR, FR, FY, FR, FR, OFF, OFF, OFF, OFF } },
+};
+
+const signal_plan_t signal_plan_nema8 = {
+    .name = "4 aproximacoes, 8 fases",
+    .steps = nema8_steps,
+    .step_count = sizeof(nema8_steps) / sizeof(nema8_steps[0]),
+    .group_count = NEMA8_GROUP_COUNT,
+    .start_step = 13, // barreira: todos vermelhos
+    .night_step = 14,
+    .vehicle_group = 1, // fase 2
+    .pedestrian_group = NEMA8_GROUP_P2,
+    // Travessias dentro das fases diretas: sem passo separado para pular
+    .call_step = SIGNAL_NO_STEP,
+    .skip_step = SIGNAL_NO_STEP,
+    .rest_step = SIGNAL_NO_STEP,
+};
+
+#undef OFF
+#undef R
+#undef Y
+#undef G
+#undef FY
+#undef FR
+#undef DW
+#undef W
+#undef FDW
+
+/**
+ * @brief Confere os limites da tabela (índices de passos e grupos, durações).
+ *        Não verifica conflitos entre movimentos: isso é responsabilidade de quem escreve o plano.
+ */
+bool signal_plan_valid(const signal_plan_t *plan) {
+    if (plan->step_count == 0 || plan->step_count > SIGNAL_MAX_STEPS ||
+        plan->group_count == 0 || plan->group_count > SIGNAL_MAX_GROUPS ||
+        plan->start_step >= plan->step_count || plan->night_step >= plan->step_count ||
+        plan->vehicle_group >= plan->group_count || plan->pedestrian_group >= plan->group_count) {
+        return false;
+    }
+    if (signal_plan_actuated(plan) &&
+        (plan->call_step >= plan->step_count || plan->skip_step >= plan->step_count ||
+         plan->rest_step >= plan->step_count || plan->skip_step == plan->call_step)) {
+        return false;
+    }
+    for (uint8_t step = 0; step < plan->step_count; ++step) {
+        const signal_step_t *s = &plan->steps[step];
+        if (s->next >= plan->step_count) {
+            return false;
+        }
+        // Só o passo noturno pode não ter duração (o controle fica nele até a troca de modo)
+        if (s->duration_ms == 0 && step != plan->night_step) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Posiciona o controle no passo seguro de partida do plano.
+ */
+void signal_engine_start(signal_engine_t *engine, const signal_plan_t *plan) {
+    engine->plan = plan;
+    engine->step = plan->start_step;
+}
+
+/**
+ * @brief Avança para o próximo passo da tabela.
+ *        Em plano atuado, sem chamada de pedestre, a travessia é pulada
+ *        (o controle em tempo fixo passa ped_call = true).
+ */
+void signal_engine_advance(signal_engine_t *engine, bool ped_call) {
+    const signal_plan_t *plan = engine->plan;
+    uint8_t next = plan->steps[engine->step].next;
+    if (!ped_call && signal_plan_actuated(plan) && next == plan->call_step) {
+        next = plan->skip_step;
+    }
+    engine->step = next;
+}
+
+/**
+ * @brief Duração de um ciclo completo em tempo fixo, a partir do primeiro passo
+ *        que abre ciclo (0 se o plano não tem ciclo).
+ */
+uint32_t signal_plan_cycle_ms(const signal_plan_t *plan) {
+    for (uint8_t first = 0; first < plan->step_count; ++first) {
+        if (!plan->steps[first].cycle_start) {
+            continue;
+        }
+        uint32_t cycle_ms = 0;
+        uint8_t step = first;
+        for (uint8_t n = 0; n < plan->step_count; ++n) {
+            cycle_ms += plan->steps[step].duration_ms;
+            step = plan->steps[step].next;
+            if (step == first) {
+                return cycle_ms;
+            }
+        }
+        return 0;
+    }
+    return 0;
+}
+
+void signal_engine_enter_night(signal_engine_t *engine) {
+    engine->step = engine->plan->night_step;
+}
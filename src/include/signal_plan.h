@@ -0,0 +1,107 @@
+#ifndef SIGNAL_PLAN_H
+#define SIGNAL_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Motor de fases dirigido por tabela. Um plano é uma tabela constante de
+ * passos; cada passo é um intervalo (verde, amarelo, vermelho geral, travessia,
+ * limpeza...) com a duração, a indicação de cada grupo semafórico e o índice
+ * do próximo passo, então avançar é O(1) e anéis/barreiras viram apenas a
+ * ordem dos passos na tabela.
+ */
+
+#define SIGNAL_MAX_GROUPS  12 // grupos semafóricos (saídas) por plano
+#define SIGNAL_MAX_STEPS   16 // passos por plano, incluindo o do modo noturno
+#define SIGNAL_NO_STEP     0xFF // índice de passo ausente (plano sem atuação)
+
+/**
+ * @brief Indicação mostrada por um grupo semafórico.
+ */
+typedef enum {
+    SIGNAL_DARK,            /**< Apagado. */
+    SIGNAL_RED,             /**< Veículo: vermelho. */
+    SIGNAL_YELLOW,          /**< Veículo: amarelo. */
+    SIGNAL_GREEN,           /**< Veículo: verde. */
+    SIGNAL_FLASH_YELLOW,    /**< Veículo: amarelo piscante. */
+    SIGNAL_FLASH_RED,       /**< Veículo: vermelho piscante. */
+    SIGNAL_DONT_WALK,       /**< Pedestre: pare. */
+    SIGNAL_WALK,            /**< Pedestre: siga. */
+    SIGNAL_FLASH_DONT_WALK, /**< Pedestre: pare piscante (limpeza da travessia). */
+} signal_indication_t;
+
+/**
+ * @brief Tipo de intervalo de um passo (a duração vem do próprio passo).
+ */
+typedef enum {
+    SIGNAL_INTERVAL_GREEN,      /**< Verde (duração = verde mínimo). */
+    SIGNAL_INTERVAL_YELLOW,     /**< Amarelo. */
+    SIGNAL_INTERVAL_ALL_RED,    /**< Vermelho geral / barreira. */
+    SIGNAL_INTERVAL_WALK,       /**< Travessia de pedestres. */
+    SIGNAL_INTERVAL_CLEARANCE,  /**< Limpeza da travessia (pare piscante). */
+    SIGNAL_INTERVAL_FLASH,      /**< Modo piscante (sem duração). */
+} signal_interval_t;
+
+/**
+ * @brief Um passo da tabela.
+ */
+typedef struct {
+    const char *name;       // descrição para o log
+    const char *text;       // texto do display (até duas linhas)
+    uint16_t duration_ms;   // duração do intervalo
+    uint8_t interval;       // signal_interval_t
+    uint8_t next;           // índice do próximo passo
+    bool cycle_start;       // o passo abre um novo ciclo
+    uint8_t indications[SIGNAL_MAX_GROUPS]; // signal_indication_t por grupo
+} signal_step_t;
+
+/**
+ * @brief Plano de sinalização: tabela de passos e como ela se liga à placa.
+ */
+typedef struct {
+    const char *name;
+    const signal_step_t *steps;
+    uint8_t step_count;
+    uint8_t group_count;
+    uint8_t start_step;         // passo seguro da partida e da volta do modo noturno
+    uint8_t night_step;         // passo do modo noturno
+    uint8_t vehicle_group;      // grupo mostrado no LED RGB
+    uint8_t pedestrian_group;   // grupo mostrado na matriz e no buzzer
+    // Atuação por chamada de pedestre (call_step = SIGNAL_NO_STEP: só tempo fixo)
+    uint8_t call_step;          // travessia, servida só com chamada registrada
+    uint8_t skip_step;          // destino, sem chamada, do passo que levaria a call_step
+    uint8_t rest_step;          // verde veicular que descansa até chegar uma chamada
+} signal_plan_t;
+
+/**
+ * @brief Posição de um controle em um plano.
+ */
+typedef struct {
+    const signal_plan_t *plan;
+    uint8_t step;
+} signal_engine_t;
+
+// Planos disponíveis (tabelas em signal_plan.c)
+extern const signal_plan_t signal_plan_pedestrian; // semáforo veicular + travessia (6 estados)
+extern const signal_plan_t signal_plan_nema8;      // cruzamento de 4 aproximações, 8 fases
+
+bool signal_plan_valid(const signal_plan_t *plan);
+void signal_engine_start(signal_engine_t *engine, const signal_plan_t *plan);
+void signal_engine_advance(signal_engine_t *engine, bool ped_call);
+uint32_t signal_plan_cycle_ms(const signal_plan_t *plan);
+void signal_engine_enter_night(signal_engine_t *engine);
+
+static inline const signal_step_t *signal_engine_current(const signal_engine_t *engine) {
+    return &engine->plan->steps[engine->step];
+}
+
+static inline bool signal_plan_actuated(const signal_plan_t *plan) {
+    return plan->call_step != SIGNAL_NO_STEP;
+}
+
+static inline signal_indication_t signal_plan_indication(const signal_plan_t *plan, uint8_t step, uint8_t group) {
+    return (signal_indication_t)plan->steps[step].indications[group];
+}
+
+#endif // SIGNAL_PLAN_H
@@ -0,0 +1,43 @@
+#include "static_memory.h"
+
+/*
+ * Memória das tarefas criadas pelo próprio kernel (idle de cada núcleo e
+ * timers), pedida por callback quando configSUPPORT_STATIC_ALLOCATION = 1.
+ */
+
+#if configSUPPORT_STATIC_ALLOCATION
+
+static StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+static StaticTask_t idle_tcb;
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack, configSTACK_DEPTH_TYPE *stack_depth) {
+    *tcb = &idle_tcb;
+    *stack = idle_stack;
+    *stack_depth = configMINIMAL_STACK_SIZE;
+}
+
+#if configNUMBER_OF_CORES > 1
+// Idle "passivo" dos demais núcleos (um por núcleo além do 0)
+static StackType_t passive_idle_stack[configNUMBER_OF_CORES - 1][configMINIMAL_STACK_SIZE];
+static StaticTask_t passive_idle_tcb[configNUMBER_OF_CORES - 1];
+
+void vApplicationGetPassiveIdleTaskMemory(StaticTask_t **tcb, StackType_t **stack,
+                                          configSTACK_DEPTH_TYPE *stack_depth, BaseType_t index) {
+    *tcb = &passive_idle_tcb[index];
+    *stack = passive_idle_stack[index];
+    *stack_depth = configMINIMAL_STACK_SIZE;
+}
+#endif
+
+#if configUSE_TIMERS
+static StackType_t timer_stack[configTIMER_TASK_STACK_DEPTH];
+static StaticTask_t timer_tcb;
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **tcb, StackType_t **stack, configSTACK_DEPTH_TYPE *stack_depth) {
+    *tcb = &timer_tcb;
+    *stack = timer_stack;
+    *stack_depth = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+
+#endif // configSUPPORT_STATIC_ALLOCATION
@@ -0,0 +1,28 @@
+#ifndef STATIC_MEMORY_H
+#define STATIC_MEMORY_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*
+ * Build estático (TRAFFIC_STATIC=1): cada objeto do kernel tem a memória
+ * reservada em tempo de compilação, em .bss, e aparece no .map com o próprio
+ * nome (ex.: vGeneralControlTask_stack), o que o tools/ram_budget.py usa para
+ * separar o consumo por subsistema. No build dinâmico as macros somem e os
+ * objetos vêm do heap_4 como antes.
+ */
+
+#if configSUPPORT_STATIC_ALLOCATION
+// Pilha e TCB de uma tarefa
+#define TASK_MEMORY(task, depth) \
+    static StackType_t task##_stack[depth]; \
+    static StaticTask_t task##_tcb
+#define TASK_STACK(task) (task##_stack)
+#define TASK_TCB(task)   (&task##_tcb)
+#else
+#define TASK_MEMORY(task, depth)
+#define TASK_STACK(task) NULL
+#define TASK_TCB(task)   NULL
+#endif
+
+#endif // STATIC_MEMORY_H
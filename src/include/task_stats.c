@@ -0,0 +1,289 @@
+#include "task_stats.h"
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Estatísticas de execução por tarefa: CPU (contador de run-time em us),
+ * marca d'água da pilha, mínimo de heap livre do heap_4, a maior latência de
+ * um laço (do acordar até voltar a bloquear) e quantas vezes o laço acordou. A CPU é calculada entre duas
+ * amostras consecutivas, então o contador de 32 bits pode dar a volta.
+ *
+ * A ocupação de cada núcleo é 100% menos o tempo em que ele rodou uma tarefa
+ * idle. No build SMP as idles não têm núcleo fixo (e as estatísticas não mexem
+ * no escalonamento): as trocas de contexto (traceTASK_SWITCHED_IN/OUT) somam o
+ * tempo de idle no núcleo onde ele de fato rodou.
+ */
+
+#if (configNUMBER_OF_CORES > 1)
+#define TASK_STATS_CORES configNUMBER_OF_CORES
+#else
+#define TASK_STATS_CORES 1
+#endif
+
+typedef struct {
+    uint32_t start_us;
+    uint32_t max_us;
+    uint32_t wakeups;   // iterações do laço desde o boot
+    bool running;
+} task_loop_stats_t;
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t last_runtime;
+} task_runtime_t;
+
+static task_loop_stats_t loop_pool[TASK_STATS_MAX_TASKS];
+static uint8_t loop_pool_used = 0;
+
+static TaskStatus_t task_status[TASK_STATS_MAX_TASKS];
+static UBaseType_t task_count = 0;
+static task_runtime_t last_runtime[TASK_STATS_MAX_TASKS];
+static uint16_t cpu_permille[TASK_STATS_MAX_TASKS];
+static uint32_t last_total_runtime = 0;
+static uint16_t core_busy_permille[TASK_STATS_CORES];
+#if (configNUMBER_OF_CORES > 1)
+// Escritos só pelo próprio núcleo, dentro da troca de contexto (com o lock do kernel)
+static uint32_t core_idle_runtime[TASK_STATS_CORES]; // tempo de idle acumulado no núcleo
+static uint32_t core_idle_since[TASK_STATS_CORES];   // início do trecho de idle em andamento
+static bool core_idle_running[TASK_STATS_CORES];
+static uint32_t last_core_idle_runtime[TASK_STATS_CORES];
+#else
+static TaskHandle_t idle_handle;
+#endif
+
+// Slot de latência da tarefa atual (alocado no primeiro uso)
+static task_loop_stats_t *current_loop_stats() {
+    task_loop_stats_t *stats = pvTaskGetThreadLocalStoragePointer(NULL, TASK_STATS_TLS_INDEX);
+    if (stats == NULL) {
+        taskENTER_CRITICAL();
+        if (loop_pool_used < TASK_STATS_MAX_TASKS) {
+            stats = &loop_pool[loop_pool_used++];
+        }
+        taskEXIT_CRITICAL();
+        vTaskSetThreadLocalStoragePointer(NULL, TASK_STATS_TLS_INDEX, stats);
+    }
+    return stats;
+}
+
+/**
+ * @brief Marca o início de uma iteração do laço da tarefa atual (logo após acordar).
+ */
+void task_stats_loop_start() {
+    task_loop_stats_t *stats = current_loop_stats();
+    if (stats == NULL) return;
+    stats->start_us = time_us_32();
+    stats->wakeups++;
+    stats->running = true;
+}
+
+/**
+ * @brief Marca o fim da iteração (antes de bloquear) e atualiza o máximo.
+ */
+void task_stats_loop_end() {
+    task_loop_stats_t *stats = current_loop_stats();
+    if (stats == NULL || !stats->running) return;
+    uint32_t elapsed = time_us_32() - stats->start_us;
+    if (elapsed > stats->max_us) {
+        stats->max_us = elapsed;
+    }
+    stats->running = false;
+}
+
+static uint32_t loop_max_us(TaskHandle_t handle) {
+    task_loop_stats_t *stats = pvTaskGetThreadLocalStoragePointer(handle, TASK_STATS_TLS_INDEX);
+    return (stats != NULL) ? stats->max_us : 0;
+}
+
+/**
+ * @brief Quantas vezes o laço da tarefa acordou desde o boot (0 se ela não usa
+ *        task_stats_loop_start).
+ */
+uint32_t task_stats_wakeups(TaskHandle_t handle) {
+    task_loop_stats_t *stats = pvTaskGetThreadLocalStoragePointer(handle, TASK_STATS_TLS_INDEX);
+    return (stats != NULL) ? stats->wakeups : 0;
+}
+
+static uint32_t previous_runtime(TaskHandle_t handle, uint32_t runtime) {
+    for (int i = 0; i < TASK_STATS_MAX_TASKS; i++) {
+        if (last_runtime[i].handle == handle) {
+            return last_runtime[i].last_runtime;
+        }
+    }
+    return runtime; // tarefa nova: sem histórico
+}
+
+#if (configNUMBER_OF_CORES > 1)
+static bool is_idle_task(TaskHandle_t task) {
+    for (BaseType_t core = 0; core < TASK_STATS_CORES; core++) {
+        if (task == xTaskGetIdleTaskHandleForCore(core)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief traceTASK_SWITCHED_IN (build SMP): marca o início do idle no núcleo.
+ */
+void task_stats_switched_in(void) {
+    BaseType_t core = portGET_CORE_ID();
+    if (is_idle_task(xTaskGetCurrentTaskHandleForCore(core))) {
+        core_idle_since[core] = portGET_RUN_TIME_COUNTER_VALUE();
+        core_idle_running[core] = true;
+    }
+}
+
+/**
+ * @brief traceTASK_SWITCHED_OUT (build SMP): fecha o trecho de idle do núcleo.
+ */
+void task_stats_switched_out(void) {
+    BaseType_t core = portGET_CORE_ID();
+    if (core_idle_running[core]) {
+        core_idle_runtime[core] += portGET_RUN_TIME_COUNTER_VALUE() - core_idle_since[core];
+        core_idle_running[core] = false;
+    }
+}
+
+// Ocupação de cada núcleo na janela, pelo idle somado nas trocas de contexto
+static void core_busy_update(uint32_t window) {
+    taskENTER_CRITICAL();
+    uint32_t now = portGET_RUN_TIME_COUNTER_VALUE();
+    for (int core = 0; core < TASK_STATS_CORES; core++) {
+        uint32_t idle = core_idle_runtime[core];
+        if (core_idle_running[core]) {
+            idle += now - core_idle_since[core]; // trecho ainda aberto no outro núcleo
+        }
+        uint32_t delta = idle - last_core_idle_runtime[core];
+        last_core_idle_runtime[core] = idle;
+        uint32_t idle_permille = (window > 0) ? (uint32_t)(((uint64_t)delta * 1000u) / window) : 0;
+        core_busy_permille[core] = idle_permille < 1000 ? 1000 - idle_permille : 0;
+    }
+    taskEXIT_CRITICAL();
+}
+#endif
+
+/**
+ * @brief Lê o estado de todas as tarefas e calcula a CPU desde a amostra anterior.
+ */
+void task_stats_sample() {
+#if (configNUMBER_OF_CORES == 1)
+    if (idle_handle == NULL) {
+        idle_handle = xTaskGetIdleTaskHandle();
+    }
+#endif
+    uint32_t total_runtime = 0;
+    task_count = uxTaskGetSystemState(task_status, TASK_STATS_MAX_TASKS, &total_runtime);
+    uint32_t window = total_runtime - last_total_runtime;
+
+    for (UBaseType_t i = 0; i < task_count; i++) {
+        uint32_t delta = task_status[i].ulRunTimeCounter -
+                         previous_runtime(task_status[i].xHandle, task_status[i].ulRunTimeCounter);
+        cpu_permille[i] = (window > 0) ? (uint16_t)(((uint64_t)delta * 1000u) / window) : 0;
+#if (configNUMBER_OF_CORES == 1)
+        if (task_status[i].xHandle == idle_handle) {
+            core_busy_permille[0] = cpu_permille[i] < 1000 ? 1000 - cpu_permille[i] : 0;
+        }
+#endif
+    }
+#if (configNUMBER_OF_CORES > 1)
+    core_busy_update(window);
+#endif
+    memset(last_runtime, 0, sizeof(last_runtime));
+    for (UBaseType_t i = 0; i < task_count; i++) {
+        last_runtime[i].handle = task_status[i].xHandle;
+        last_runtime[i].last_runtime = task_status[i].ulRunTimeCounter;
+    }
+    last_total_runtime = total_runtime;
+}
+
+/**
+ * @brief Imprime a tabela de tarefas (amostra nova) em texto.
+ */
+void task_stats_print() {
+    task_stats_sample();
+    printf("Tarefa        num  cpu(%%)  pilha livre(palavras)  laco max(us)  acordadas\n");
+    for (UBaseType_t i = 0; i < task_count; i++) {
+        printf("%-12s  %3u  %3u.%u  %5lu  %8lu  %9lu\n",
+               task_status[i].pcTaskName,
+               (unsigned)task_status[i].xTaskNumber,
+               cpu_permille[i] / 10, cpu_permille[i] % 10,
+               (unsigned long)task_status[i].usStackHighWaterMark,
+               (unsigned long)loop_max_us(task_status[i].xHandle),
+               (unsigned long)task_stats_wakeups(task_status[i].xHandle));
+    }
+    for (int core = 0; core < TASK_STATS_CORES; core++) {
+        printf("Nucleo %d: %3u.%u%% ocupado\n", core,
+               core_busy_permille[core] / 10, core_busy_permille[core] % 10);
+    }
+#if configSUPPORT_DYNAMIC_ALLOCATION
+    printf("Heap livre: %u bytes (minimo %u bytes)\n",
+           (unsigned)xPortGetFreeHeapSize(), (unsigned)xPortGetMinimumEverFreeHeapSize());
+#else
+    printf("Heap: nenhum (alocacao estatica)\n");
+#endif
+}
+
+static void put_u16(uint8_t *buf, size_t *pos, uint16_t value) {
+    buf[(*pos)++] = value & 0xFF;
+    buf[(*pos)++] = value >> 8;
+}
+
+static void put_u32(uint8_t *buf, size_t *pos, uint32_t value) {
+    put_u16(buf, pos, value & 0xFFFF);
+    put_u16(buf, pos, value >> 16);
+}
+
+/**
+ * @brief Envia uma amostra nova como quadro binário (little-endian).
+ *
+ * Payload: uptime_ms u32, heap livre u32, heap mínimo u32 (ambos 0 no build
+ * estático), n u8 e, para cada tarefa, número u8, estado u8, cpu em permil
+ * u16, pilha livre u16 (palavras) e laço máximo u32 (us).
+ */
+void task_stats_write_frame() {
+    static uint8_t frame[4 + 13 + TASK_STATS_MAX_TASKS * 10 + 1];
+    size_t pos = 4;
+
+    task_stats_sample();
+    put_u32(frame, &pos, (uint32_t)(time_us_64() / 1000));
+#if configSUPPORT_DYNAMIC_ALLOCATION
+    put_u32(frame, &pos, (uint32_t)xPortGetFreeHeapSize());
+    put_u32(frame, &pos, (uint32_t)xPortGetMinimumEverFreeHeapSize());
+#else
+    // Sem heap: os campos ficam em 0 e o formato do quadro não muda
+    put_u32(frame, &pos, 0);
+    put_u32(frame, &pos, 0);
+#endif
+    frame[pos++] = (uint8_t)task_count;
+    for (UBaseType_t i = 0; i < task_count; i++) {
+        uint32_t stack_free = task_status[i].usStackHighWaterMark;
+        frame[pos++] = (uint8_t)task_status[i].xTaskNumber;
+        frame[pos++] = (uint8_t)task_status[i].eCurrentState;
+        put_u16(frame, &pos, cpu_permille[i]);
+        put_u16(frame, &pos, stack_free > 0xFFFF ? 0xFFFF : (uint16_t)stack_free);
+        put_u32(frame, &pos, loop_max_us(task_status[i].xHandle));
+    }
+
+    frame[0] = TASK_STATS_SYNC0;
+    frame[1] = TASK_STATS_SYNC1;
+    frame[2] = TASK_STATS_FRAME_TYPE;
+    frame[3] = (uint8_t)(pos - 4);
+    uint8_t sum = 0;
+    for (size_t i = 2; i < pos; i++) {
+        sum += frame[i];
+    }
+    frame[pos++] = (uint8_t)(0x100 - sum);
+    fwrite(frame, 1, pos, stdout);
+    fflush(stdout);
+}
+
+/**
+ * @brief Gancho de estouro de pilha (configCHECK_FOR_STACK_OVERFLOW 2).
+ */
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName) {
+    (void)xTask;
+    panic("Estouro de pilha na tarefa %s\n", pcTaskName);
+}
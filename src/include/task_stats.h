@@ -0,0 +1,24 @@
+#ifndef TASK_STATS_H
+#define TASK_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TASK_STATS_MAX_TASKS   16  // tarefas acompanhadas (inclui idle e timer)
+#define TASK_STATS_TLS_INDEX   0   // ponteiro de TLS do FreeRTOS usado pela latência de laço
+
+// Quadro binário: A5 5A | tipo | tamanho | payload | checksum (soma de 8 bits = 0)
+#define TASK_STATS_SYNC0       0xA5
+#define TASK_STATS_SYNC1       0x5A
+#define TASK_STATS_FRAME_TYPE  0x01
+
+void task_stats_loop_start();
+void task_stats_loop_end();
+uint32_t task_stats_wakeups(TaskHandle_t handle);
+void task_stats_sample();
+void task_stats_print();
+void task_stats_write_frame();
+
+#endif // TASK_STATS_H
@@ -0,0 +1,58 @@
+#include "trace.h"
+#include "config.h"
+#include <stdio.h>
+
+trace_ring_t trace_rings[TRACE_CTX_COUNT];
+
+static uint32_t dropped_reported[TRACE_CTX_COUNT];
+
+/**
+ * @brief Esvazia todos os anéis, enviando um quadro binário por anel com eventos.
+ *        Deve ser chamada por uma única tarefa (o consumidor de todos os anéis).
+ */
+void trace_drain() {
+    static uint8_t frame[6 + TRACE_RING_SIZE * sizeof(trace_event_t) + 1];
+
+    for (int ctx = 0; ctx < TRACE_CTX_COUNT; ctx++) {
+        trace_ring_t *ring = &trace_rings[ctx];
+        uint32_t tail = ring->tail;
+        uint32_t head = ring->head;
+        __mem_fence_acquire(); // eventos lidos só depois do head
+        uint32_t count = head - tail;
+        uint32_t dropped = ring->dropped;
+        uint32_t new_drops = dropped - dropped_reported[ctx];
+        if (count == 0 && new_drops == 0) {
+            continue;
+        }
+
+        size_t pos = 0;
+        frame[pos++] = TRACE_SYNC0;
+        frame[pos++] = TRACE_SYNC1;
+        frame[pos++] = (uint8_t)ctx;
+        frame[pos++] = (uint8_t)count;
+        frame[pos++] = new_drops > 0xFFFF ? 0xFF : (uint8_t)(new_drops & 0xFF);
+        frame[pos++] = new_drops > 0xFFFF ? 0xFF : (uint8_t)(new_drops >> 8);
+        for (uint32_t i = 0; i < count; i++) {
+            const trace_event_t *ev = &ring->events[(tail + i) & (TRACE_RING_SIZE - 1)];
+            frame[pos++] = ev->timestamp_us & 0xFF;
+            frame[pos++] = (ev->timestamp_us >> 8) & 0xFF;
+            frame[pos++] = (ev->timestamp_us >> 16) & 0xFF;
+            frame[pos++] = ev->timestamp_us >> 24;
+            frame[pos++] = ev->type;
+            frame[pos++] = ev->ctx;
+            frame[pos++] = ev->arg & 0xFF;
+            frame[pos++] = ev->arg >> 8;
+        }
+        __mem_fence_release(); // cópia concluída antes de liberar as posições
+        ring->tail = tail + count;
+        dropped_reported[ctx] = dropped;
+
+        uint8_t sum = 0;
+        for (size_t i = 2; i < pos; i++) {
+            sum += frame[i];
+        }
+        frame[pos++] = (uint8_t)(0x100 - sum);
+        fwrite(frame, 1, pos, stdout);
+    }
+    fflush(stdout);
+}
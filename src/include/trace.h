@@ -0,0 +1,85 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "config.h"
+
+// Cada contexto escreve apenas no próprio anel (um produtor, um consumidor).
+// Todas as ISRs usam a mesma prioridade de NVIC e não se aninham, então
+// compartilham o anel TRACE_CTX_ISR. No build SMP isso continua valendo
+// porque todas as IRQs rastreadas são habilitadas no núcleo 0 (no main).
+typedef enum {
+    TRACE_CTX_ISR = 0,
+    TRACE_CTX_CONTROL,
+    TRACE_CTX_BUTTON,
+    TRACE_CTX_DISPLAY,
+    TRACE_CTX_MATRIX,
+    TRACE_CTX_COUNT
+} trace_ctx_t;
+
+typedef enum {
+    TRACE_EV_PHASE = 1,         // arg: novo estado do semáforo
+    TRACE_EV_MODE,              // arg: 1 = noturno, 0 = normal
+    TRACE_EV_BUTTON_EDGE,       // arg: GPIO
+    TRACE_EV_DEBOUNCE_REJECT,   // arg: GPIO
+    TRACE_EV_DISPLAY_FLUSH,     // início do envio do quadro
+    TRACE_EV_DISPLAY_DONE,      // arg: 1 = ok
+    TRACE_EV_MATRIX_FRAME,      // arg: 1 = ficou pendente (matriz ocupada)
+    TRACE_EV_MATRIX_LATCH,      // arg: 1 = enviou o quadro pendente em seguida
+    TRACE_EV_BUTTON_GESTURE,    // arg: botão << 8 | BUTTON_GESTURE_*
+} trace_event_type_t;
+
+/**
+ * @brief Evento de 8 bytes: timestamp do timer de 1 us, tipo, contexto e argumento.
+ */
+typedef struct {
+    uint32_t timestamp_us;
+    uint8_t type;
+    uint8_t ctx;
+    uint16_t arg;
+} trace_event_t;
+
+#define TRACE_RING_SIZE 64 // eventos por anel (potência de 2)
+
+// Quadro do dreno: A5 7E | ctx | n | descartados u16 | n * 8 bytes | checksum
+#define TRACE_SYNC0 0xA5
+#define TRACE_SYNC1 0x7E
+
+typedef struct {
+    trace_event_t events[TRACE_RING_SIZE];
+    volatile uint32_t head;     // escrito só pelo produtor
+    volatile uint32_t tail;     // escrito só pelo dreno
+    volatile uint32_t dropped;  // escrito só pelo produtor (anel cheio)
+} trace_ring_t;
+
+extern trace_ring_t trace_rings[TRACE_CTX_COUNT];
+
+/**
+ * @brief Registra um evento no anel do contexto, sem travas. Se o anel estiver
+ *        cheio o evento é descartado e contado.
+ */
+static inline void trace_event(trace_ctx_t ctx, trace_event_type_t type, uint16_t arg) {
+#if TRACE_ENABLED
+    trace_ring_t *ring = &trace_rings[ctx];
+    uint32_t head = ring->head;
+    if (head - ring->tail >= TRACE_RING_SIZE) {
+        ring->dropped++;
+        return;
+    }
+    trace_event_t *ev = &ring->events[head & (TRACE_RING_SIZE - 1)];
+    ev->timestamp_us = time_us_32();
+    ev->type = (uint8_t)type;
+    ev->ctx = (uint8_t)ctx;
+    ev->arg = arg;
+    __mem_fence_release(); // evento visível antes do novo head
+    ring->head = head + 1;
+#else
+    (void)ctx; (void)type; (void)arg;
+#endif
+}
+
+void trace_drain();
+
+#endif // TRACE_H
@@ -0,0 +1,23 @@
+#ifndef TRAFFIC_LIGHT_H
+#define TRAFFIC_LIGHT_H
+
+#include "signal_plan.h"
+
+/**
+ * @brief Passos do plano signal_plan_pedestrian (os estados originais do semáforo).
+ */
+typedef enum {
+    CARS_GREEN_LIGHT,        /**< Carro: sinal verde. Pedestre: pare. */
+    CARS_YELLOW_LIGHT,       /**< Carro: sinal amarelo. Pedestre: pare. */
+    CARS_PED_RED_LIGHT,      /**< Ambos os sinais vermelhos. */
+    CARS_RED_PEDS_WALK,      /**< Carro: vermelho. Pedestre: siga. */
+    CARS_RED_PEDS_FLASH,     /**< Carro: vermelho. Pedestre: sinal piscante. */
+    CARS_NIGHT_FLASHING,     /**< Modo noturno: amarelo piscando. */
+    TRAFFIC_LIGHT_STATE_COUNT
+} TrafficLight_states;
+
+// Grupos semafóricos do plano signal_plan_pedestrian
+#define SIGNAL_GROUP_CARS   0
+#define SIGNAL_GROUP_PEDS   1
+
+#endif // TRAFFIC_LIGHT_H
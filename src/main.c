@@ -1,33 +1,29 @@
 #include "config.h"
+#include "pico/bootrom.h"
+#include "adaptive_timing.h"
+#include "cycle_stats.h"
+#include "intersection.h"
 #include "display.h"
-
-/**
- * @brief Enumeração dos possíveis estados do semáforo para veículos e pedestres.
- */
-typedef enum {
-    CARS_GREEN_LIGHT,        /**< Carro: sinal verde. Pedestre: pare. */
-    CARS_YELLOW_LIGHT,       /**< Carro: sinal amarelo. Pedestre: pare. */
-    CARS_PED_RED_LIGHT,      /**< Ambos os sinais vermelhos. */
-    CARS_RED_PEDS_WALK,      /**< Carro: vermelho. Pedestre: siga. */
-    CARS_RED_PEDS_FLASH,     /**< Carro: vermelho. Pedestre: sinal piscante. */
-    CARS_NIGHT_FLASHING      /**< Modo noturno: amarelo piscando. */
-} TrafficLight_states;
-
-const char* actual_state(TrafficLight_states state) {
-    switch (state) {
-        case CARS_GREEN_LIGHT:      return "Carro: Sinal Verde / Pedestre Vermelho";
-        case CARS_YELLOW_LIGHT:     return "Carro: Sinal Amarelo / Pedestre Vermelho";
-        case CARS_PED_RED_LIGHT:    return "Todos Vermelhos (Troca Segura)";
-        case CARS_RED_PEDS_WALK:    return "Carro: Sinal Vermelho / Pedestre: Sinal Verde (Andando)";
-        case CARS_RED_PEDS_FLASH:   return "Carro: Sinal Vermelho / Pedestre: Sinal Vermelho (Piscando)";
-        case CARS_NIGHT_FLASHING:   return "Modo Noturno (Amarelo Piscando)";
-        default:                    return "Semaforo com defeito";
-    }
-}
+#include "ped_call.h"
+#include "power_stats.h"
+#include "static_memory.h"
+#include "task_stats.h"
+#include "trace.h"
 
 volatile bool flagModoNoturno = false; //Flag global que indica se o modo noturno está ativado.
-volatile TrafficLight_states trafficLight_state = CARS_PED_RED_LIGHT; //Estado atual do semáforo. inicia com ambos os sinais em vermelho
+static const signal_plan_t *signal_plan = &SIGNAL_PLAN; //Plano de sinalização executado pelo controle
+volatile uint8_t signal_step = 0; //Passo atual do plano. inicia no passo seguro (todos vermelhos), definido no main
+static volatile bool signal_actuated = SIGNAL_ACTUATED; //Travessia só com chamada (comandos "atuado"/"fixo" do console)
+static adaptive_timing_t adaptive_timing; //Demanda por grupo e durações em uso (comandos "adaptativo"/"tabela")
+static intersection_t intersections[INTERSECTION_COUNT]; //Cruzamentos controlados; [0] é o da placa (LEDs, matriz, display)
+static intersection_t *intersection_heap[INTERSECTION_COUNT]; //Armazenamento do heap de prazos
+static intersection_scheduler_t scheduler; //Heap mínimo dos próximos prazos, avançado pela tarefa de controle
 static ssd1306_t display; //controle do display
+static EventGroupHandle_t xStateEvents = NULL; //publica mudanças de estado/modo, um bit por tarefa assinante
+static TaskHandle_t xDisplayTaskHandle = NULL; //tarefa do display (recebe o evento de fim de envio)
+static TaskHandle_t xConsoleTaskHandle = NULL; //tarefa do console serial (acordada quando chegam caracteres)
+static volatile uint64_t display_change_time_us = 0; //instante da primeira mudança ainda não exibida (0 = nenhuma)
+static volatile uint64_t display_on_glass_time_us = 0; //instante em que o último quadro terminou de ser enviado
 
 //Inicializa todos os sistemas: UART, botões, buzzer, matriz de LEDs, display e LEDs RGB.
 void init_system_all() {
@@ -44,339 +40,559 @@ void init_system_all() {
     gpio_init(LED_BLUE_PIN); gpio_set_dir(LED_BLUE_PIN, GPIO_OUT); gpio_put(LED_BLUE_PIN, 0);
 }
 
+/**
+ * @brief Publica que o modo ou o estado do semáforo mudou, acordando as tarefas
+ *        assinantes indicadas. Guarda o instante da mudança para medir a
+ *        latência até o painel.
+ */
+static void state_publish(EventBits_t subscribers) {
+    // Seção crítica: o display pode estar lendo o valor de 64 bits no outro núcleo
+    taskENTER_CRITICAL();
+    if (display_change_time_us == 0) {
+        display_change_time_us = time_us_64();
+    }
+    taskEXIT_CRITICAL();
+    xEventGroupSetBits(xStateEvents, subscribers);
+}
+
+/**
+ * @brief Bloqueia a tarefa assinante até a próxima mudança publicada ou até o timeout.
+ *        Consome apenas o bit da própria tarefa.
+ * @return true se houve mudança, false se o tempo esgotou.
+ */
+static bool state_wait(EventBits_t subscriber, TickType_t timeout) {
+    return (xEventGroupWaitBits(xStateEvents, subscriber, pdTRUE, pdFALSE, timeout) & subscriber) != 0;
+}
+
+/**
+ * @brief Cria uma tarefa restrita aos núcleos da máscara (CORE_MASK_*).
+ *        Sem SMP a máscara é ignorada e a tarefa é criada normalmente.
+ *        No build estático usa a pilha e o TCB de TASK_MEMORY (stack_depth
+ *        deve ser o tamanho dessa pilha); no dinâmico eles são NULL.
+ */
+static void task_create_on(TaskFunction_t task, const char *name, configSTACK_DEPTH_TYPE stack_depth,
+                           UBaseType_t priority, UBaseType_t core_mask,
+                           StackType_t *stack, StaticTask_t *tcb, TaskHandle_t *handle) {
+    TaskHandle_t created;
+#if configSUPPORT_STATIC_ALLOCATION
+#if (configNUMBER_OF_CORES > 1) && (configUSE_CORE_AFFINITY == 1)
+    created = xTaskCreateStaticAffinitySet(task, name, stack_depth, NULL, priority, stack, tcb, core_mask);
+#else
+    (void)core_mask;
+    created = xTaskCreateStatic(task, name, stack_depth, NULL, priority, stack, tcb);
+#endif
+#else
+    (void)stack;
+    (void)tcb;
+#if (configNUMBER_OF_CORES > 1) && (configUSE_CORE_AFFINITY == 1)
+    xTaskCreateAffinitySet(task, name, stack_depth, NULL, priority, core_mask, &created);
+#else
+    (void)core_mask;
+    xTaskCreate(task, name, stack_depth, NULL, priority, &created);
+#endif
+#endif
+    configASSERT(created != NULL);
+    if (handle != NULL) {
+        *handle = created;
+    }
+}
+
+/**
+ * @brief Ticks restantes até um prazo absoluto (0 se já passou).
+ */
+static TickType_t ticks_until(TickType_t deadline) {
+    TickType_t remaining = deadline - xTaskGetTickCount();
+    return (remaining > (portMAX_DELAY / 2)) ? 0 : remaining;
+}
+
+/**
+ * @brief Atualiza o passo global do plano e publica se houve mudança.
+ */
+static void set_signal_step(uint8_t new_step) {
+    if (signal_step != new_step) {
+        signal_step = new_step;
+        trace_event(TRACE_CTX_CONTROL, TRACE_EV_PHASE, new_step);
+        power_stats_set_phase(new_step);
+        // O controle é quem publica as transições; só as saídas precisam acordar
+        state_publish(STATE_EVENT_ALL & ~STATE_EVENT_CONTROL);
+    }
+}
+
+/**
+ * @brief Chamada de pedestre (toque no botão B): registra, confirma com dois
+ *        bipes e a lâmpada da matriz e acorda o controle (verde em descanso).
+ */
+static void pedestrian_call(uint32_t time_us) {
+    if (flagModoNoturno) {
+        printf("Chamada de pedestre ignorada (modo noturno)\n");
+        return;
+    }
+    // Todo toque conta como demanda da travessia, mesmo sem atuação
+    adaptive_timing_arrival(&adaptive_timing, signal_plan->pedestrian_group);
+    if (signal_plan->call_step == SIGNAL_NO_STEP) {
+        printf("Chamada de pedestre contada como demanda (plano sem travessia atuada)\n");
+        return;
+    }
+    if (signal_step == signal_plan->call_step) {
+        printf("Chamada de pedestre: travessia em andamento\n");
+        return;
+    }
+    bool is_new = ped_call_register(&intersections[0].calls, time_us);
+    buzzer_play_tone_pattern(BUZZER_CALL_TONE, BUZZER_CALL_ON_MS, BUZZER_CALL_OFF_MS, 2);
+    if (is_new) {
+        // Não é mudança de passo: acorda só o controle e a matriz (lâmpada), sem o display
+        xEventGroupSetBits(xStateEvents, STATE_EVENT_CONTROL | STATE_EVENT_MATRIX);
+    }
+    printf("Chamada de pedestre %s\n", is_new ? "registrada" : "ja registrada");
+}
+
+/**
+ * @brief Entrada dos detectores veiculares (contexto de interrupção): soma a
+ *        chegada à demanda do grupo no controle adaptativo.
+ */
+void detector_arrival_from_isr(uint8_t group) {
+    adaptive_timing_arrival_from_isr(&adaptive_timing, group);
+}
+
+intersection_t *intersection_board(void) {
+    return &intersections[0];
+}
+
+const intersection_scheduler_t *intersection_scheduler(void) {
+    return &scheduler;
+}
+
+/**
+ * @brief Callback de fim de envio do display. Normalmente vem da interrupção
+ *        do I2C; sem nada a enviar, ssd1306_flush_async o chama direto da
+ *        tarefa do display. Notifica a tarefa de que o quadro já está no painel.
+ */
+static void display_flush_done(void *user_data) {
+    display_on_glass_time_us = time_us_64();
+    if (!__get_current_exception()) {
+        // Contexto de tarefa: API normal, e o evento vai para o anel da própria tarefa
+        trace_event(TRACE_CTX_DISPLAY, TRACE_EV_DISPLAY_DONE, 1);
+        xTaskNotify(xDisplayTaskHandle, DISPLAY_EVENT_FLUSH_DONE, eSetBits);
+        return;
+    }
+    BaseType_t higher_priority_woken = pdFALSE;
+    trace_event(TRACE_CTX_ISR, TRACE_EV_DISPLAY_DONE, 1);
+    xTaskNotifyFromISR(xDisplayTaskHandle, DISPLAY_EVENT_FLUSH_DONE, eSetBits, &higher_priority_woken);
+    portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+/**
+ * @brief Bloqueia a tarefa do display até que algum dos eventos pedidos chegue.
+ *        Eventos recebidos fora de ordem ficam guardados em pending_events.
+ * @return true se o evento chegou, false se o tempo esgotou.
+ */
+static bool display_wait_event(uint32_t *pending_events, uint32_t wanted, TickType_t timeout) {
+    uint32_t received;
+    while ((*pending_events & wanted) == 0) {
+        if (xTaskNotifyWait(0, UINT32_MAX, &received, timeout) != pdTRUE) {
+            return false;
+        }
+        *pending_events |= received;
+    }
+    *pending_events &= ~wanted;
+    return true;
+}
+
 /**
  * @brief Tarefa responsável por atualizar o conteúdo exibido no display OLED.
  *        Mostra o modo atual (Normal/Noturno) e o estado dos semáforos.
+ *        Só redesenha quando uma mudança é publicada, com uma atualização
+ *        lenta de segurança, e informa a latência entre a mudança e o quadro no painel.
  */
 void vDisplayUpdateTask() {
     ssd1306_t *ssd = &display;
-    char mode_str[15];
-    char state_str[40];
+    uint32_t pending_events = 0;
+    uint32_t max_latency_us = 0;
 
     while (true) {
-        bool is_night_mode = flagModoNoturno;
-        TrafficLight_states current_state = trafficLight_state;
-
-        // Define as strings a serem exibidas com base no modo e estado
-        if (is_night_mode) {
-            strcpy(mode_str, "MODO: NOTURNO");
-            strcpy(state_str, "Carro: Amarelo Piscando.");
-        } else {
-            strcpy(mode_str, "MODO: NORMAL ");
-            switch(current_state) {
-                case CARS_GREEN_LIGHT:         strcpy(state_str, "Carro: Siga    \nPed: Pare"); break;
-                case CARS_YELLOW_LIGHT:        strcpy(state_str, "Carro: Atenção!  \nPed: Pare"); break;
-                case CARS_PED_RED_LIGHT:       strcpy(state_str, "Carro: Pare \nPed: Pare"); break;
-                case CARS_RED_PEDS_WALK:       strcpy(state_str, "Carro: Pare \nPed: Siga"); break;
-                case CARS_RED_PEDS_FLASH:      strcpy(state_str, "Carro: Pare \nPed: Piscando"); break;
-                default:                       strcpy(state_str, "Erro no semaforo"); break;
+        // Aguarda uma mudança de estado/modo ou o tempo da atualização de segurança
+        state_wait(STATE_EVENT_DISPLAY, pdMS_TO_TICKS(DISPLAY_REFRESH_FALLBACK_MS));
+        task_stats_loop_start();
+        taskENTER_CRITICAL();
+        uint64_t change_time_us = display_change_time_us;
+        display_change_time_us = 0;
+        taskEXIT_CRITICAL();
+
+        // Copia a tela pronta do cache (ou a desenha, se o cache estiver desabilitado)
+        display_show_state(ssd, flagModoNoturno, signal_step);
+        // Envia via DMA apenas as regiões que mudaram e bloqueia (sem ocupar a CPU)
+        // até o fim da transferência. Se o barramento recusar, as regiões continuam
+        // marcadas e seguem no próximo quadro.
+        trace_event(TRACE_CTX_DISPLAY, TRACE_EV_DISPLAY_FLUSH, 0);
+        if (ssd1306_flush_async(ssd, display_flush_done, NULL) &&
+            display_wait_event(&pending_events, DISPLAY_EVENT_FLUSH_DONE, pdMS_TO_TICKS(DISPLAY_FLUSH_TIMEOUT_MS)) &&
+            change_time_us != 0) {
+            uint32_t latency_us = (uint32_t)(display_on_glass_time_us - change_time_us);
+            if (latency_us > max_latency_us) {
+                max_latency_us = latency_us;
             }
+            printf("Display: latencia mudanca->painel %lu us (max %lu us)\n",
+                   (unsigned long)latency_us, (unsigned long)max_latency_us);
         }
-
-        // Limpa e redesenha o display
-        ssd1306_fill(ssd, false);
-        ssd1306_rect(ssd, 0, 0, 127, 63, true, 0);
-        ssd1306_draw_string(ssd, mode_str, 5, 8);
-        ssd1306_hline(ssd, 1, 126, 31, true);
-        ssd1306_draw_string(ssd, state_str, 5, 36);
-        ssd1306_send_data(ssd);
-
-        // Aguarda antes da próxima atualização
-        vTaskDelay(pdMS_TO_TICKS(DISPLAY_UPDATE_DELAY_MS));
+        task_stats_loop_end();
     }
 }
 
 /**
- * @brief Tarefa responsável por monitorar o botão A e alternar entre modo normal e noturno.
- *        Toca um breve som no buzzer ao alternar o modo.
+ * @brief Tarefa dos botões: bloqueia até a fila de bordas produzir um gesto.
+ *        Botão A (toque): alterna entre modo normal e noturno, com um breve som no buzzer.
+ *        Botão B (toque): registra uma chamada de pedestre.
+ *        Informa a latência entre o gesto decidido (borda na ISR) e a ação concluída.
  */
 void vButtonTask() {
+    uint32_t max_latency_us = 0;
+    button_gesture_event_t gesture;
+
     while (true) {
-        // Verifica se o botão A foi pressionado
-        if (button_a_pressed()) {
+        buttons_wait_gesture(&gesture, portMAX_DELAY);
+        task_stats_loop_start();
+        if (gesture.button == BUTTON_A && gesture.gesture == BUTTON_GESTURE_PRESS) {
             // Inverte o estado do modo noturno
             flagModoNoturno = !flagModoNoturno;
-            printf("Modo Noturno: %s\n", flagModoNoturno ? "ON" : "OFF");
+            state_publish(STATE_EVENT_ALL);
+            trace_event(TRACE_CTX_BUTTON, TRACE_EV_MODE, flagModoNoturno);
             // Toca um tom curto para indicar a mudança
-            buzzer_play_tone(440, 30);
+            buzzer_play_tone_pattern(BUZZER_MODE_TONE, BUZZER_MODE_ON_MS, 0, 1);
+        } else if (gesture.button == BUTTON_B && gesture.gesture == BUTTON_GESTURE_PRESS) {
+            pedestrian_call(gesture.time_us);
+        }
+        uint32_t latency_us = time_us_32() - gesture.time_us;
+        if (latency_us > max_latency_us) {
+            max_latency_us = latency_us;
+        }
+        printf("Botao %c: %s, latencia botao->acao %lu us (max %lu us, %lu bordas perdidas)\n",
+               'A' + gesture.button, button_gesture_name(gesture.gesture),
+               (unsigned long)latency_us, (unsigned long)max_latency_us,
+               (unsigned long)buttons_dropped_edges());
+        if (gesture.button == BUTTON_A) {
+            printf("Modo Noturno: %s\n", flagModoNoturno ? "ON" : "OFF");
+            // Relatório do idle tickless acumulado até aqui
+            power_stats_print();
         }
-        // Aguarda antes de verificar novamente
-        vTaskDelay(pdMS_TO_TICKS(BUTTON_TASK_DELAY_MS));
+        task_stats_loop_end();
     }
 }
 
 /**
- * @brief Tarefa de controle geral que realiza a transição dos estados do semáforo.
- *        Avança pelos estados normais ou entra/mantém o estado noturno piscante.
+ * @brief Saídas do cruzamento da placa: publica o passo para as tarefas de
+ *        LED, matriz, buzzer e display e mede a precisão das fronteiras.
+ */
+static void board_output(intersection_t *intersection, TickType_t boundary, intersection_event_t event) {
+    const signal_step_t *step = signal_engine_current(&intersection->engine);
+    if (event == INTERSECTION_EVENT_RESTART) {
+        cycle_stats_rebase(boundary);
+    } else if (event == INTERSECTION_EVENT_STEP) {
+        cycle_stats_boundary(boundary, step->cycle_start);
+    }
+    printf("ESTADO ATUAL: %s\n", step->name);
+    set_signal_step(intersection->engine.step);
+}
+
+/**
+ * @brief Tarefa de controle geral: uma só tarefa avança todos os cruzamentos.
+ *        Dorme até o prazo mais próximo do heap ou até uma troca de modo /
+ *        chamada de pedestre, e encerra os passos vencidos.
+ *        Cada fronteira de passo é um prazo absoluto (base + soma das durações),
+ *        então o tempo do printf e a latência de escalonamento não se acumulam.
+ *        As durações vêm da tabela ou do ajuste adaptativo (cruzamento da placa).
  */
 void vGeneralControlTask() {
-    // Inicializa com um estado definido e sua duração
-    TrafficLight_states current_state = CARS_PED_RED_LIGHT;
-    trafficLight_state = current_state;
-    uint32_t current_state_duration_ms = TIME_ALL_RED_MS;
-    while (true) {
-        printf("ESTADO ATUAL: %s\n", actual_state(current_state));
-        // Aguarda a duração do estado atual
-        vTaskDelay(pdMS_TO_TICKS(current_state_duration_ms));
-        // Lê o estado do modo noturno
-        bool night_mode_active = flagModoNoturno;
-        TrafficLight_states next_state;
-
-        // Lógica para modo noturno
-        if (night_mode_active) {
-            // Se não estiver no modo noturno, muda para ele
-            if (current_state != CARS_NIGHT_FLASHING) {
-                next_state = CARS_NIGHT_FLASHING;
-                current_state_duration_ms = 100; // Duração pequena para o estado de transição (não usado diretamente no loop)
-            } else {
-                // Se já está no modo noturno, apenas continua nele
-                current_state = CARS_NIGHT_FLASHING;
-                trafficLight_state = current_state;
-                vTaskDelay(pdMS_TO_TICKS(100)); // Pequeno delay para evitar busy-waiting
-                continue; // Volta ao início do loop sem mudar o estado
-            }
-        } else { // Lógica para modo normal
-            // Se estava saindo do modo noturno, volta para um estado inicial seguro
-            if (current_state == CARS_NIGHT_FLASHING) {
-                current_state = CARS_PED_RED_LIGHT;
-                current_state_duration_ms = TIME_ALL_RED_MS;
-                // Não define next_state aqui, pois o switch fará isso
-            }
+    // Todos partem do passo seguro do plano (todos vermelhos), defasados entre si
+    TickType_t now = xTaskGetTickCount();
+    uint32_t cycle_ms = signal_plan_cycle_ms(signal_plan);
+    intersection_scheduler_init(&scheduler, intersection_heap, INTERSECTION_COUNT);
+    for (uint16_t i = 0; i < INTERSECTION_COUNT; ++i) {
+        intersection_init(&intersections[i], signal_plan, i == 0 ? &adaptive_timing : NULL,
+                          i == 0 ? board_output : NULL);
+        intersection_set_mode(&scheduler, &intersections[i], false, signal_actuated, now);
+        intersection_start(&scheduler, &intersections[i], now,
+                           cycle_ms ? (uint32_t)((uint64_t)i * INTERSECTION_OFFSET_MS % cycle_ms) : 0);
+    }
+    bool applied_night = false;
+    bool applied_actuated = signal_actuated;
 
-            // Determina o próximo estado e sua duração com base no estado atual
-            switch (current_state) {
-                case CARS_GREEN_LIGHT:
-                    current_state_duration_ms = TIME_CARS_YELLOW_MS;
-                    next_state = CARS_YELLOW_LIGHT;
-                    break;
-                case CARS_YELLOW_LIGHT:
-                    current_state_duration_ms = TIME_ALL_RED_MS;
-                    next_state = CARS_PED_RED_LIGHT;
-                    break;
-                case CARS_PED_RED_LIGHT:
-                    current_state_duration_ms = TIME_PEDS_WALK_MS;
-                    next_state = CARS_RED_PEDS_WALK;
-                    break;
-                case CARS_RED_PEDS_WALK:
-                    current_state_duration_ms = TIME_PEDS_FLASH_MS;
-                    next_state = CARS_RED_PEDS_FLASH;
-                    break;
-                case CARS_RED_PEDS_FLASH:
-                    current_state_duration_ms = TIME_ALL_RED_MS;
-                    next_state = CARS_GREEN_LIGHT;
-                    break;
-                default: // Estado de erro ou inesperado
-                    printf("Erro na mudança dos estados\n");
-                    current_state = CARS_YELLOW_LIGHT; // Volta para um estado seguro
-                    current_state_duration_ms = TIME_ALL_RED_MS; //tempo maior
-                    next_state = CARS_PED_RED_LIGHT;
-                    break;
+    while (true) {
+        TickType_t deadline;
+        TickType_t timeout = intersection_scheduler_next(&scheduler, &deadline) ? ticks_until(deadline) : portMAX_DELAY;
+        bool event = state_wait(STATE_EVENT_CONTROL, timeout);
+        task_stats_loop_start();
+        now = xTaskGetTickCount();
+        if (event) {
+            // Troca de modo vale para todos (O(N), só quando muda); chamada, só para a placa
+            bool night = flagModoNoturno;
+            bool actuated = signal_actuated;
+            uint16_t count = (night != applied_night || actuated != applied_actuated) ? INTERSECTION_COUNT : 1;
+            for (uint16_t i = 0; i < count; ++i) {
+                intersection_set_mode(&scheduler, &intersections[i], night, actuated, now);
             }
+            applied_night = night;
+            applied_actuated = actuated;
         }
-
-        // Atualiza o estado atual para o próximo estado calculado
-        current_state = next_state;
-        // Atualiza a variável global de estado para outras tarefas
-        trafficLight_state = current_state;
+        intersection_scheduler_run(&scheduler, now);
+        task_stats_loop_end();
     }
 }
 
 /**
  * @brief Tarefa responsável por controlar o LED RGB que representa o semáforo dos veículos.
- *        Acende as cores Verde, Amarelo ou Vermelho conforme o estado, ou pisca Amarelo no modo noturno.
+ *        Acende as cores Verde, Amarelo ou Vermelho conforme a indicação do grupo veicular
+ *        do plano, ou pisca Amarelo/Vermelho nos passos piscantes.
+ *        Dorme até a próxima mudança publicada ou, no modo noturno, até a próxima troca do pisca.
  */
 void vRgbLedTask() {
-    bool yellow_flash_state = false; // Estado do amarelo no modo noturno (ligado/desligado)
-    uint32_t last_flash_time = 0; // Tempo do último pisca
+    bool yellow_flash_state = false; // Estado do pisca (ligado/desligado)
+    TickType_t next_flash_tick = 0; // Prazo da próxima troca do pisca
+    uint8_t last_indication = UINT8_MAX;
 
     while(true) {
-        // Lê o estado atual do semáforo
-        TrafficLight_states tf_state = trafficLight_state;
-        uint32_t current_tick_time = xTaskGetTickCount(); // Tempo atual em ticks
-
-        // Controla o LED RGB com base no estado
-        switch(tf_state) {
-            case CARS_GREEN_LIGHT: // Verde
+        task_stats_loop_start();
+        // Lê a indicação atual do grupo veicular
+        signal_indication_t indication = signal_plan_indication(signal_plan, signal_step, signal_plan->vehicle_group);
+        bool state_changed = (indication != last_indication);
+        last_indication = indication;
+        TickType_t timeout = portMAX_DELAY;
+
+        // Controla o LED RGB com base na indicação
+        switch(indication) {
+            case SIGNAL_GREEN: // Verde
                 gpio_put(LED_RED_PIN, 0); gpio_put(LED_BLUE_PIN, 0); gpio_put(LED_GREEN_PIN, 1);
                 break;
-            case CARS_YELLOW_LIGHT: // Amarelo (Vermelho + Verde)
+            case SIGNAL_YELLOW: // Amarelo (Vermelho + Verde)
                 gpio_put(LED_RED_PIN, 1); gpio_put(LED_BLUE_PIN, 0); gpio_put(LED_GREEN_PIN, 1);
                 break;
-            case CARS_PED_RED_LIGHT: // Vermelho
-            case CARS_RED_PEDS_WALK: // Vermelho
-            case CARS_RED_PEDS_FLASH: // Vermelho
-                gpio_put(LED_RED_PIN, 1); gpio_put(LED_BLUE_PIN, 0); gpio_put(LED_GREEN_PIN, 0);
+            case SIGNAL_DARK: // Apagado
+                gpio_put(LED_RED_PIN, 0); gpio_put(LED_BLUE_PIN, 0); gpio_put(LED_GREEN_PIN, 0);
                 break;
-            case CARS_NIGHT_FLASHING: // Amarelo Piscando
-                // Verifica se passou tempo suficiente para inverter o estado do pisca
-                if ((current_tick_time - last_flash_time) >= pdMS_TO_TICKS(TIME_NIGHT_FLASH_ON_MS)) {
-                    yellow_flash_state = !yellow_flash_state; // Inverte o estado
+            case SIGNAL_FLASH_YELLOW: // Amarelo Piscando
+            case SIGNAL_FLASH_RED:    // Vermelho Piscando
+                // Ao entrar no modo o pisca começa aceso; depois inverte a cada prazo
+                if (state_changed || ticks_until(next_flash_tick) == 0) {
+                    yellow_flash_state = state_changed ? true : !yellow_flash_state;
                     gpio_put(LED_BLUE_PIN, 0); // Azul sempre desligado
-                    // Acende ou apaga Vermelho e Verde juntos para formar Amarelo
-                    gpio_put(LED_GREEN_PIN, yellow_flash_state);
+                    // Acende ou apaga Vermelho (e Verde junto, para formar Amarelo)
+                    gpio_put(LED_GREEN_PIN, yellow_flash_state && indication == SIGNAL_FLASH_YELLOW);
                     gpio_put(LED_RED_PIN, yellow_flash_state);
-                    last_flash_time = current_tick_time; // Atualiza o tempo do último pisca
+                    next_flash_tick = xTaskGetTickCount() + pdMS_TO_TICKS(yellow_flash_state ? TIME_NIGHT_FLASH_ON_MS
+                                                                                             : TIME_NIGHT_FLASH_OFF_MS);
                 }
+                timeout = ticks_until(next_flash_tick);
                 break;
-            default: // Estado inesperado, assume Vermelho por segurança
+            case SIGNAL_RED: // Vermelho
+            default: // Indicação inesperada, assume Vermelho por segurança
                 gpio_put(LED_RED_PIN, 1); gpio_put(LED_BLUE_PIN, 0); gpio_put(LED_GREEN_PIN, 0);
                 break;
         }
 
-        // Aguarda antes da próxima verificação
-        vTaskDelay(pdMS_TO_TICKS(RGB_LED_TASK_DELAY_MS));
+        task_stats_loop_end();
+        // Aguarda a próxima mudança de estado ou o prazo do pisca
+        state_wait(STATE_EVENT_RGB_LED, timeout);
     }
 }
 
 /**
  * @brief Tarefa que controla a matriz de LEDs indicando o estado do semáforo de pedestres.
- *        Mostra "Ande" (Walk), "Pare" (Don't Walk) ou pisca "Pare", ou apaga no modo noturno.
+ *        Mostra "Ande" (Walk), "Pare" (Don't Walk) ou pisca "Pare" conforme a indicação do
+ *        grupo de pedestres do plano, ou apaga quando o grupo está apagado (modo noturno).
+ *        Dorme até a próxima mudança publicada ou, na fase piscante, até a próxima troca do pisca.
  */
 void vLedMatrixTask() {
     bool ped_flash_state = false; // Estado do pisca-pisca do pedestre (ligado/desligado)
-    uint32_t last_ped_flash_time = 0; // Tempo do último pisca do pedestre
-    // Guarda a fase anterior para detectar mudanças e reiniciar o pisca
-    TrafficLight_states last_known_phase = CARS_GREEN_LIGHT;
+    TickType_t next_ped_flash_tick = 0; // Prazo da próxima troca do pisca
+    // Guarda a indicação anterior para detectar mudanças e reiniciar o pisca
+    uint8_t last_indication = UINT8_MAX;
 
     while(true) {
-        // Lê o estado atual do semáforo
-        TrafficLight_states tf_state = trafficLight_state;
-        uint32_t current_tick_time = xTaskGetTickCount(); // Tempo atual em ticks
-
-        // Se a fase muda, reinicia o estado do pisca e o tempo
-        if (tf_state != last_known_phase) {
-            // Garante que o pisca comece no estado correto (normalmente apagado no início do flash)
-            ped_flash_state = (tf_state == CARS_RED_PEDS_FLASH) ? false : true; // Inicia piscando ou mostra estático
-            last_ped_flash_time = current_tick_time; // Reseta o timer do pisca
-            last_known_phase = tf_state; // Atualiza a última fase conhecida
-        }
-
-        // Controla a matriz de LEDs com base no estado
-        switch(tf_state) {
-            case CARS_RED_PEDS_WALK: // Pedestre: Siga (Walk)
+        task_stats_loop_start();
+        // Lê a indicação atual do grupo de pedestres
+        signal_indication_t indication = signal_plan_indication(signal_plan, signal_step, signal_plan->pedestrian_group);
+        bool phase_changed = (indication != last_indication);
+        last_indication = indication;
+        TickType_t timeout = portMAX_DELAY;
+        // Lâmpada "aguarde" enquanto há chamada de pedestre registrada
+        led_matrix_set_call_lamp(ped_call_pending(&intersections[0].calls) && indication != SIGNAL_DARK);
+
+        // Controla a matriz de LEDs com base na indicação
+        switch(indication) {
+            case SIGNAL_WALK: // Pedestre: Siga (Walk)
                 led_matrix_ped_walk();
                 break;
-            case CARS_RED_PEDS_FLASH: // Pedestre: Pisca Vermelho (Don't Walk Flashing)
-                // Verifica se passou metade do intervalo do pisca para inverter o estado
-                if ((current_tick_time - last_ped_flash_time) >= pdMS_TO_TICKS(TIME_PEDS_FLASH_INTERVAL_MS / 2)) {
-                    ped_flash_state = !ped_flash_state; // Inverte o estado do pisca
+            case SIGNAL_FLASH_DONT_WALK: // Pedestre: Pisca Vermelho (Don't Walk Flashing)
+                // O pisca começa apagado na entrada da fase e inverte a cada meio intervalo
+                if (phase_changed || ticks_until(next_ped_flash_tick) == 0) {
+                    ped_flash_state = phase_changed ? false : !ped_flash_state;
                     // Mostra ou apaga o ícone "Don't Walk"
                     led_matrix_ped_dont_walk(ped_flash_state);
-                    last_ped_flash_time = current_tick_time; // Atualiza o tempo do último pisca
-                }
-                // Garante que se o estado for true (mostrar ícone), ele permaneça visível até o próximo flip
-                // (Esta condição pode ser redundante dependendo da implementação exata do `led_matrix_ped_dont_walk`)
-                else if (ped_flash_state != false) {
-                    led_matrix_ped_dont_walk(true);
+                    next_ped_flash_tick = xTaskGetTickCount() + pdMS_TO_TICKS(TIME_PEDS_FLASH_INTERVAL_MS / 2);
                 }
+                timeout = ticks_until(next_ped_flash_tick);
                 break;
-            case CARS_NIGHT_FLASHING: // Modo Noturno: Matriz apagada
+            case SIGNAL_DARK: // Modo Noturno: Matriz apagada
                 led_matrix_clear();
                 break;
-            case CARS_GREEN_LIGHT:    // Carro Verde => Pedestre: Pare
-            case CARS_YELLOW_LIGHT:   // Carro Amarelo => Pedestre: Pare
-            case CARS_PED_RED_LIGHT:  // Ambos Vermelhos => Pedestre: Pare
-            default:                  // Estado Padrão/Erro => Pedestre: Pare
+            case SIGNAL_DONT_WALK: // Pedestre: Pare
+            default:               // Indicação inesperada => Pedestre: Pare
                 led_matrix_ped_dont_walk(true); // Mostra "Don't Walk" estático
                 break;
         }
-        // Aguarda antes da próxima atualização
-        vTaskDelay(pdMS_TO_TICKS(MATRIX_TASK_DELAY_MS));
+        task_stats_loop_end();
+        // Aguarda a próxima mudança de estado ou o prazo do pisca
+        state_wait(STATE_EVENT_MATRIX, timeout);
     }
 }
 
 /**
  * @brief Tarefa que controla o buzzer para emitir sons de alerta para pedestres.
- *        Usa lógica simplificada baseada em ciclos ON/OFF para diferentes fases.
+ *        A cada mudança publicada troca o padrão de fundo do sequenciador; os
+ *        ciclos ON/OFF são tocados pelo alarme de hardware, então a tarefa só
+ *        acorda nas transições.
  */
 void vBuzzerTask() {
 
-    // Guarda o tick do FreeRTOS quando a fase que precisa de som começou.
-    uint32_t phase_start_tick = 0;
-    // Guarda a última fase conhecida para detectar mudanças.
-    TrafficLight_states last_known_phase_buz = trafficLight_state;
-    // Flag interna para decidir se o som deve ser tocado nesta iteração.
-    bool play_sound = false;
-    // Define um tempo de espera fixo para o loop da tarefa (em ms).
-    const uint32_t LOOP_DELAY_MS = 50;
-    const TickType_t loop_delay_ticks = pdMS_TO_TICKS(LOOP_DELAY_MS);
-
-    // Inicializa o contador de ticks de início da fase.
-    phase_start_tick = xTaskGetTickCount();
+    // Guarda a última indicação conhecida para detectar mudanças (valor inválido força a 1a configuração).
+    uint8_t last_indication = UINT8_MAX;
 
     while(true) {
-        // Lê a fase atual do semáforo.
-        TrafficLight_states current_phase = trafficLight_state;
-        // Obtém o tempo atual em ticks do FreeRTOS.
-        uint32_t current_tick = xTaskGetTickCount();
-        // Variáveis para guardar os parâmetros do som da fase atual.
-        uint32_t freq = 0;
-        uint32_t on_duration_ms = 0;
-        uint32_t off_duration_ms = 0;
-        uint32_t cycle_duration_ms = 0;
-
-        // --- Resetar Timer na Mudança de Fase ---
-        if (current_phase != last_known_phase_buz) {
-            last_known_phase_buz = current_phase;
-            phase_start_tick = current_tick;
-            play_sound = false; // Começa silencioso
-            buzzer_play_tone(0, 0); // Garante que o buzzer está desligado
+        task_stats_loop_start();
+        // Lê a indicação atual do grupo de pedestres.
+        signal_indication_t indication = signal_plan_indication(signal_plan, signal_step, signal_plan->pedestrian_group);
+
+        // --- Troca o Padrão na Mudança de Indicação ---
+        if (indication != last_indication) {
+            last_indication = indication;
+            switch(indication) {
+                case SIGNAL_WALK:
+                    buzzer_play_tone_pattern(BUZZER_WALK_TONE, BUZZER_WALK_ON_MS, BUZZER_WALK_OFF_MS, BUZZER_REPEAT_FOREVER);
+                    break;
+                case SIGNAL_FLASH_DONT_WALK:
+                    buzzer_play_tone_pattern(BUZZER_FLASH_TONE, BUZZER_FLASH_ON_MS, BUZZER_FLASH_OFF_MS, BUZZER_REPEAT_FOREVER);
+                    break;
+                case SIGNAL_DARK: // Travessia apagada no modo noturno
+                    buzzer_play_tone_pattern(BUZZER_NIGHT_TONE, BUZZER_NIGHT_ON_MS, BUZZER_NIGHT_OFF_MS, BUZZER_REPEAT_FOREVER);
+                    break;
+                case SIGNAL_DONT_WALK: // Pedestre Pare
+                    buzzer_play_tone_pattern(BUZZER_STOP_TONE, BUZZER_STOP_ON_MS, BUZZER_STOP_OFF_MS, BUZZER_REPEAT_FOREVER);
+                    break;
+                default:
+                    buzzer_stop();
+                    break;
+            }
         }
 
-        // --- Determina os Parâmetros do Som para a Fase Atual ---
-        switch(current_phase) {
-            case CARS_RED_PEDS_WALK:
-                buzzer_play_tone(BUZZER_WALK_FREQ, BUZZER_WALK_ON_MS); // Teste bloqueante
-                vTaskDelay(pdMS_TO_TICKS(BUZZER_WALK_OFF_MS));        // Pausa bloqueante
-                break;
-            case CARS_RED_PEDS_FLASH:
-                buzzer_play_tone(BUZZER_FLASH_FREQ, BUZZER_FLASH_ON_MS); // Teste bloqueante
-                vTaskDelay(pdMS_TO_TICKS(BUZZER_FLASH_OFF_MS));         // Pausa bloqueante
-                break;
-            case CARS_NIGHT_FLASHING:
-                buzzer_play_tone(BUZZER_NIGHT_FREQ, BUZZER_NIGHT_ON_MS); // Teste bloqueante
-                vTaskDelay(pdMS_TO_TICKS(BUZZER_NIGHT_OFF_MS));        // Pausa bloqueante
-                break;
-            case CARS_GREEN_LIGHT:    // Carro Verde => Pedestre Pare
-            case CARS_YELLOW_LIGHT:   // Carro Amarelo => Pedestre Pare
-            case CARS_PED_RED_LIGHT:  // Ambos Vermelhos => Pedestre Pare
-                freq = BUZZER_STOP_FREQ;
-                on_duration_ms = BUZZER_STOP_ON_MS;
-                off_duration_ms = BUZZER_STOP_OFF_MS;
-                break;
-            default:
-                vTaskDelay(pdMS_TO_TICKS(BUZZER_TASK_BASE_DELAY_MS)); // Apenas pausa
-                break;
+        task_stats_loop_end();
+        state_wait(STATE_EVENT_BUZZER, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief Callback do stdio quando chegam caracteres na serial (contexto de interrupção).
+ */
+static void console_chars_available(void *param) {
+    BaseType_t higher_priority_woken = pdFALSE;
+    if (xConsoleTaskHandle != NULL) {
+        vTaskNotifyGiveFromISR(xConsoleTaskHandle, &higher_priority_woken);
+    }
+    portYIELD_FROM_ISR(higher_priority_woken);
+}
+
+/**
+ * @brief Executa um comando de texto do console.
+ *        "stats" imprime a tabela; "stream <ms>" liga o quadro binário periódico (0 desliga);
+ *        "bootloader" reinicia no bootloader USB (manutenção: apaga todos os sinais).
+ */
+static void console_command(const char *line, uint32_t *stream_period_ms) {
+    unsigned long period;
+    if (strcmp(line, "stats") == 0) {
+        task_stats_print();
+        cycle_stats_print();
+        ped_call_print(&intersections[0].calls);
+        adaptive_timing_print(&adaptive_timing);
+        intersection_scheduler_print(&scheduler);
+    } else if (strcmp(line, "adaptativo") == 0 || strcmp(line, "tabela") == 0) {
+        if (adaptive_timing_set_enabled(&adaptive_timing, line[0] == 'a')) {
+            printf("Tempos %s a partir do proximo ciclo\n", line[0] == 'a' ? "adaptativos" : "da tabela");
+        } else {
+            printf("Sem detector no grupo %u: mantendo os tempos da tabela\n", adaptive_timing.unmeasured_group);
         }
+    } else if (strcmp(line, "atuado") == 0 || strcmp(line, "fixo") == 0) {
+        signal_actuated = (line[0] == 'a');
+        xEventGroupSetBits(xStateEvents, STATE_EVENT_CONTROL); // tira o controle do descanso, se for o caso
+        printf("Modo %s\n", signal_actuated ? "atuado" : "tempo fixo");
+    } else if (strcmp(line, "bootloader") == 0) {
+        printf("Reiniciando no bootloader USB\n");
+        reset_usb_boot(0, 0);
+    } else if (sscanf(line, "stream %lu", &period) == 1) {
+        *stream_period_ms = (uint32_t)period;
+    } else if (line[0] != '\0') {
+        printf("Comandos: stats | stream <ms> | atuado | fixo | adaptativo | tabela | bootloader\n");
+    }
+}
 
-        // --- Decide se o som deve estar LIGADO ou DESLIGADO ---
-        if (freq > 0) { // Se a fase deve ter som
-            cycle_duration_ms = on_duration_ms + off_duration_ms;
-            if (cycle_duration_ms > 0) { // Evita divisão por zero
-                uint32_t elapsed_ticks_in_phase = current_tick - phase_start_tick;
-                // Converte ticks para ms de forma segura
-                uint32_t elapsed_ms_in_phase = (uint32_t)(((uint64_t)elapsed_ticks_in_phase * 1000) / configTICK_RATE_HZ);
-                // Calcula a posição dentro do ciclo ON/OFF
-                uint32_t time_in_current_cycle = elapsed_ms_in_phase % cycle_duration_ms;
-                // Verifica se está na porção ON do ciclo
-                play_sound = (time_in_current_cycle < on_duration_ms);
-            } else {
-                // Ciclo inválido (on+off = 0), mas freq > 0? Assume som contínuo.
-                play_sound = true;
+/**
+ * @brief Tarefa do console serial: lê linhas de comando e, se habilitado,
+ *        envia periodicamente o quadro binário de estatísticas.
+ */
+void vStatsConsoleTask() {
+    char line[CONSOLE_LINE_MAX];
+    size_t length = 0;
+    uint32_t stream_period_ms = STATS_STREAM_DEFAULT_MS;
+    TickType_t next_frame_tick = xTaskGetTickCount();
+
+    stdio_set_chars_available_callback(console_chars_available, NULL);
+    while (true) {
+        TickType_t timeout = portMAX_DELAY;
+        if (stream_period_ms > 0) {
+            timeout = ticks_until(next_frame_tick);
+        }
+        ulTaskNotifyTake(pdTRUE, timeout);
+        task_stats_loop_start();
+
+        // Consome tudo o que chegou, executando cada linha completa
+        int c;
+        while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+            if (c == '\r' || c == '\n') {
+                line[length] = '\0';
+                console_command(line, &stream_period_ms);
+                length = 0;
+            } else if (length < sizeof(line) - 1) {
+                line[length++] = (char)c;
             }
-        } else { // Fase silenciosa
-            play_sound = false;
         }
 
-        // --- Aciona o Buzzer ---
-        // Liga ou desliga o PWM do buzzer sem bloquear.
-        buzzer_play_tone(play_sound ? freq : 0, 0);
+        if (stream_period_ms > 0 && ticks_until(next_frame_tick) == 0) {
+            task_stats_write_frame();
+            next_frame_tick = xTaskGetTickCount() + pdMS_TO_TICKS(stream_period_ms);
+        }
+        task_stats_loop_end();
+    }
+}
 
-        // --- Delay Fixo ---
-        vTaskDelay(loop_delay_ticks);
+/**
+ * @brief Tarefa de baixa prioridade que esvazia os anéis de trace para a serial.
+ */
+void vTraceDrainTask() {
+    while (true) {
+        trace_drain();
+        vTaskDelay(pdMS_TO_TICKS(TRACE_DRAIN_PERIOD_MS));
     }
 }
 
+// Pilhas e TCBs das tarefas (só no build estático; ver static_memory.h)
+TASK_MEMORY(vGeneralControlTask, STACK_SIZE_DEFAULT);
+TASK_MEMORY(vButtonTask, STACK_SIZE_DEFAULT);
+TASK_MEMORY(vRgbLedTask, STACK_SIZE_DEFAULT);
+TASK_MEMORY(vLedMatrixTask, STACK_SIZE_DEFAULT);
+TASK_MEMORY(vBuzzerTask, STACK_SIZE_DEFAULT);
+TASK_MEMORY(vDisplayUpdateTask, STACK_SIZE_DISPLAY);
+#if TRACE_ENABLED
+TASK_MEMORY(vTraceDrainTask, STACK_SIZE_DEFAULT);
+#endif
+TASK_MEMORY(vStatsConsoleTask, STACK_SIZE_CONSOLE);
+
 /**
  * @brief Função principal: inicializa o sistema e cria todas as tarefas do FreeRTOS.
  *        Após a criação das tarefas, inicia o escalonador.
@@ -387,14 +603,61 @@ int main() {
     init_system_all();
     // Mostra tela de inicialização no display
     display_startup_screen(&display);
+    // Confere a tabela do plano; um plano inconsistente não deve rodar
+    if (!signal_plan_valid(signal_plan)) {
+        printf("Plano de sinalizacao invalido, usando o padrao\n");
+        signal_plan = &signal_plan_pedestrian;
+    }
+    signal_step = signal_plan->start_step;
+    printf("Plano: %s (%u passos), %u cruzamento(s), %u bytes por cruzamento\n", signal_plan->name,
+           signal_plan->step_count, (unsigned)INTERSECTION_COUNT,
+           (unsigned)(sizeof(intersection_t) + sizeof(intersection_t *)));
+    if (signal_actuated && !signal_plan_actuated(signal_plan)) {
+        printf("Plano sem travessia atuada: rodando em tempo fixo\n");
+    }
+    // A travessia é medida pelas chamadas do botão B; o grupo veicular, só com detector
+    uint16_t detector_groups = 1u << signal_plan->pedestrian_group;
+    if (ADAPTIVE_VEHICLE_DETECTOR) {
+        detector_groups |= 1u << signal_plan->vehicle_group;
+    }
+    adaptive_timing_init(&adaptive_timing, signal_plan, SIGNAL_ADAPTIVE, detector_groups);
+    if (SIGNAL_ADAPTIVE && !adaptive_timing.enabled) {
+        printf("Tempos adaptativos indisponiveis: grupo %u sem detector\n", adaptive_timing.unmeasured_group);
+    }
+    // Pré-renderiza as telas de cada passo
+    display_frame_cache_init(&display, signal_plan);
+    // Canal de publicação do estado; todos os bits ligados fazem cada tarefa
+    // aplicar o estado inicial sem esperar a primeira transição
+#if configSUPPORT_STATIC_ALLOCATION
+    static StaticEventGroup_t state_events_buffer;
+    xStateEvents = xEventGroupCreateStatic(&state_events_buffer);
+#else
+    xStateEvents = xEventGroupCreate();
+#endif
+    power_stats_set_phase(signal_step);
+    xEventGroupSetBits(xStateEvents, STATE_EVENT_ALL & ~STATE_EVENT_CONTROL);
     printf("Tarefas inicializadas!");
     // Cria as tarefas do sistema com suas prioridades
-    xTaskCreate(vGeneralControlTask, "ControlTask", STACK_SIZE_DEFAULT, NULL, PRIORIDADE_CONTROLLER, NULL);
-    xTaskCreate(vButtonTask, "ButtonTask", STACK_SIZE_DEFAULT, NULL, PRIORIDADE_BUTTONS, NULL);
-    xTaskCreate(vRgbLedTask, "RgbLedTask", STACK_SIZE_DEFAULT, NULL, PRIORIDADE_RGB_LED, NULL);
-    xTaskCreate(vLedMatrixTask, "MatrixTask", STACK_SIZE_DEFAULT, NULL, PRIORIDADE_MATRIX, NULL);
-    xTaskCreate(vBuzzerTask, "BuzzerTask", STACK_SIZE_DEFAULT, NULL, PRIORIDADE_BUZZER, NULL);
-    xTaskCreate(vDisplayUpdateTask, "DisplayTask", STACK_SIZE_DISPLAY, NULL , PRIORIDADE_DISPLAY, NULL);
+    // No build SMP o controle fica sozinho com os botões no núcleo 0 e a
+    // renderização vai para o núcleo 1; console e trace rodam onde houver folga
+    task_create_on(vGeneralControlTask, "ControlTask", STACK_SIZE_DEFAULT, PRIORIDADE_CONTROLLER, CORE_MASK_CONTROL,
+                   TASK_STACK(vGeneralControlTask), TASK_TCB(vGeneralControlTask), NULL);
+    task_create_on(vButtonTask, "ButtonTask", STACK_SIZE_DEFAULT, PRIORIDADE_BUTTONS, CORE_MASK_CONTROL,
+                   TASK_STACK(vButtonTask), TASK_TCB(vButtonTask), NULL);
+    task_create_on(vRgbLedTask, "RgbLedTask", STACK_SIZE_DEFAULT, PRIORIDADE_RGB_LED, CORE_MASK_RENDER,
+                   TASK_STACK(vRgbLedTask), TASK_TCB(vRgbLedTask), NULL);
+    task_create_on(vLedMatrixTask, "MatrixTask", STACK_SIZE_DEFAULT, PRIORIDADE_MATRIX, CORE_MASK_RENDER,
+                   TASK_STACK(vLedMatrixTask), TASK_TCB(vLedMatrixTask), NULL);
+    task_create_on(vBuzzerTask, "BuzzerTask", STACK_SIZE_DEFAULT, PRIORIDADE_BUZZER, CORE_MASK_RENDER,
+                   TASK_STACK(vBuzzerTask), TASK_TCB(vBuzzerTask), NULL);
+    task_create_on(vDisplayUpdateTask, "DisplayTask", STACK_SIZE_DISPLAY, PRIORIDADE_DISPLAY, CORE_MASK_RENDER,
+                   TASK_STACK(vDisplayUpdateTask), TASK_TCB(vDisplayUpdateTask), &xDisplayTaskHandle);
+#if TRACE_ENABLED
+    task_create_on(vTraceDrainTask, "TraceTask", STACK_SIZE_DEFAULT, PRIORIDADE_TRACE, CORE_MASK_ANY,
+                   TASK_STACK(vTraceDrainTask), TASK_TCB(vTraceDrainTask), NULL);
+#endif
+    task_create_on(vStatsConsoleTask, "ConsoleTask", STACK_SIZE_CONSOLE, PRIORIDADE_CONSOLE, CORE_MASK_ANY,
+                   TASK_STACK(vStatsConsoleTask), TASK_TCB(vStatsConsoleTask), &xConsoleTaskHandle);
 
     // Inicia o escalonador do FreeRTOS
     vTaskStartScheduler();
@@ -0,0 +1,31 @@
+#ifndef SIM_BUTTON_DEBOUNCE_PIO_H
+#define SIM_BUTTON_DEBOUNCE_PIO_H
+
+// Substitui o cabeçalho gerado por pico_generate_pio_header: no host o SM é o
+// modelo de comportamento de sim_pio_debounce.c, com o mesmo relógio de
+// amostras e o mesmo formato de palavra do programa.
+
+#include "hardware/pio.h"
+#include "sim_hal.h"
+
+#define BUTTON_DEBOUNCE_CYCLES_PER_SAMPLE 3
+#define BUTTON_DEBOUNCE_PROLOGUE_CYCLES   2
+
+static const uint16_t button_debounce_program_instructions[] = { 0 };
+
+static const struct pio_program button_debounce_program = {
+    .instructions = button_debounce_program_instructions,
+    .length = 1,
+    .origin = -1,
+};
+
+static inline uint64_t button_debounce_program_init(PIO pio, uint sm, uint offset, uint pin,
+                                                    uint32_t sample_us, uint32_t stable_samples) {
+    (void)offset;
+    uint64_t start_us = time_us_64();
+    sim_pio_debounce_start(pio, sm, pin, sample_us, stable_samples,
+                           start_us + BUTTON_DEBOUNCE_PROLOGUE_CYCLES * sample_us / BUTTON_DEBOUNCE_CYCLES_PER_SAMPLE);
+    return start_us;
+}
+
+#endif // SIM_BUTTON_DEBOUNCE_PIO_H
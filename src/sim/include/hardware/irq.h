@@ -0,0 +1,24 @@
+#ifndef SIM_HARDWARE_IRQ_H
+#define SIM_HARDWARE_IRQ_H
+
+#include "pico.h"
+
+#define PIO0_IRQ_0   7
+#define PIO1_IRQ_0   9
+#define IO_IRQ_BANK0 13
+#define DMA_IRQ_0    11
+#define DMA_IRQ_1    12
+#define I2C0_IRQ     23
+#define I2C1_IRQ     24
+#define NUM_IRQS     32
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_enabled(uint num, bool enabled);
+void irq_set_priority(uint num, uint8_t hardware_priority);
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority);
+
+#endif // SIM_HARDWARE_IRQ_H
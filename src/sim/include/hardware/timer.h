@@ -0,0 +1,16 @@
+#ifndef SIM_HARDWARE_TIMER_H
+#define SIM_HARDWARE_TIMER_H
+
+#include "pico.h"
+
+// Tempo virtual (ticks do FreeRTOS, 1 tick = 1 ms simulado)
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+
+// Espera ocupada (só para esperas curtas, inclusive em interrupção)
+void busy_wait_us(uint64_t delay_us);
+
+// Relógio real do host, base das estatísticas de run-time na simulação
+uint32_t sim_host_time_us_32(void);
+
+#endif // SIM_HARDWARE_TIMER_H
@@ -0,0 +1,21 @@
+#ifndef SIM_LED_MATRIX_PIO_H
+#define SIM_LED_MATRIX_PIO_H
+
+// Substitui o cabeçalho gerado por pico_generate_pio_header: na simulação a
+// matriz é observada pelo DMA que alimenta o FIFO TX (sim_hal.c).
+
+#include "hardware/pio.h"
+
+static const uint16_t led_matrix_program_instructions[] = { 0 };
+
+static const struct pio_program led_matrix_program = {
+    .instructions = led_matrix_program_instructions,
+    .length = 1,
+    .origin = -1,
+};
+
+static inline void led_matrix_program_init(PIO pio, uint sm, uint offset, uint pin) {
+    (void)pio; (void)sm; (void)offset; (void)pin;
+}
+
+#endif // SIM_LED_MATRIX_PIO_H
@@ -0,0 +1,24 @@
+#ifndef SIM_PICO_H
+#define SIM_PICO_H
+
+/*
+ * Substituto mínimo do pico-sdk para a simulação no host (alvo traffic_sim).
+ * Só o que o firmware usa; as saídas são gravadas por sim_hal.c.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#define PICO_OK             0
+#define PICO_ERROR_TIMEOUT  (-1)
+
+void panic(const char *fmt, ...);
+static inline void tight_loop_contents(void) {}
+
+// Número da exceção em execução: != 0 dentro de uma "interrupção" simulada
+uint __get_current_exception(void);
+
+#endif // SIM_PICO_H
@@ -0,0 +1,16 @@
+#ifndef SIM_PICO_CRITICAL_SECTION_H
+#define SIM_PICO_CRITICAL_SECTION_H
+
+#include "pico.h"
+
+// Na simulação todas as "interrupções" são tarefas: suspender o escalonador basta
+typedef struct {
+    uint32_t unused;
+} critical_section_t;
+
+void critical_section_init(critical_section_t *crit_sec);
+void critical_section_enter_blocking(critical_section_t *crit_sec);
+void critical_section_exit(critical_section_t *crit_sec);
+void critical_section_deinit(critical_section_t *crit_sec);
+
+#endif // SIM_PICO_CRITICAL_SECTION_H
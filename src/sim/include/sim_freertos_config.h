@@ -0,0 +1,45 @@
+#ifndef SIM_FREERTOS_CONFIG_H
+#define SIM_FREERTOS_CONFIG_H
+
+/*
+ * Ajustes do FreeRTOSConfig.h do firmware para a porta POSIX (alvo traffic_sim).
+ * Incluído no fim do FreeRTOSConfig.h quando TRAFFIC_SIM está definido.
+ */
+
+// A porta POSIX é de um núcleo só: a afinidade vira no-op (ver task_create_on em main.c)
+#if TRAFFIC_SMP
+#error "traffic_sim não suporta TRAFFIC_SMP"
+#endif
+#if TRAFFIC_STATIC
+#error "traffic_sim não suporta TRAFFIC_STATIC (os alarmes simulados usam timers dinâmicos)"
+#endif
+
+// Cada tarefa vira uma pthread, que pede pelo menos PTHREAD_STACK_MIN (16 KiB)
+#undef configMINIMAL_STACK_SIZE
+#define configMINIMAL_STACK_SIZE                ( configSTACK_DEPTH_TYPE ) 4096
+#undef configTIMER_TASK_STACK_DEPTH
+#define configTIMER_TASK_STACK_DEPTH            4096
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE                   (4 * 1024 * 1024)
+
+// A verificação de estouro não faz sentido com as pilhas das pthreads
+#undef configCHECK_FOR_STACK_OVERFLOW
+#define configCHECK_FOR_STACK_OVERFLOW          0
+
+// Alarmes, DMA e botões simulados são timers do FreeRTOS
+#undef configTIMER_QUEUE_LENGTH
+#define configTIMER_QUEUE_LENGTH                64
+
+// Agenda o fim da simulação e os eventos de botão na partida da tarefa de timers
+#undef configUSE_DAEMON_TASK_STARTUP_HOOK
+#define configUSE_DAEMON_TASK_STARTUP_HOOK      1
+
+// Tempo virtual: em vez de dormir, o idle avança o tick direto até o próximo prazo
+void sim_idle_skip(uint32_t expected_idle_ticks);
+#define portSUPPRESS_TICKS_AND_SLEEP(x)         sim_idle_skip(x)
+
+// Run-time stats medem CPU do host (o tempo virtual salta no idle)
+#undef portGET_RUN_TIME_COUNTER_VALUE
+#define portGET_RUN_TIME_COUNTER_VALUE()        sim_host_time_us_32()
+
+#endif // SIM_FREERTOS_CONFIG_H
@@ -0,0 +1,538 @@
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
+#include "pico/bootrom.h"
+#include "hardware/pwm.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/i2c.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
+#include "sim_hal.h"
+
+/*
+ * Periféricos do RP2040 simulados sobre a porta POSIX do FreeRTOS.
+ *
+ * Tempo: 1 tick = 1 ms virtual. O idle avança o tick direto até o próximo
+ * prazo (sim_idle_skip), então um dia de operação roda em segundos.
+ * Interrupções: alarmes e fins de DMA são timers do FreeRTOS; o callback roda
+ * na tarefa de timers (prioridade máxima) marcado como interrupção.
+ * Exclusão mútua: como toda "interrupção" é uma tarefa, desabilitar interrupções
+ * vira suspender o escalonador.
+ */
+
+#define SIM_ALARM_MAX        32
+#define SIM_IRQ_HANDLERS_MAX 4
+#define SIM_DMA_BYTES_PER_US 1 // ritmo do DREQ usado para estimar o fim de um DMA
+
+pio_hw_t sim_pio0_hw, sim_pio1_hw;
+i2c_inst_t sim_i2c0_inst = { .index = 0 };
+i2c_inst_t sim_i2c1_inst = { .index = 1 };
+
+static uint64_t boot_us; // tempo consumido por sleep_ms antes do escalonador
+static volatile uint irq_depth;
+
+// ------------------------------------------------------------------ tempo
+
+uint64_t time_us_64(void) {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return boot_us;
+    }
+    return boot_us + (uint64_t)xTaskGetTickCount() * 1000u;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+uint32_t sim_host_time_us_32(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u);
+}
+
+static TickType_t us_to_ticks(uint64_t us) {
+    uint64_t ticks = (us + 999u) / 1000u;
+    if (ticks == 0) {
+        ticks = 1; // o menor atraso possível é o próximo tick
+    }
+    return ticks > portMAX_DELAY - 1 ? portMAX_DELAY - 1 : (TickType_t)ticks;
+}
+
+void sleep_us(uint64_t us) {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        boot_us += us;
+    } else {
+        vTaskDelay(us_to_ticks(us));
+    }
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+// O tempo virtual só anda de tick em tick (1 ms): uma espera ocupada de
+// microssegundos termina na hora, como se a CPU fosse instantânea
+void busy_wait_us(uint64_t delay_us) {
+    (void)delay_us;
+}
+
+// ------------------------------------------------------------------ interrupções
+
+uint __get_current_exception(void) {
+    return irq_depth ? 16 : 0;
+}
+
+void sim_irq_enter(void) {
+    irq_depth++;
+}
+
+void sim_irq_exit(void) {
+    irq_depth--;
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        vTaskSuspendAll();
+    }
+    return 0;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void)status;
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        xTaskResumeAll();
+    }
+}
+
+void critical_section_init(critical_section_t *crit_sec) { (void)crit_sec; }
+void critical_section_deinit(critical_section_t *crit_sec) { (void)crit_sec; }
+
+void critical_section_enter_blocking(critical_section_t *crit_sec) {
+    (void)crit_sec;
+    save_and_disable_interrupts();
+}
+
+void critical_section_exit(critical_section_t *crit_sec) {
+    (void)crit_sec;
+    restore_interrupts(0);
+}
+
+static struct {
+    irq_handler_t handlers[SIM_IRQ_HANDLERS_MAX];
+    uint count;
+    bool enabled;
+} irqs[NUM_IRQS];
+
+void irq_set_enabled(uint num, bool enabled) { irqs[num].enabled = enabled; }
+void irq_set_priority(uint num, uint8_t hardware_priority) { (void)num; (void)hardware_priority; }
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    irqs[num].handlers[0] = handler;
+    irqs[num].count = 1;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    if (irqs[num].count == SIM_IRQ_HANDLERS_MAX) {
+        panic("irq %u: handlers demais", num);
+    }
+    irqs[num].handlers[irqs[num].count++] = handler;
+}
+
+void sim_irq_dispatch(uint num) {
+    if (!irqs[num].enabled) {
+        return;
+    }
+    sim_irq_enter();
+    for (uint i = 0; i < irqs[num].count; ++i) {
+        irqs[num].handlers[i]();
+    }
+    sim_irq_exit();
+}
+
+// ------------------------------------------------------------------ alarmes
+
+static struct {
+    TimerHandle_t timer;
+    alarm_callback_t callback;
+    void *user_data;
+    uint64_t target_us;
+    bool used;
+} alarms[SIM_ALARM_MAX];
+
+static void alarm_arm(int slot) {
+    uint64_t now = time_us_64();
+    uint64_t delay = alarms[slot].target_us > now ? alarms[slot].target_us - now : 0;
+    xTimerChangePeriod(alarms[slot].timer, us_to_ticks(delay), 0);
+}
+
+static void alarm_timer_cb(TimerHandle_t timer) {
+    int slot = (int)(intptr_t)pvTimerGetTimerID(timer);
+    if (!alarms[slot].used) {
+        return;
+    }
+    sim_irq_enter();
+    int64_t ret = alarms[slot].callback(slot + 1, alarms[slot].user_data);
+    sim_irq_exit();
+
+    if (ret < 0) {
+        alarms[slot].target_us += (uint64_t)-ret; // relativo ao prazo anterior
+    } else if (ret > 0) {
+        alarms[slot].target_us = time_us_64() + (uint64_t)ret;
+    } else {
+        alarms[slot].used = false;
+        return;
+    }
+    alarm_arm(slot);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)fire_if_past;
+    uint32_t irq_state = save_and_disable_interrupts();
+    int slot = 0;
+    while (slot < SIM_ALARM_MAX && alarms[slot].used) {
+        slot++;
+    }
+    if (slot == SIM_ALARM_MAX) {
+        restore_interrupts(irq_state);
+        return -1;
+    }
+    alarms[slot].used = true;
+    restore_interrupts(irq_state);
+
+    if (!alarms[slot].timer) {
+        alarms[slot].timer = xTimerCreate("alarm", 1, pdFALSE, (void *)(intptr_t)slot, alarm_timer_cb);
+    }
+    alarms[slot].callback = callback;
+    alarms[slot].user_data = user_data;
+    alarms[slot].target_us = time_us_64() + us;
+    alarm_arm(slot);
+    return slot + 1;
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us((uint64_t)ms * 1000u, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    int slot = alarm_id - 1;
+    if (slot < 0 || slot >= SIM_ALARM_MAX || !alarms[slot].used) {
+        return false;
+    }
+    alarms[slot].used = false;
+    xTimerStop(alarms[slot].timer, 0);
+    return true;
+}
+
+// ------------------------------------------------------------------ GPIO
+
+static struct {
+    bool out;
+    bool level;
+    enum gpio_function function;
+    uint32_t irq_events;
+} pins[NUM_BANK0_GPIOS];
+
+static gpio_irq_callback_t gpio_callback;
+
+void gpio_init(uint gpio) {
+    pins[gpio].out = false;
+    pins[gpio].level = false;
+    pins[gpio].function = GPIO_FUNC_SIO;
+}
+
+void gpio_set_dir(uint gpio, bool out) { pins[gpio].out = out; }
+void gpio_set_function(uint gpio, enum gpio_function fn) { pins[gpio].function = fn; }
+void gpio_pull_down(uint gpio) { if (!pins[gpio].out) pins[gpio].level = false; }
+void gpio_pull_up(uint gpio) { if (!pins[gpio].out) pins[gpio].level = true; }
+bool gpio_get(uint gpio) { return pins[gpio].level; }
+
+void gpio_put(uint gpio, bool value) {
+    if (pins[gpio].level == value) {
+        return;
+    }
+    pins[gpio].level = value;
+    sim_record("gpio", "%u,%d", gpio, value);
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (enabled) {
+        pins[gpio].irq_events |= event_mask;
+    } else {
+        pins[gpio].irq_events &= ~event_mask;
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    gpio_callback = callback;
+}
+
+void sim_gpio_drive(uint gpio, bool level) {
+    if (pins[gpio].level == level) {
+        return;
+    }
+    pins[gpio].level = level;
+    sim_record("input", "%u,%d", gpio, level);
+    sim_pio_debounce_pin(gpio, level);
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (gpio_callback && (pins[gpio].irq_events & event)) {
+        sim_irq_enter();
+        gpio_callback(gpio, event);
+        sim_irq_exit();
+    }
+}
+
+// ------------------------------------------------------------------ PWM
+
+static struct {
+    uint8_t div_int, div_frac;
+    uint16_t wrap;
+    uint16_t level[2];
+    bool enabled;
+} slices[NUM_PWM_SLICES];
+
+static uint32_t pin_pwm_hz[NUM_BANK0_GPIOS];
+
+// Frequência audível em cada pino PWM (0 = parado ou nível 0); grava só mudanças
+static void pwm_update_outputs(uint slice_num) {
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; ++gpio) {
+        if (pins[gpio].function != GPIO_FUNC_PWM || pwm_gpio_to_slice_num(gpio) != slice_num) {
+            continue;
+        }
+        uint16_t level = slices[slice_num].level[pwm_gpio_to_channel(gpio)];
+        uint32_t hz = 0;
+        if (slices[slice_num].enabled && level != 0) {
+            uint32_t div16 = slices[slice_num].div_int * 16u + slices[slice_num].div_frac;
+            uint64_t period16 = (uint64_t)div16 * (slices[slice_num].wrap + 1u);
+            hz = (uint32_t)(((uint64_t)SYS_CLK_KHZ * 1000u * 16u + period16 / 2) / period16);
+        }
+        if (hz != pin_pwm_hz[gpio]) {
+            pin_pwm_hz[gpio] = hz;
+            sim_record("pwm", "%u,%u", gpio, hz);
+        }
+    }
+}
+
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract) {
+    slices[slice_num].div_int = integer;
+    slices[slice_num].div_frac = fract;
+    pwm_update_outputs(slice_num);
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    slices[slice_num].wrap = wrap;
+    pwm_update_outputs(slice_num);
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level) {
+    slices[slice_num].level[chan] = level;
+    pwm_update_outputs(slice_num);
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    slices[slice_num].enabled = enabled;
+    pwm_update_outputs(slice_num);
+}
+
+// ------------------------------------------------------------------ PIO
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio; (void)program;
+    return 0;
+}
+
+// Máquinas entregues em ordem, 4 por PIO
+int pio_claim_unused_sm(PIO pio, bool required) {
+    static uint claimed[2];
+    uint *next = &claimed[pio == pio1 ? 1 : 0];
+    if (*next == 4) {
+        if (required) {
+            panic("pio: sem SM livre");
+        }
+        return -1;
+    }
+    return (int)(*next)++;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    (void)is_tx;
+    return (pio == pio1 ? 8u : 0u) + sm;
+}
+
+// O DMA simulado só termina depois que o "PIO" consumiu tudo
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm) {
+    (void)pio; (void)sm;
+    return 0;
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    pio->txf[sm] = data;
+}
+
+// ------------------------------------------------------------------ DMA
+
+static struct {
+    bool claimed;
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint count;
+    bool busy;
+    bool irq_enabled[2];
+    bool irq_status[2];
+    TimerHandle_t timer;
+} dma[NUM_DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required) {
+    for (int ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (!dma[ch].claimed) {
+            dma[ch].claimed = true;
+            return ch;
+        }
+    }
+    if (required) {
+        panic("sem canais DMA livres");
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    dma_channel_config c = { .size = DMA_SIZE_32, .read_increment = true, .write_increment = false, .dreq = 0x3f };
+    return c;
+}
+
+static bool dma_writes_pio(uint channel) {
+    const volatile uint32_t *w = dma[channel].write_addr;
+    return (w >= sim_pio0_hw.txf && w < sim_pio0_hw.txf + 4) || (w >= sim_pio1_hw.txf && w < sim_pio1_hw.txf + 4);
+}
+
+// Quadro WS2812 (GRB << 8): máscara dos LEDs acesos e a cor do primeiro deles
+static void dma_record_matrix(uint channel) {
+    const volatile uint32_t *words = dma[channel].read_addr;
+    uint32_t mask = 0, rgb = 0;
+    for (uint i = 0; i < dma[channel].count && i < 32; ++i) {
+        uint32_t grb = words[i];
+        if (grb) {
+            if (!mask) {
+                rgb = ((grb >> 16) & 0xFF) << 16 | ((grb >> 24) & 0xFF) << 8 | ((grb >> 8) & 0xFF);
+            }
+            mask |= 1u << i;
+        }
+    }
+    sim_record("matrix", "%07x,%06x", mask, rgb);
+}
+
+static void dma_done_cb(TimerHandle_t timer) {
+    uint channel = (uint)(intptr_t)pvTimerGetTimerID(timer);
+    dma[channel].busy = false;
+    for (int n = 0; n < 2; ++n) {
+        if (dma[channel].irq_enabled[n]) {
+            dma[channel].irq_status[n] = true;
+            sim_irq_dispatch(n ? DMA_IRQ_1 : DMA_IRQ_0);
+        }
+    }
+}
+
+static void dma_start(uint channel) {
+    if (dma_writes_pio(channel)) {
+        dma_record_matrix(channel);
+    }
+    if (!dma[channel].timer) {
+        dma[channel].timer = xTimerCreate("dma", 1, pdFALSE, (void *)(intptr_t)channel, dma_done_cb);
+    }
+    dma[channel].busy = true;
+    uint64_t bytes = (uint64_t)dma[channel].count << dma[channel].config.size;
+    xTimerChangePeriod(dma[channel].timer, us_to_ticks(bytes / SIM_DMA_BYTES_PER_US), 0);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    dma[channel].config = *config;
+    dma[channel].write_addr = write_addr;
+    dma[channel].read_addr = read_addr;
+    dma[channel].count = transfer_count;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    dma[channel].read_addr = read_addr;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+bool dma_channel_is_busy(uint channel) { return dma[channel].busy; }
+
+void dma_channel_abort(uint channel) {
+    if (dma[channel].timer) {
+        xTimerStop(dma[channel].timer, 0);
+    }
+    dma[channel].busy = false;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) { dma[channel].irq_enabled[0] = enabled; }
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) { dma[channel].irq_enabled[1] = enabled; }
+bool dma_channel_get_irq0_status(uint channel) { return dma[channel].irq_status[0]; }
+bool dma_channel_get_irq1_status(uint channel) { return dma[channel].irq_status[1]; }
+void dma_channel_acknowledge_irq0(uint channel) { dma[channel].irq_status[0] = false; }
+void dma_channel_acknowledge_irq1(uint channel) { dma[channel].irq_status[1] = false; }
+
+// ------------------------------------------------------------------ I2C
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+// Cada chamada é uma transação completa; só o SSD1306 está no barramento
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)i2c; (void)addr; (void)nostop;
+    sim_ssd1306_transaction(src, len);
+    return (int)len;
+}
+
+// ------------------------------------------------------------------ stdio e sistema
+
+bool stdio_init_all(void) {
+    sim_run_init();
+    return true;
+}
+
+// Sem console na simulação: nenhum caractere chega
+int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;
+    return PICO_ERROR_TIMEOUT;
+}
+
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param) {
+    (void)fn; (void)param;
+}
+
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask, uint32_t disable_interface_mask) {
+    (void)usb_activity_gpio_pin_mask; (void)disable_interface_mask;
+    fprintf(stderr, "sim: reset_usb_boot()\n");
+    exit(0);
+}
+
+void panic(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "sim: panic: ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    abort();
+}
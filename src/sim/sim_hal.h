@@ -0,0 +1,39 @@
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+/*
+ * Interface interna da simulação no host (alvo traffic_sim). O firmware não
+ * enxerga estas funções: ele só usa os cabeçalhos pico/ e hardware/ de sim/include.
+ */
+
+// Grava uma mudança de saída no log CSV: tempo_us,canal,valor
+void sim_record(const char *channel, const char *fmt, ...);
+
+// Marca o trecho como interrupção (__get_current_exception() != 0)
+void sim_irq_enter(void);
+void sim_irq_exit(void);
+void sim_irq_dispatch(uint num);
+
+// Força o nível de um pino de entrada, disparando o callback de GPIO
+void sim_gpio_drive(uint gpio, bool level);
+
+// Modelo de button_debounce.pio (sim_pio_debounce.c): partida de um SM e
+// mudança de nível de um pino, chamada por sim_gpio_drive
+void sim_pio_debounce_start(PIO pio, uint sm, uint pin, uint32_t sample_us, uint32_t stable_samples,
+                            uint64_t origin_us);
+void sim_pio_debounce_pin(uint gpio, bool level);
+
+// Modelo do SSD1306: uma transação I2C completa (byte de controle + dados)
+void sim_ssd1306_transaction(const uint8_t *bytes, size_t len);
+void sim_ssd1306_dump(FILE *out);
+// Cópia da GDDRAM, página a página (len até 8 * 128 bytes)
+void sim_ssd1306_read(uint8_t *dst, size_t len);
+
+// Lê o ambiente (SIM_*) e abre o log; chamada por stdio_init_all()
+void sim_run_init(void);
+
+#endif // SIM_HAL_H
@@ -0,0 +1,188 @@
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "sim_hal.h"
+
+/*
+ * Modelo de comportamento de button_debounce.pio, comum à simulação e aos
+ * testes de host. Em vez de um evento por amostra, a integração avança de uma
+ * vez sobre os intervalos entre duas mudanças do pino, em que o nível é
+ * constante: cada amostra no nível aceito zera a contagem, cada uma no nível
+ * oposto conta, e a N-ésima aceita a borda. Oscilações que vão e voltam entre
+ * duas amostras não são vistas, como no SM. Depois da aceitação vêm os dois
+ * intervalos do push, sem amostra.
+ *
+ * A palavra leva o relógio de amostras do intervalo da aceitação
+ * (X = -(m+1), bits 31..1) e o nível novo (bit 0). Um alarme no instante do
+ * push (ou no da próxima aceitação prevista) faz as vezes da interrupção do
+ * FIFO RX: a latência que o HAL der ao alarme é a latência da interrupção, e
+ * não muda o conteúdo da palavra.
+ */
+
+#define SIM_PIO_SMS         8  // pio0 e pio1, 4 máquinas cada
+#define SIM_PIO_RX_DEPTH    4
+#define SIM_PIO_PUSH_SLOTS  2  // intervalos sem amostra entre a aceitação e o laço seguinte
+
+typedef struct {
+    uint32_t word;
+    uint64_t push_us;
+} sim_pio_word_t;
+
+typedef struct {
+    bool running;
+    PIO pio;
+    uint pin;
+    uint32_t sample_us;
+    uint32_t stable_samples;
+    uint64_t origin_us;         // início do intervalo 0
+    bool stable;                // nível aceito (pull-up: começa solto)
+    bool level;                 // nível atual do pino
+    uint64_t next_slot;         // próximo intervalo ainda não amostrado
+    uint32_t count;             // amostras seguidas no nível oposto ao aceito
+    alarm_id_t alarm;
+    sim_pio_word_t outbox[SIM_PIO_RX_DEPTH]; // aceitas, esperando o push
+    uint outbox_count;
+    uint32_t rx[SIM_PIO_RX_DEPTH];
+    uint rx_count;
+    bool irq_enabled;
+} sim_pio_sm_t;
+
+static sim_pio_sm_t sms[SIM_PIO_SMS];
+
+static uint sm_index(PIO pio, uint sm) {
+    return (pio == pio1 ? 4u : 0u) + sm;
+}
+
+static uint64_t slot_us(const sim_pio_sm_t *s, uint64_t slot) {
+    return s->origin_us + slot * s->sample_us;
+}
+
+// Primeiro intervalo cuja amostra acontece em time_us ou depois
+static uint64_t slot_at(const sim_pio_sm_t *s, uint64_t time_us) {
+    if (time_us <= s->origin_us) {
+        return 0;
+    }
+    return (time_us - s->origin_us + s->sample_us - 1) / s->sample_us;
+}
+
+// Amostras dos intervalos [next_slot, until) com o pino em s->level
+static void advance(sim_pio_sm_t *s, uint64_t until) {
+    while (s->next_slot < until) {
+        if (s->level == s->stable) {
+            s->count = 0;
+            s->next_slot = until;
+            return;
+        }
+        uint64_t accept = s->next_slot + (s->stable_samples - s->count) - 1;
+        if (accept >= until) {
+            s->count += (uint32_t)(until - s->next_slot);
+            s->next_slot = until;
+            return;
+        }
+        s->stable = s->level;
+        s->count = 0;
+        s->next_slot = accept + SIM_PIO_PUSH_SLOTS + 1;
+        if (s->outbox_count < SIM_PIO_RX_DEPTH) {
+            uint32_t x = ~(uint32_t)accept;
+            s->outbox[s->outbox_count++] = (sim_pio_word_t){
+                .word = (x << 1) | (s->stable ? 1u : 0u),
+                .push_us = slot_us(s, accept + SIM_PIO_PUSH_SLOTS),
+            };
+        }
+    }
+}
+
+static int64_t sm_alarm(alarm_id_t id, void *user_data);
+
+// Alarme no próximo push: o já aceito, ou o da aceitação se o pino não mudar
+static void schedule(sim_pio_sm_t *s) {
+    if (s->alarm != 0) {
+        cancel_alarm(s->alarm);
+        s->alarm = 0;
+    }
+    uint64_t at_us = UINT64_MAX;
+    if (s->outbox_count > 0) {
+        at_us = s->outbox[0].push_us;
+    } else if (s->level != s->stable) {
+        at_us = slot_us(s, s->next_slot + (s->stable_samples - s->count) - 1 + SIM_PIO_PUSH_SLOTS);
+    }
+    if (at_us != UINT64_MAX) {
+        uint64_t now_us = time_us_64();
+        s->alarm = add_alarm_in_us(at_us > now_us ? at_us - now_us : 0, sm_alarm, s, true);
+    }
+}
+
+// Push das palavras aceitas até agora (FIFO cheio: push noblock descarta) e IRQ
+static int64_t sm_alarm(alarm_id_t id, void *user_data) {
+    sim_pio_sm_t *s = user_data;
+    s->alarm = 0;
+    uint64_t now_us = time_us_64();
+    advance(s, slot_at(s, now_us + 1));
+    uint pushed = 0;
+    while (pushed < s->outbox_count && s->outbox[pushed].push_us <= now_us) {
+        if (s->rx_count < SIM_PIO_RX_DEPTH) {
+            s->rx[s->rx_count++] = s->outbox[pushed].word;
+        }
+        pushed++;
+    }
+    s->outbox_count -= pushed;
+    for (uint i = 0; i < s->outbox_count; ++i) {
+        s->outbox[i] = s->outbox[i + pushed];
+    }
+    schedule(s);
+    if (s->irq_enabled && s->rx_count > 0) {
+        sim_irq_dispatch(s->pio == pio1 ? PIO1_IRQ_0 : PIO0_IRQ_0);
+    }
+    return 0;
+}
+
+void sim_pio_debounce_start(PIO pio, uint sm, uint pin, uint32_t sample_us, uint32_t stable_samples,
+                            uint64_t origin_us) {
+    sim_pio_sm_t *s = &sms[sm_index(pio, sm)];
+    *s = (sim_pio_sm_t){
+        .running = true,
+        .pio = pio,
+        .pin = pin,
+        .sample_us = sample_us,
+        .stable_samples = stable_samples,
+        .origin_us = origin_us,
+        .stable = true,
+        .level = gpio_get(pin),
+        .next_slot = 1, // o intervalo 0 é o salto para o laço, sem amostra
+    };
+    schedule(s);
+}
+
+void sim_pio_debounce_pin(uint gpio, bool level) {
+    for (uint index = 0; index < SIM_PIO_SMS; ++index) {
+        sim_pio_sm_t *s = &sms[index];
+        if (!s->running || s->pin != gpio) {
+            continue;
+        }
+        // Amostras anteriores à mudança ainda veem o nível antigo
+        advance(s, slot_at(s, time_us_64()));
+        s->level = level;
+        schedule(s);
+    }
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return sms[sm_index(pio, sm)].rx_count == 0;
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    uint index = sm_index(pio, sm);
+    if (sms[index].rx_count == 0) {
+        return 0;
+    }
+    uint32_t word = sms[index].rx[0];
+    sms[index].rx_count--;
+    for (uint i = 0; i < sms[index].rx_count; ++i) {
+        sms[index].rx[i] = sms[index].rx[i + 1];
+    }
+    return word;
+}
+
+void pio_set_irq0_source_enabled(PIO pio, pio_interrupt_source_t source, bool enabled) {
+    sms[sm_index(pio, (uint)(source - pis_sm0_rx_fifo_not_empty))].irq_enabled = enabled;
+}
@@ -0,0 +1,359 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+#include "adaptive_timing.h"
+#include "config.h"
+#include "cycle_stats.h"
+#include "debouncer.h"
+#include "intersection.h"
+#include "sim_hal.h"
+#include "task_stats.h"
+
+/*
+ * Controle da execução da simulação, configurado por variáveis de ambiente:
+ *   SIM_DURATION_S   duração em segundos virtuais (padrão: 86400 = um dia)
+ *   SIM_LOG          arquivo CSV das saídas (padrão: traffic_sim.csv)
+ *   SIM_BUTTON_A_MS  instantes (ms virtuais, separados por vírgula) de toques no botão A
+ *   SIM_BUTTON_B_MS  idem para o botão B (chamadas de pedestre)
+ *   SIM_PED_CALLS_PER_HOUR chegadas aleatórias (Poisson) de chamadas no botão B,
+ *                    no lugar de SIM_BUTTON_B_MS; SIM_SEED fixa a sequência (padrão 1)
+ *   SIM_VEHICLES_PER_HOUR chegadas aleatórias (Poisson) de veículos no grupo
+ *                    veicular do plano: cada uma passa pelo detector do firmware
+ *                    e entra numa fila que escoa no verde do LED RGB, um veículo
+ *                    a cada 3600/ADAPTIVE_SAT_FLOW_VEH_PER_H s (padrão 0 = sem veículos)
+ *   SIM_BUTTON_BOUNCE oscilações do contato a cada aperto e soltura (2 bordas extras
+ *                    cada, 1 ms virtual entre bordas; padrão 0, máximo 20)
+ *   SIM_QUIET        1 = descarta o printf do firmware (mais rápido)
+ *   SIM_DISPLAY_DUMP 1 = imprime a tela final em ASCII no stderr
+ *
+ * O log tem uma linha por mudança: tempo_us,canal,valor. Como o tempo é
+ * virtual e determinístico, duas execuções iguais geram o mesmo arquivo,
+ * o que permite comparar um log com uma referência após alterar a lógica.
+ */
+
+#define SIM_DEFAULT_DURATION_S  86400u
+#define SIM_DEFAULT_LOG         "traffic_sim.csv"
+#define SIM_BUTTON_PRESS_MS     100 // tempo que o botão fica pressionado
+#define SIM_MAX_PRESSES         64
+#define SIM_MAX_BOUNCES         20  // 40 bordas em 40 ms: cabe no toque de 100 ms
+#define SIM_BOUNCE_EDGE_US      1000 // resolução dos alarmes simulados (1 tick)
+
+static FILE *log_file;
+static uint64_t records;
+static uint32_t duration_s = SIM_DEFAULT_DURATION_S;
+static uint32_t bounces;
+static uint32_t rng_state = 1;
+
+// Botão simulado: lista de instantes ou chegadas aleatórias, um toque agendado por vez
+typedef struct {
+    uint pin;
+    uint32_t presses_ms[SIM_MAX_PRESSES];
+    uint32_t press_count, next_press;
+    uint32_t calls_per_hour;    // > 0: chegadas aleatórias em vez da lista
+    uint32_t bounce_edges_left;
+    bool bounce_level;          // nível final da oscilação em andamento
+} sim_button_t;
+
+static sim_button_t sim_buttons[] = {
+    { .pin = BUTTON_A_PIN },
+    { .pin = BUTTON_B_PIN },
+};
+#define SIM_BUTTON_COUNT (sizeof(sim_buttons) / sizeof(sim_buttons[0]))
+
+// Aproximação veicular: fila de instantes de chegada, escoada no verde
+#define SIM_VEHICLE_QUEUE_MAX   4096
+#define SIM_VEHICLE_HEADWAY_US  (3600000000ull / ADAPTIVE_SAT_FLOW_VEH_PER_H)
+static uint32_t vehicles_per_hour;
+static uint64_t vehicle_queue_us[SIM_VEHICLE_QUEUE_MAX];
+static uint32_t vehicle_head, vehicle_count, vehicle_queue_max;
+static uint64_t vehicle_last_departure_us;
+static uint64_t vehicles_arrived, vehicles_served, vehicles_dropped, vehicle_delay_sum_us;
+
+static bool display_dump;
+static struct timespec host_start;
+static uint64_t idle_skips, idle_skipped_ticks;
+
+static uint32_t env_u32(const char *name, uint32_t fallback) {
+    const char *value = getenv(name);
+    return value && *value ? (uint32_t)strtoul(value, NULL, 0) : fallback;
+}
+
+static void parse_presses(sim_button_t *button, const char *list) {
+    while (list && *list && button->press_count < SIM_MAX_PRESSES) {
+        char *end;
+        button->presses_ms[button->press_count++] = (uint32_t)strtoul(list, &end, 0);
+        list = *end ? end + 1 : end;
+    }
+}
+
+void sim_run_init(void) {
+    const char *path = getenv("SIM_LOG");
+    log_file = fopen(path && *path ? path : SIM_DEFAULT_LOG, "w");
+    if (!log_file) {
+        panic("não foi possível abrir o log %s", path ? path : SIM_DEFAULT_LOG);
+    }
+    setvbuf(log_file, NULL, _IOFBF, 1 << 16);
+    fprintf(log_file, "time_us,channel,value\n");
+
+    duration_s = env_u32("SIM_DURATION_S", SIM_DEFAULT_DURATION_S);
+    bounces = env_u32("SIM_BUTTON_BOUNCE", 0);
+    if (bounces > SIM_MAX_BOUNCES) {
+        bounces = SIM_MAX_BOUNCES;
+    }
+    display_dump = env_u32("SIM_DISPLAY_DUMP", 0);
+    if (env_u32("SIM_QUIET", 0)) {
+        freopen("/dev/null", "w", stdout);
+    }
+
+    parse_presses(&sim_buttons[0], getenv("SIM_BUTTON_A_MS"));
+    parse_presses(&sim_buttons[1], getenv("SIM_BUTTON_B_MS"));
+    sim_buttons[1].calls_per_hour = env_u32("SIM_PED_CALLS_PER_HOUR", 0);
+    vehicles_per_hour = env_u32("SIM_VEHICLES_PER_HOUR", 0);
+    rng_state = env_u32("SIM_SEED", 1);
+    if (rng_state == 0) {
+        rng_state = 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+}
+
+void sim_record(const char *channel, const char *fmt, ...) {
+    if (!log_file) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(log_file, "%llu,%s,", (unsigned long long)time_us_64(), channel);
+    vfprintf(log_file, fmt, args);
+    fputc('\n', log_file);
+    va_end(args);
+    records++;
+}
+
+/*
+ * Idle sem nada pronto até o próximo prazo: em vez de dormir, avança o tick de
+ * uma vez. Mantém os ganchos de sono do firmware, então power_stats continua
+ * contando despertares e residência como no hardware.
+ */
+void sim_idle_skip(uint32_t expected_idle_ticks) {
+    TickType_t ticks = expected_idle_ticks;
+    configPRE_SLEEP_PROCESSING(ticks);
+    if (ticks > 0) {
+        vTaskStepTick(ticks);
+        idle_skips++;
+        idle_skipped_ticks += ticks;
+    }
+    configPOST_SLEEP_PROCESSING(expected_idle_ticks);
+}
+
+static int64_t button_press(alarm_id_t id, void *user_data);
+
+// xorshift32: sequência reprodutível, igual em qualquer libc
+static uint32_t sim_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Intervalo até a próxima chegada (exponencial), nunca menor que min_gap_ms
+static uint32_t next_arrival_ms(uint32_t per_hour, uint32_t min_gap_ms) {
+    double u = (sim_random() + 1.0) / 4294967297.0;
+    uint32_t gap_ms = (uint32_t)(-log(u) * 3600000.0 / per_hour);
+    return gap_ms < min_gap_ms ? min_gap_ms : gap_ms;
+}
+
+// Agenda só o próximo toque do botão, para não ocupar um alarme por toque
+static void schedule_next_press(sim_button_t *button) {
+    if (button->calls_per_hour > 0) {
+        // Sem sobrepor o toque anterior
+        add_alarm_in_ms(next_arrival_ms(button->calls_per_hour, SIM_BUTTON_PRESS_MS + 100),
+                        button_press, button, true);
+        return;
+    }
+    uint64_t now_ms = time_us_64() / 1000u;
+    while (button->next_press < button->press_count && button->presses_ms[button->next_press] <= now_ms) {
+        button->next_press++; // instantes fora de ordem ou já passados são ignorados
+    }
+    if (button->next_press < button->press_count) {
+        add_alarm_in_ms(button->presses_ms[button->next_press++] - (uint32_t)now_ms, button_press, button, true);
+    }
+}
+
+/*
+ * Oscilação do contato depois de uma borda: alterna o pino a cada
+ * SIM_BOUNCE_EDGE_US e termina no nível final. Ao fim da soltura agenda o
+ * próximo toque.
+ */
+static int64_t button_bounce(alarm_id_t id, void *user_data) {
+    sim_button_t *button = user_data;
+    bool final_level = button->bounce_level;
+    button->bounce_edges_left--;
+    sim_gpio_drive(button->pin, (button->bounce_edges_left % 2u == 0) ? final_level : !final_level);
+    if (button->bounce_edges_left > 0) {
+        return SIM_BOUNCE_EDGE_US;
+    }
+    if (final_level) {
+        schedule_next_press(button);
+    }
+    return 0;
+}
+
+// Borda principal do botão, seguida da oscilação configurada (se houver)
+static void button_edge(sim_button_t *button, bool level) {
+    sim_gpio_drive(button->pin, level);
+    if (bounces > 0) {
+        button->bounce_edges_left = 2u * bounces;
+        button->bounce_level = level;
+        add_alarm_in_us(SIM_BOUNCE_EDGE_US, button_bounce, button, true);
+    } else if (level) {
+        schedule_next_press(button);
+    }
+}
+
+static int64_t button_release(alarm_id_t id, void *user_data) {
+    button_edge(user_data, true);
+    return 0;
+}
+
+static int64_t button_press(alarm_id_t id, void *user_data) {
+    button_edge(user_data, false);
+    add_alarm_in_ms(SIM_BUTTON_PRESS_MS, button_release, user_data, true);
+    return 0;
+}
+
+/*
+ * Veículos: o LED RGB verde (sem o vermelho, que com ele forma o amarelo) é o
+ * direito de passagem. Quem chega no verde com a fila vazia e a faixa livre
+ * passa sem atraso; os demais esperam e saem um por intervalo de saturação.
+ * Atraso = saída - chegada, a medida comparada entre tempo fixo e adaptativo.
+ */
+static bool vehicle_green(void) {
+    return gpio_get(LED_GREEN_PIN) && !gpio_get(LED_RED_PIN);
+}
+
+static void vehicle_depart(uint64_t arrival_us, uint64_t now_us) {
+    vehicles_served++;
+    vehicle_delay_sum_us += now_us - arrival_us;
+    vehicle_last_departure_us = now_us;
+}
+
+static int64_t vehicle_arrival(alarm_id_t id, void *user_data) {
+    uint64_t now_us = time_us_64();
+    vehicles_arrived++;
+    // Laço detector antes da linha de retenção (o alarme já roda como interrupção)
+    detector_arrival_from_isr(SIGNAL_PLAN.vehicle_group);
+    if (vehicle_count == 0 && vehicle_green() &&
+        now_us - vehicle_last_departure_us >= SIM_VEHICLE_HEADWAY_US) {
+        vehicle_depart(now_us, now_us);
+    } else if (vehicle_count < SIM_VEHICLE_QUEUE_MAX) {
+        vehicle_queue_us[(vehicle_head + vehicle_count++) % SIM_VEHICLE_QUEUE_MAX] = now_us;
+        if (vehicle_count > vehicle_queue_max) {
+            vehicle_queue_max = vehicle_count;
+        }
+    } else {
+        vehicles_dropped++;
+    }
+    add_alarm_in_ms(next_arrival_ms(vehicles_per_hour, 1), vehicle_arrival, NULL, true);
+    return 0;
+}
+
+// Escoamento da fila: no máximo um veículo por intervalo de saturação
+static int64_t vehicle_discharge(alarm_id_t id, void *user_data) {
+    uint64_t now_us = time_us_64();
+    if (vehicle_count > 0 && vehicle_green() &&
+        now_us - vehicle_last_departure_us >= SIM_VEHICLE_HEADWAY_US) {
+        vehicle_depart(vehicle_queue_us[vehicle_head], now_us);
+        vehicle_head = (vehicle_head + 1) % SIM_VEHICLE_QUEUE_MAX;
+        vehicle_count--;
+    }
+    return -(int64_t)SIM_VEHICLE_HEADWAY_US / 4;
+}
+
+static void sim_end(TimerHandle_t timer) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double host_s = (double)(now.tv_sec - host_start.tv_sec) + (now.tv_nsec - host_start.tv_nsec) / 1e9;
+    double virtual_s = time_us_64() / 1e6;
+
+    fflush(log_file);
+    fclose(log_file);
+    log_file = NULL;
+
+    if (display_dump) {
+        sim_ssd1306_dump(stderr);
+    }
+    fprintf(stderr, "sim: %.0f s virtuais em %.2f s (%.0fx), %llu registros, %llu saltos do idle (%llu ticks)\n",
+            virtual_s, host_s, host_s > 0 ? virtual_s / host_s : 0.0, (unsigned long long)records,
+            (unsigned long long)idle_skips, (unsigned long long)idle_skipped_ticks);
+    // Precisão do escalonamento das fases (deriva acumulada deve ser 0 em tempo virtual)
+    cycle_stats_t cycles;
+    cycle_stats_get(&cycles);
+    fprintf(stderr, "sim: %lu ciclos, deriva acumulada %ld us, jitter min/max %ld/%ld us\n",
+            (unsigned long)cycles.cycles, (long)cycles.drift_us, (long)cycles.jitter_min_us,
+            (long)cycles.jitter_max_us);
+    // Acordadas por segundo virtual de cada tarefa com laço instrumentado
+    TaskStatus_t tasks[TASK_STATS_MAX_TASKS];
+    UBaseType_t task_total = uxTaskGetSystemState(tasks, TASK_STATS_MAX_TASKS, NULL);
+    fprintf(stderr, "sim: acordadas/s:");
+    for (UBaseType_t i = 0; i < task_total; ++i) {
+        uint32_t wakeups = task_stats_wakeups(tasks[i].xHandle);
+        if (wakeups > 0) {
+            fprintf(stderr, " %s %.2f", tasks[i].pcTaskName, virtual_s > 0 ? wakeups / virtual_s : 0.0);
+        }
+    }
+    fprintf(stderr, "\n");
+    // Carga de interrupções dos botões (com SIM_BUTTON_BOUNCE, mostra o custo da oscilação)
+    uint32_t button_irqs = debouncer_irq_count();
+    uint32_t button_edges = debouncer_edge_count();
+    fprintf(stderr, "sim: botoes (%s): %lu interrupcoes (%.2f/s), %lu bordas limpas (%.1f interrupcoes/borda)\n",
+            DEBOUNCE_USE_PIO ? "pio" : "software", (unsigned long)button_irqs,
+            virtual_s > 0 ? button_irqs / virtual_s : 0.0, (unsigned long)button_edges,
+            button_edges ? (double)button_irqs / button_edges : 0.0);
+    // Modo atuado x tempo fixo: capacidade veicular e espera dos pedestres
+    ped_call_stats_t calls;
+    ped_call_get(&intersection_board()->calls, &calls);
+    fprintf(stderr, "sim: pedestres: %lu chamadas, %lu servidas, espera max/media %lu/%lu ms; verde veicular %.1f%% do tempo\n",
+            (unsigned long)calls.calls, (unsigned long)calls.served, (unsigned long)calls.wait_max_ms,
+            (unsigned long)(calls.served ? calls.wait_sum_ms / calls.served : 0),
+            calls.total_ms ? 100.0 * calls.green_ms / calls.total_ms : 0.0);
+    // Custo de muitos cruzamentos numa só tarefa (-DSIM_INTERSECTIONS=<n>)
+    const intersection_scheduler_t *scheduler = intersection_scheduler();
+    fprintf(stderr, "sim: cruzamentos: %u, %lu fronteiras (%.0f por s de host), ate %u na mesma passada, %u bytes por cruzamento\n",
+            (unsigned)INTERSECTION_COUNT, (unsigned long)scheduler->transitions,
+            host_s > 0 ? scheduler->transitions / host_s : 0.0, scheduler->run_max_transitions,
+            (unsigned)(sizeof(intersection_t) + sizeof(intersection_t *)));
+    // Tempo fixo x adaptativo: atraso médio dos veículos (os que ficaram na fila não entram)
+    if (vehicles_per_hour > 0) {
+        fprintf(stderr, "sim: veiculos: %llu chegadas, %llu passaram, %lu na fila (max %lu, %llu descartados), atraso medio %.1f s\n",
+                (unsigned long long)vehicles_arrived, (unsigned long long)vehicles_served,
+                (unsigned long)vehicle_count, (unsigned long)vehicle_queue_max, (unsigned long long)vehicles_dropped,
+                vehicles_served ? vehicle_delay_sum_us / 1e6 / vehicles_served : 0.0);
+    }
+    fflush(stdout);
+    exit(0);
+}
+
+// Roda na tarefa de timers, antes de qualquer callback: agenda o fim e os toques
+void vApplicationDaemonTaskStartupHook(void) {
+    static TimerHandle_t end_timer;
+    uint64_t duration_ms = (uint64_t)duration_s * 1000u;
+    if (duration_ms > portMAX_DELAY - 1) {
+        duration_ms = portMAX_DELAY - 1;
+    }
+    end_timer = xTimerCreate("sim_end", (TickType_t)duration_ms, pdFALSE, NULL, sim_end);
+    xTimerStart(end_timer, 0);
+    for (size_t i = 0; i < SIM_BUTTON_COUNT; ++i) {
+        schedule_next_press(&sim_buttons[i]);
+    }
+    if (vehicles_per_hour > 0) {
+        add_alarm_in_ms(next_arrival_ms(vehicles_per_hour, 1), vehicle_arrival, NULL, true);
+        add_alarm_in_us(SIM_VEHICLE_HEADWAY_US / 4, vehicle_discharge, NULL, true);
+    }
+}
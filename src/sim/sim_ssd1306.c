@@ -0,0 +1,192 @@
+#include <string.h>
+
+#include "ssd1306_dma.h"
+#include "sim_hal.h"
+
+/*
+ * Modelo do SSD1306 no host: interpreta as transações I2C (byte de controle
+ * 0x00/0x80 = comandos, 0x40 = dados), mantém a GDDRAM e o endereçamento
+ * horizontal/vertical/página e grava no log um CRC da tela a cada mudança.
+ * Também substitui ssd1306_dma.c: o barramento assíncrono entrega o quadro ao
+ * modelo depois do tempo que levaria a 400 kHz e chama ssd1306_transfer_done.
+ */
+
+#define SIM_SSD1306_COLS   128
+#define SIM_SSD1306_PAGES  8
+#define SIM_I2C_WORD_NS    22500 // 9 bits (byte + ACK) a 400 kHz
+
+static uint8_t gddram[SIM_SSD1306_PAGES][SIM_SSD1306_COLS];
+static uint8_t mem_mode = 2; // 0 = horizontal, 1 = vertical, 2 = página (reset)
+static uint8_t col_start, col_end = SIM_SSD1306_COLS - 1, col;
+static uint8_t page_start, page_end = SIM_SSD1306_PAGES - 1, page;
+static bool display_on;
+
+// Comando com argumentos em andamento (podem vir em transações separadas)
+static uint8_t cmd_op, cmd_args[2], cmd_need, cmd_have;
+
+static uint32_t last_crc;
+static bool last_crc_valid;
+
+static uint32_t crc32(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; ++i) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+        }
+    }
+    return ~crc;
+}
+
+static uint8_t command_arg_count(uint8_t op) {
+    switch (op) {
+        case SET_COL_ADDR:
+        case SET_PAGE_ADDR:
+            return 2;
+        case SET_MEM_ADDR:
+        case SET_CONTRAST:
+        case SET_MUX_RATIO:
+        case SET_DISP_OFFSET:
+        case SET_COM_PIN_CFG:
+        case SET_DISP_CLK_DIV:
+        case SET_PRECHARGE:
+        case SET_VCOM_DESEL:
+        case SET_CHARGE_PUMP:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void command_apply(void) {
+    switch (cmd_op) {
+        case SET_MEM_ADDR:
+            mem_mode = cmd_args[0] & 3;
+            break;
+        case SET_COL_ADDR:
+            col_start = col = cmd_args[0] & 0x7F;
+            col_end = cmd_args[1] & 0x7F;
+            break;
+        case SET_PAGE_ADDR:
+            page_start = page = cmd_args[0] & 7;
+            page_end = cmd_args[1] & 7;
+            break;
+        case SET_DISP:
+        case SET_DISP | 1:
+            display_on = cmd_op & 1;
+            sim_record("display_on", "%d", display_on);
+            break;
+        default:
+            break;
+    }
+}
+
+static void command_byte(uint8_t b) {
+    if (cmd_have < cmd_need) {
+        cmd_args[cmd_have++] = b;
+    } else {
+        cmd_op = b;
+        cmd_need = command_arg_count(b);
+        cmd_have = 0;
+    }
+    if (cmd_have == cmd_need) {
+        command_apply();
+    }
+}
+
+static void data_byte(uint8_t b) {
+    gddram[page][col] = b;
+    if (mem_mode == 1) {
+        if (page++ == page_end) {
+            page = page_start;
+            col = col == col_end ? col_start : col + 1;
+        }
+    } else {
+        if (col++ == col_end) {
+            col = col_start;
+            if (mem_mode == 0) {
+                page = page == page_end ? page_start : page + 1;
+            }
+        }
+    }
+}
+
+void sim_ssd1306_transaction(const uint8_t *bytes, size_t len) {
+    if (len < 2) {
+        return;
+    }
+    bool data = bytes[0] & 0x40;
+    for (size_t i = 1; i < len; ++i) {
+        if (data) {
+            data_byte(bytes[i]);
+        } else {
+            command_byte(bytes[i]);
+        }
+    }
+    if (!data) {
+        return;
+    }
+    uint32_t crc = crc32(&gddram[0][0], sizeof(gddram));
+    if (!last_crc_valid || crc != last_crc) {
+        last_crc = crc;
+        last_crc_valid = true;
+        sim_record("display", "%08x", crc);
+    }
+}
+
+// Tela em ASCII ('#' = pixel aceso), uma linha por linha de pixels
+void sim_ssd1306_dump(FILE *out) {
+    for (int y = 0; y < SIM_SSD1306_PAGES * 8; ++y) {
+        char line[SIM_SSD1306_COLS + 1];
+        for (int x = 0; x < SIM_SSD1306_COLS; ++x) {
+            line[x] = (gddram[y >> 3][x] >> (y & 7)) & 1 ? '#' : '.';
+        }
+        line[SIM_SSD1306_COLS] = '\0';
+        fprintf(out, "%s\n", line);
+    }
+}
+
+void sim_ssd1306_read(uint8_t *dst, size_t len) {
+    memcpy(dst, gddram, len < sizeof(gddram) ? len : sizeof(gddram));
+}
+
+// ------------------------------------------------------------------ barramento assíncrono
+
+static ssd1306_bus_t sim_bus;
+static uint16_t bus_words[SSD1306_ASYNC_WORDS];
+static size_t bus_count;
+static bool bus_busy;
+
+// Fim do envio: entrega as transações (separadas pelo bit de STOP) ao modelo
+static int64_t sim_bus_done(alarm_id_t id, void *user_data) {
+    uint8_t transaction[SSD1306_ASYNC_WORDS];
+    size_t len = 0;
+    for (size_t i = 0; i < bus_count; ++i) {
+        transaction[len++] = bus_words[i] & 0xFF;
+        if (bus_words[i] & SSD1306_WORD_STOP) {
+            sim_ssd1306_transaction(transaction, len);
+            len = 0;
+        }
+    }
+    sim_ssd1306_transaction(transaction, len);
+    bus_busy = false;
+    ssd1306_transfer_done(user_data, true);
+    return 0;
+}
+
+static bool sim_bus_start(void *ctx, const uint16_t *words, size_t count) {
+    if (bus_busy || count > SSD1306_ASYNC_WORDS) {
+        return false;
+    }
+    memcpy(bus_words, words, count * sizeof(words[0]));
+    bus_count = count;
+    bus_busy = true;
+    add_alarm_in_us((uint64_t)count * SIM_I2C_WORD_NS / 1000u, sim_bus_done, ctx, true);
+    return true;
+}
+
+void ssd1306_dma_init(ssd1306_t *ssd) {
+    sim_bus.start = sim_bus_start;
+    sim_bus.ctx = ssd;
+    ssd1306_set_bus(ssd, &sim_bus);
+}
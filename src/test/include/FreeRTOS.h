@@ -0,0 +1,33 @@
+#ifndef TEST_FREERTOS_H
+#define TEST_FREERTOS_H
+
+/*
+ * Dublê do FreeRTOS para os testes de host (alvo traffic_tests): só os tipos e
+ * macros que os módulos testados usam. Não há escalonador: o tick é o relógio
+ * virtual de test_hal.c (1 tick = 1 ms) e, com uma thread só, as seções
+ * críticas não precisam fazer nada.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+
+#include "FreeRTOSConfig.h"
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+#define portMAX_DELAY           ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000u))
+#define pdTICKS_TO_MS(ticks)    ((TickType_t)(((uint64_t)(ticks) * 1000u) / configTICK_RATE_HZ))
+#define portYIELD_FROM_ISR(x)   ((void)(x))
+#define portGET_CORE_ID()       0
+
+#endif // TEST_FREERTOS_H
@@ -0,0 +1,9 @@
+#ifndef TEST_EVENT_GROUPS_H
+#define TEST_EVENT_GROUPS_H
+
+#include "FreeRTOS.h"
+
+typedef void *EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+#endif // TEST_EVENT_GROUPS_H
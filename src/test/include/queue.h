@@ -0,0 +1,8 @@
+#ifndef TEST_QUEUE_H
+#define TEST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+#endif // TEST_QUEUE_H
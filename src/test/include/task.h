@@ -0,0 +1,17 @@
+#ifndef TEST_TASK_H
+#define TEST_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+// Tick do relógio virtual (test_hal.c)
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+
+#define taskENTER_CRITICAL()            ((void)0)
+#define taskEXIT_CRITICAL()             ((void)0)
+#define taskENTER_CRITICAL_FROM_ISR()   ((UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)   ((void)(x))
+
+#endif // TEST_TASK_H
@@ -0,0 +1,292 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "buzzer.h"
+#include "config.h"
+#include "test_hal.h"
+
+/*
+ * Sequenciador do buzzer no relógio virtual: as bordas do som são as mudanças
+ * de frequência do PWM no pino. Confere o ritmo de um padrão de fundo por
+ * RHYTHM_CYCLES ciclos com alarmes atrasados (latência de interrupção), que
+ * não pode acumular, e a ordem exata fila -> fundo quando padrões finitos
+ * interrompem o fundo, e que sem alarme livre o tom não fica preso. Também mede o erro de cada tom (buzzer_tone e
+ * BUZZER_TONE contra a antiga busca do divisor em laço) e o custo por chamada.
+ */
+
+#define RHYTHM_CYCLES  10000
+#define LATENCY_US     400   // atraso máximo sorteado para cada disparo de alarme
+#define CHUNK_CYCLES   1000  // ciclos lidos por vez (cabe no log do PWM)
+#define TONE_PPM       20.0  // erro aceito entre o tom pedido e o tocado
+#define SWEEP_MIN_HZ   20
+#define SWEEP_MAX_HZ   20000
+#define BENCH_CALLS    1000000
+
+typedef struct {
+    uint64_t time_us;
+    double hz;
+} edge_t;
+
+// Bordas do pino do buzzer desde a última leitura. O driver escreve divisor,
+// wrap e nível em sequência; mudanças no mesmo instante contam como uma.
+static size_t read_edges(edge_t *edges, size_t max) {
+    size_t count, n = 0;
+    const test_pwm_change_t *log = test_pwm_log(&count);
+    for (size_t i = 0; i < count; ++i) {
+        if (log[i].gpio != BUZZER_PIN_1) {
+            continue;
+        }
+        if (n > 0 && edges[n - 1].time_us == log[i].time_us) {
+            edges[n - 1].hz = log[i].hz;
+        } else if (n < max) {
+            edges[n++] = (edge_t){ log[i].time_us, log[i].hz };
+        }
+    }
+    test_pwm_log_clear();
+    return n;
+}
+
+static bool tone_is(double hz, uint freq) {
+    return freq == 0 ? hz == 0.0 : fabs(hz - freq) / freq < TONE_PPM * 1e-6;
+}
+
+// Padrão de fundo: cada borda cai no prazo previsto (início + ciclos inteiros),
+// atrasada só pela latência do próprio disparo
+static void background_rhythm(void) {
+    static edge_t edges[2 * CHUNK_CYCLES + 4];
+    const uint64_t on_us = BUZZER_WALK_ON_MS * 1000ull;
+    const uint64_t period_us = (BUZZER_WALK_ON_MS + BUZZER_WALK_OFF_MS) * 1000ull;
+
+    test_set_alarm_latency_us(LATENCY_US);
+    test_pwm_log_clear();
+    uint64_t start = time_us_64();
+    buzzer_play_tone_pattern(BUZZER_WALK_TONE, BUZZER_WALK_ON_MS, BUZZER_WALK_OFF_MS, BUZZER_REPEAT_FOREVER);
+
+    uint64_t edge_index = 0, worst_late = 0, late_sum = 0, last_late = 0;
+    int wrong = 0;
+    for (int chunk = 0; chunk < RHYTHM_CYCLES / CHUNK_CYCLES; ++chunk) {
+        test_run_until_us(start + (uint64_t)(chunk + 1) * CHUNK_CYCLES * period_us - 1);
+        size_t n = read_edges(edges, sizeof(edges) / sizeof(edges[0]));
+        CHECK(n == 2 * CHUNK_CYCLES);
+        for (size_t i = 0; i < n; ++i, ++edge_index) {
+            bool on = (edge_index % 2) == 0;
+            uint64_t expected = start + (edge_index / 2) * period_us + (on ? 0 : on_us);
+            uint64_t late = edges[i].time_us - expected;
+            if (edges[i].time_us < expected || late > LATENCY_US ||
+                !tone_is(edges[i].hz, on ? BUZZER_WALK_FREQ : 0)) {
+                wrong++;
+            }
+            worst_late = late > worst_late ? late : worst_late;
+            late_sum += late;
+            last_late = late;
+        }
+    }
+    test_set_alarm_latency_us(0);
+    CHECK(wrong == 0);
+    printf("fundo %u/%u ms por %d ciclos, alarmes atrasados 0..%d us: %llu bordas, %d fora do prazo\n",
+           BUZZER_WALK_ON_MS, BUZZER_WALK_OFF_MS, RHYTHM_CYCLES, LATENCY_US,
+           (unsigned long long)edge_index, wrong);
+    printf("  pior atraso %llu us, ultima borda %llu us apos o previsto (reagendar a partir do\n"
+           "  disparo somaria os atrasos: %.2f s ao fim)\n",
+           (unsigned long long)worst_late, (unsigned long long)last_late, late_sum / 1e6);
+}
+
+// Padrões finitos interrompem o fundo, tocam em ordem e o fundo recomeça do início
+static void preemption(void) {
+    buzzer_play_tone_pattern(BUZZER_FLASH_TONE, BUZZER_FLASH_ON_MS, BUZZER_FLASH_OFF_MS, BUZZER_REPEAT_FOREVER);
+    test_run_for_us(1075000); // parte OFF do quarto ciclo de 300 ms
+    test_pwm_log_clear();
+
+    uint64_t start = time_us_64();
+    CHECK(buzzer_play_tone_pattern(BUZZER_MODE_TONE, BUZZER_MODE_ON_MS, 0, 1));
+    CHECK(buzzer_play_tone_pattern(BUZZER_CALL_TONE, BUZZER_CALL_ON_MS, BUZZER_CALL_OFF_MS, 3));
+    test_run_for_us(700000);
+
+    const struct { uint32_t at_ms; uint freq; } expected[] = {
+        {   0, BUZZER_MODE_FREQ },                          // interrompe o fundo na hora
+        {  30, BUZZER_CALL_FREQ }, {  90, 0 },              // chamada, 3 ciclos de 60/60
+        { 150, BUZZER_CALL_FREQ }, { 210, 0 },
+        { 270, BUZZER_CALL_FREQ }, { 330, 0 },
+        { 390, BUZZER_FLASH_FREQ }, { 540, 0 },             // fila vazia: fundo desde o início
+        { 690, BUZZER_FLASH_FREQ },
+    };
+    const size_t count = sizeof(expected) / sizeof(expected[0]);
+    edge_t edges[16];
+    size_t n = read_edges(edges, 16);
+    CHECK(n == count);
+    for (size_t i = 0; i < n && i < count; ++i) {
+        if (!CHECK(edges[i].time_us == start + expected[i].at_ms * 1000ull) ||
+            !CHECK(tone_is(edges[i].hz, expected[i].freq))) {
+            printf("  borda %zu: %llu us, %.3f Hz\n", i, (unsigned long long)(edges[i].time_us - start), edges[i].hz);
+        }
+    }
+    printf("fila sobre o fundo: %zu bordas nos instantes previstos\n", n);
+}
+
+// Fila cheia recusa; buzzer_stop cala na hora e descarta fila e fundo
+static void queue_and_stop(void) {
+    buzzer_stop();
+    // O primeiro sai da fila na hora para tocar; cabem mais BUZZER_QUEUE_LEN
+    for (int i = 0; i < BUZZER_QUEUE_LEN + 1; ++i) {
+        CHECK(buzzer_play_pattern(BUZZER_CALL_FREQ, BUZZER_CALL_ON_MS, BUZZER_CALL_OFF_MS, 1));
+    }
+    CHECK(!buzzer_play_pattern(BUZZER_CALL_FREQ, BUZZER_CALL_ON_MS, BUZZER_CALL_OFF_MS, 1));
+    test_run_for_us(10000);
+    CHECK(tone_is(test_pwm_hz(BUZZER_PIN_1), BUZZER_CALL_FREQ));
+
+    buzzer_stop();
+    CHECK(test_pwm_hz(BUZZER_PIN_1) == 0.0);
+    test_pwm_log_clear();
+    test_run_for_us(10000000);
+    edge_t edges[4];
+    CHECK(read_edges(edges, 4) == 0);
+    CHECK(!test_events_pending());
+
+    // Tom contínuo: fica ligado sem alarme até ser parado
+    buzzer_play_tone(BUZZER_STOP_FREQ, 0);
+    CHECK(tone_is(test_pwm_hz(BUZZER_PIN_1), BUZZER_STOP_FREQ));
+    CHECK(!test_events_pending());
+    buzzer_play_tone(0, 0);
+    CHECK(test_pwm_hz(BUZZER_PIN_1) == 0.0);
+}
+
+// Sem alarme livre para as bordas: o tom não fica ligado, e o próximo pedido toca
+static int64_t never_fires(alarm_id_t id, void *user_data) {
+    return 0;
+}
+
+static void no_free_alarm(void) {
+    buzzer_stop();
+    alarm_id_t fillers[64];
+    size_t filled = 0;
+    while (filled < sizeof(fillers) / sizeof(fillers[0])) {
+        alarm_id_t id = add_alarm_in_us(3600000000ull, never_fires, NULL, true);
+        if (id < 0) {
+            break;
+        }
+        fillers[filled++] = id;
+    }
+    CHECK(filled < sizeof(fillers) / sizeof(fillers[0]));
+
+    CHECK(buzzer_play_pattern(BUZZER_CALL_FREQ, BUZZER_CALL_ON_MS, BUZZER_CALL_OFF_MS, 2));
+    CHECK(test_pwm_hz(BUZZER_PIN_1) == 0.0);
+    buzzer_play_tone(BUZZER_STOP_FREQ, 0); // contínuo: não precisa de alarme e toca
+    CHECK(tone_is(test_pwm_hz(BUZZER_PIN_1), BUZZER_STOP_FREQ));
+    buzzer_stop();
+
+    for (size_t i = 0; i < filled; ++i) {
+        cancel_alarm(fillers[i]);
+    }
+    test_pwm_log_clear();
+    CHECK(buzzer_play_pattern(BUZZER_CALL_FREQ, BUZZER_CALL_ON_MS, BUZZER_CALL_OFF_MS, 1));
+    CHECK(tone_is(test_pwm_hz(BUZZER_PIN_1), BUZZER_CALL_FREQ));
+    test_run_for_us((uint64_t)(BUZZER_CALL_ON_MS + BUZZER_CALL_OFF_MS) * 1000u + 1000u);
+    CHECK(test_pwm_hz(BUZZER_PIN_1) == 0.0);
+    CHECK(!test_events_pending());
+    printf("sem alarme livre: tom calado na hora; com alarme de novo, o padrao toca e termina\n");
+}
+
+// ------------------------------------------------------------------ tons
+
+// Busca do divisor usada antes de buzzer_tone (clock fixo de 125 MHz no lugar
+// de clock_get_hz); o período saía com wrap_val + 1 contagens
+static buzzer_tone_t old_tone(uint freq) {
+    uint32_t clock = BUZZER_CLK_HZ;
+    uint32_t divider16 = clock * 16 / freq;
+    uint32_t wrap_val = 65535;
+    uint clk_div = 1;
+    while (divider16 >= 16 * wrap_val && clk_div < 256) {
+        clk_div++;
+        divider16 = clock * 16 / (freq * clk_div);
+    }
+    if (divider16 < 16) divider16 = 16;
+    wrap_val = divider16 / 16;
+    return (buzzer_tone_t){ .wrap = (uint16_t)wrap_val, .clk_div = (uint8_t)clk_div };
+}
+
+static double tone_hz(buzzer_tone_t tone) {
+    return (double)BUZZER_CLK_HZ / (tone.clk_div * (tone.wrap + 1.0));
+}
+
+static double tone_ppm(buzzer_tone_t tone, uint freq) {
+    return (tone_hz(tone) / freq - 1.0) * 1e6;
+}
+
+static bool same_tone(buzzer_tone_t a, buzzer_tone_t b) {
+    return a.wrap == b.wrap && a.clk_div == b.clk_div;
+}
+
+// Erro dos tons do config.h e de toda a faixa audível, antes e depois
+static void tone_error(void) {
+    static const uint presets[] = {
+        BUZZER_WALK_FREQ, BUZZER_FLASH_FREQ, BUZZER_CALL_FREQ, BUZZER_STOP_FREQ, BUZZER_NIGHT_FREQ,
+    };
+    const buzzer_tone_t preset_tones[] = {
+        BUZZER_WALK_TONE, BUZZER_FLASH_TONE, BUZZER_CALL_TONE, BUZZER_STOP_TONE, BUZZER_NIGHT_TONE,
+    };
+    printf("\n  %6s %14s %12s %9s %14s %9s\n", "Hz", "div/wrap", "tocado", "ppm", "antes", "ppm");
+    for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); ++i) {
+        buzzer_tone_t tone = buzzer_tone(presets[i]), old = old_tone(presets[i]);
+        CHECK(same_tone(tone, preset_tones[i]));
+        char now_cfg[16], old_cfg[16];
+        snprintf(now_cfg, sizeof(now_cfg), "%u/%u", tone.clk_div, tone.wrap);
+        snprintf(old_cfg, sizeof(old_cfg), "%u/%u", old.clk_div, old.wrap);
+        printf("  %6u %14s %12.4f %+9.1f %14s %+9.1f\n", presets[i], now_cfg, tone_hz(tone),
+               tone_ppm(tone, presets[i]), old_cfg, tone_ppm(old, presets[i]));
+    }
+
+    // Na faixa toda: macro e função iguais, e o período arredondado para a
+    // contagem mais próxima (erro de no máximo meia contagem)
+    double worst = 0.0, worst_old = 0.0;
+    int differ = 0, off_bound = 0;
+    for (uint f = SWEEP_MIN_HZ; f <= SWEEP_MAX_HZ; ++f) {
+        buzzer_tone_t tone = buzzer_tone(f);
+        if (!same_tone(tone, BUZZER_TONE(f))) {
+            differ++;
+        }
+        double exact = (double)BUZZER_CLK_HZ / ((double)tone.clk_div * f);
+        if (fabs(exact - (tone.wrap + 1.0)) > 0.5) {
+            off_bound++;
+        }
+        worst = fmax(worst, fabs(tone_ppm(tone, f)));
+        worst_old = fmax(worst_old, fabs(tone_ppm(old_tone(f), f)));
+    }
+    CHECK(differ == 0);
+    CHECK(off_bound == 0);
+    CHECK(worst <= worst_old);
+    printf("  %u..%u Hz: pior erro %.1f ppm (antes %.1f), BUZZER_TONE diferente de buzzer_tone em %d\n",
+           SWEEP_MIN_HZ, SWEEP_MAX_HZ, worst, worst_old, differ);
+}
+
+static volatile uint bench_freq;
+static volatile uint32_t bench_sink;
+
+static double bench_ns(buzzer_tone_t (*compute)(uint), uint freq) {
+    bench_freq = freq;
+    uint64_t start = test_host_ns();
+    for (int i = 0; i < BENCH_CALLS; ++i) {
+        buzzer_tone_t tone = compute(bench_freq);
+        bench_sink = tone.wrap;
+    }
+    return (double)(test_host_ns() - start) / BENCH_CALLS;
+}
+
+// Custo por chamada no host: a busca antiga itera mais quanto mais grave o tom
+static void tone_cost(void) {
+    static const uint freqs[] = { BUZZER_WALK_FREQ, BUZZER_STOP_FREQ, 100, 20 };
+    printf("\n  %6s %12s %14s\n", "Hz", "laco (ns)", "buzzer_tone (ns)");
+    for (size_t i = 0; i < sizeof(freqs) / sizeof(freqs[0]); ++i) {
+        printf("  %6u %12.1f %14.1f\n", freqs[i], bench_ns(old_tone, freqs[i]), bench_ns(buzzer_tone, freqs[i]));
+    }
+}
+
+int main(void) {
+    buzzer_init();
+    background_rhythm();
+    preemption();
+    queue_and_stop();
+    no_free_alarm();
+    tone_error();
+    tone_cost();
+    return test_finish("test_buzzer");
+}
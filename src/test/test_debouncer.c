@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debouncer.h"
+#include "config.h"
+#include "sim_hal.h"
+#include "test_hal.h"
+
+/*
+ * Debounce dos botões, compilado duas vezes: test_debouncer_pio (SM de
+ * button_debounce.pio, pelo modelo de sim_pio_debounce.c) e test_debouncer_sw
+ * (interrupção de GPIO + DEBOUNCE_TIME_US). Gestos de aperto e soltura em dois
+ * botões, com o contato oscilando antes de assentar, e, no PIO, interrupção
+ * atendida com atraso sorteado. Confere que cada gesto vira exatamente uma
+ * borda de aperto e uma de soltura, na ordem, e o instante entregue:
+ *   - PIO: a primeira das N amostras estáveis, entre a primeira oscilação e
+ *     uma amostra depois da última (oscilações entre duas amostras não são
+ *     vistas), e igual com e sem latência na interrupção;
+ *   - software: a primeira oscilação (a borda é aceita nela).
+ * Imprime interrupções por borda limpa e por segundo de cada caso.
+ */
+
+#define CHANNELS        2
+#define GESTURES        2000
+#define BOUNCE_MAX_US   400     // intervalo máximo entre duas oscilações
+#define HOLD_MIN_MS     30      // aperto e intervalo entre gestos: acima de DEBOUNCE_TIME_US
+#define HOLD_MAX_MS     300
+#define MAX_EDGES       (2 * GESTURES + 16)
+// Casos começam em múltiplos do período de amostragem, para a mesma sequência
+// de gestos cair na mesma fase da grade de amostras
+#define CASE_SPACING_US ((uint64_t)DEBOUNCE_PIO_SAMPLE_US * 20000000u)
+
+static const uint pins[CHANNELS] = { 5, 6 };
+
+typedef struct {
+    uint8_t channel;
+    bool pressed;
+    uint64_t first_us;  // primeira transição do contato
+    uint64_t last_us;   // última transição: o contato assentou
+} expected_edge_t;
+
+typedef struct {
+    uint8_t channel;
+    bool pressed;
+    uint32_t time_us;   // instante entregue pelo debouncer
+    uint32_t irq_us;    // hora da interrupção que entregou
+} delivered_edge_t;
+
+static expected_edge_t expected[MAX_EDGES];
+static delivered_edge_t delivered[MAX_EDGES];
+static size_t expected_count, delivered_count;
+
+static void on_edge(uint8_t channel, bool pressed, uint32_t time_us) {
+    if (delivered_count < MAX_EDGES) {
+        delivered[delivered_count++] = (delivered_edge_t){
+            .channel = channel, .pressed = pressed, .time_us = time_us, .irq_us = time_us_32(),
+        };
+    }
+}
+
+static uint32_t rand_range(uint32_t min, uint32_t max) {
+    return min + (uint32_t)rand() % (max - min + 1);
+}
+
+// Uma transição limpa com `bounces` idas e voltas antes de assentar em `level`
+static void drive_transition(uint8_t channel, bool level, uint32_t bounces, uint64_t *now_us) {
+    expected_edge_t *e = &expected[expected_count++];
+    *e = (expected_edge_t){ .channel = channel, .pressed = !level, .first_us = *now_us };
+    for (uint32_t i = 0; i < 2 * bounces + 1; ++i) {
+        if (i > 0) {
+            *now_us += rand_range(20, BOUNCE_MAX_US);
+        }
+        test_run_until_us(*now_us);
+        sim_gpio_drive(pins[channel], (i % 2 == 0) ? level : !level);
+    }
+    e->last_us = *now_us;
+}
+
+typedef struct {
+    uint32_t irqs;
+    uint32_t edges;
+    double seconds;
+    uint32_t wrong;         // borda faltando, sobrando, trocada ou fora de ordem
+    uint32_t early;         // antes da primeira oscilação ou depois de uma amostra do assentamento
+    int32_t err_min, err_max;           // instante entregue - referência do backend
+    int32_t irq_err_min, irq_err_max;   // hora da IRQ - atraso da integração - assentamento
+} run_result_t;
+
+static int32_t edge_err[MAX_EDGES]; // instante entregue - assentamento, por borda
+
+static run_result_t run(uint32_t bounces, uint32_t latency_us, uint64_t start_us) {
+    srand(bounces * 7919u);
+    test_set_alarm_latency_us(latency_us);
+    test_run_until_us(start_us);
+    expected_count = delivered_count = 0;
+    uint32_t irqs_before = debouncer_irq_count(), edges_before = debouncer_edge_count();
+
+    uint64_t now_us = start_us;
+    for (int g = 0; g < GESTURES; ++g) {
+        uint8_t channel = (uint8_t)(rand() % CHANNELS);
+        drive_transition(channel, false, bounces, &now_us);
+        now_us += (uint64_t)rand_range(HOLD_MIN_MS, HOLD_MAX_MS) * 1000u;
+        drive_transition(channel, true, bounces, &now_us);
+        now_us += (uint64_t)rand_range(HOLD_MIN_MS, HOLD_MAX_MS) * 1000u;
+    }
+    test_run_until_us(now_us);
+
+    run_result_t r = {
+        .irqs = debouncer_irq_count() - irqs_before,
+        .edges = debouncer_edge_count() - edges_before,
+        .seconds = (now_us - start_us) / 1e6,
+        .err_min = INT32_MAX, .err_max = INT32_MIN,
+        .irq_err_min = INT32_MAX, .irq_err_max = INT32_MIN,
+    };
+    if (delivered_count != expected_count) {
+        r.wrong += delivered_count > expected_count ? delivered_count - expected_count
+                                                    : expected_count - delivered_count;
+    }
+    for (size_t i = 0; i < delivered_count && i < expected_count; ++i) {
+        const expected_edge_t *e = &expected[i];
+        const delivered_edge_t *d = &delivered[i];
+        if (d->channel != e->channel || d->pressed != e->pressed) {
+            r.wrong++;
+            continue;
+        }
+        int32_t from_first = (int32_t)(d->time_us - (uint32_t)e->first_us);
+        edge_err[i] = (int32_t)(d->time_us - (uint32_t)e->last_us);
+#if DEBOUNCE_USE_PIO
+        if (from_first < 0 || edge_err[i] >= DEBOUNCE_PIO_SAMPLE_US) {
+            r.early++;
+        }
+        int32_t err = edge_err[i];
+        int32_t irq_err = (int32_t)(d->irq_us - DEBOUNCE_PIO_SAMPLE_US * DEBOUNCE_PIO_STABLE_SAMPLES
+                                    - (uint32_t)e->last_us);
+#else
+        int32_t err = from_first;
+        int32_t irq_err = (int32_t)(d->irq_us - (uint32_t)e->first_us);
+#endif
+        r.err_min = err < r.err_min ? err : r.err_min;
+        r.err_max = err > r.err_max ? err : r.err_max;
+        r.irq_err_min = irq_err < r.irq_err_min ? irq_err : r.irq_err_min;
+        r.irq_err_max = irq_err > r.irq_err_max ? irq_err : r.irq_err_max;
+    }
+    return r;
+}
+
+static void check_run(const char *label, uint32_t bounces, uint32_t latency_us, uint64_t start_us) {
+    run_result_t r = run(bounces, latency_us, start_us);
+    CHECK(r.wrong == 0);
+    CHECK(r.edges == 2 * GESTURES);
+#if DEBOUNCE_USE_PIO
+    CHECK(r.irqs <= r.edges);  // uma por borda limpa, no máximo
+    CHECK(r.early == 0);
+    if (bounces == 0) {
+        CHECK(r.err_min >= 0); // sem oscilação: a primeira amostra depois da borda
+    }
+#else
+    CHECK(r.irqs == r.edges * (2 * bounces + 1)); // uma por transição do contato
+    CHECK(r.err_min == 0 && r.err_max == 0);
+#endif
+    printf("%s: %lu oscilacoes por borda, latencia ate %lu us: %lu interrupcoes, %lu bordas limpas "
+           "(%.2f interrupcoes/borda, %.1f interrupcoes/s)\n",
+           label, (unsigned long)bounces, (unsigned long)latency_us, (unsigned long)r.irqs,
+           (unsigned long)r.edges, r.edges ? (double)r.irqs / r.edges : 0.0, r.irqs / r.seconds);
+#if DEBOUNCE_USE_PIO
+    printf("  instante entregue - contato assentado: %ld..%ld us; pela hora da IRQ seria %ld..%ld us\n",
+           (long)r.err_min, (long)r.err_max, (long)r.irq_err_min, (long)r.irq_err_max);
+#else
+    printf("  instante entregue - primeira oscilacao: %ld..%ld us\n", (long)r.err_min, (long)r.err_max);
+#endif
+}
+
+int main(void) {
+    debouncer_init(pins, CHANNELS, on_edge);
+
+#if DEBOUNCE_USE_PIO
+    const char *label = "pio";
+#else
+    const char *label = "software";
+#endif
+    const uint32_t bounces[] = { 0, 5, 20 };
+    uint64_t start_us = CASE_SPACING_US;
+    for (size_t b = 0; b < sizeof(bounces) / sizeof(bounces[0]); ++b) {
+#if DEBOUNCE_USE_PIO
+        // Mesmos gestos sem e com latência: os instantes entregues não mudam
+        static int32_t without_latency[MAX_EDGES];
+        check_run(label, bounces[b], 0, start_us);
+        memcpy(without_latency, edge_err, sizeof(edge_err));
+        start_us += CASE_SPACING_US;
+        check_run(label, bounces[b], 3000, start_us);
+        CHECK(memcmp(without_latency, edge_err, 2 * GESTURES * sizeof(int32_t)) == 0);
+#else
+        check_run(label, bounces[b], 0, start_us);
+#endif
+        start_us += CASE_SPACING_US;
+    }
+#if DEBOUNCE_USE_PIO
+    // Relógio de amostras de 31 bits dando a volta (~57 h de partida) no meio dos gestos
+    printf("volta do relogio de amostras:\n");
+    check_run(label, 5, 3000, (1ull << 31) * DEBOUNCE_PIO_SAMPLE_US - 60000000u);
+#endif
+    return test_finish("test_debouncer");
+}
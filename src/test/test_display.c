@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "display.h"
+#include "config.h"
+#include "signal_plan.h"
+#include "sim_hal.h"
+#include "test_hal.h"
+
+/*
+ * Tráfego I2C do display: para cada plano, percorre as telas na ordem do ciclo
+ * (mais a do modo noturno) e mede os bytes que ssd1306_flush põe no barramento
+ * a cada troca, contra o envio do quadro inteiro (ssd1306_send_data). O modelo
+ * do SSD1306 da simulação confere que o painel terminou igual ao framebuffer.
+ */
+
+#define FRAME_PAGES  (HEIGHT / 8)
+
+static ssd1306_t ssd;
+
+static bool panel_matches(void) {
+    uint8_t glass[FRAME_PAGES * WIDTH];
+    sim_ssd1306_read(glass, sizeof(glass));
+    for (uint8_t page = 0; page < FRAME_PAGES; ++page) {
+        for (uint8_t x = 0; x < WIDTH; ++x) {
+            if (glass[page * WIDTH + x] != ssd.ram_buffer[1 + (x << 3) + page]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Bytes medidos no I2C por uma chamada de ssd1306_flush (confere o retorno)
+static size_t flush_bytes(void) {
+    size_t before = test_i2c_bytes();
+    size_t reported = ssd1306_flush(&ssd);
+    size_t sent = test_i2c_bytes() - before;
+    CHECK(reported == sent);
+    return sent;
+}
+
+static size_t full_frame_bytes(void) {
+    size_t before = test_i2c_bytes();
+    ssd1306_send_data(&ssd);
+    return test_i2c_bytes() - before;
+}
+
+static void screens_of_plan(const signal_plan_t *plan) {
+    display_frame_cache_init(&ssd, plan);
+    display_show_state(&ssd, false, plan->start_step);
+    size_t full = full_frame_bytes();
+    CHECK(panel_matches());
+
+    printf("\nplano \"%s\": quadro inteiro = %zu bytes\n", plan->name, full);
+    printf("  %-5s %-34s %8s %10s\n", "passo", "tela", "bytes", "repetida");
+    size_t worst = 0, total = 0, transitions = 0;
+    uint8_t step = plan->start_step;
+    for (uint8_t n = 0; n <= plan->step_count; ++n) {
+        bool night = (n == plan->step_count); // por último, a entrada no modo noturno
+        uint8_t shown = night ? plan->night_step : plan->steps[step].next;
+        display_show_state(&ssd, night, shown);
+        size_t sent = flush_bytes();
+        CHECK(panel_matches());
+        // A mesma tela de novo: o shadow recorta tudo, nada vai ao barramento
+        display_show_state(&ssd, night, shown);
+        size_t repeated = flush_bytes();
+        CHECK(repeated == 0);
+        CHECK(sent < full);
+
+        char label[35];
+        snprintf(label, sizeof(label), "%s", plan->steps[shown].text);
+        for (char *c = label; *c; ++c) {
+            if (*c == '\n') {
+                *c = '/';
+            }
+        }
+        printf("  %-5u %-34s %8zu %10zu\n", shown, label, sent, repeated);
+        worst = sent > worst ? sent : worst;
+        total += sent;
+        transitions++;
+        if (!night) {
+            step = shown;
+        }
+    }
+    printf("  media %zu bytes por troca, pior %zu (antes: %zu sempre)\n", total / transitions, worst, full);
+}
+
+// Desenhos aleatórios: o flush parcial precisa deixar o painel igual ao framebuffer
+static void random_drawing(void) {
+    srand(1);
+    size_t bytes = 0;
+    for (int i = 0; i < 20000; ++i) {
+        uint8_t x = rand() % 140, y = rand() % 72;
+        bool value = rand() & 1;
+        switch (rand() % 5) {
+            case 0: ssd1306_pixel(&ssd, x, y, value); break;
+            case 1: ssd1306_hline(&ssd, x, x + rand() % 40, y, value); break;
+            case 2: ssd1306_vline(&ssd, x, y, y + rand() % 40, value); break;
+            case 3: ssd1306_rect(&ssd, y, x, 1 + rand() % 30, 1 + rand() % 20, value, rand() & 1); break;
+            default: ssd1306_draw_string(&ssd, "ABC 123", x, y); break;
+        }
+        if (rand() % 8 == 0) {
+            bytes += flush_bytes();
+            if (!CHECK(panel_matches())) {
+                return;
+            }
+        }
+    }
+    bytes += flush_bytes();
+    CHECK(panel_matches());
+    printf("\ndesenho aleatorio: painel igual ao framebuffer apos cada flush (%zu bytes)\n", bytes);
+}
+
+static void flush_done(void *user_data) {
+    *(bool *)user_data = true;
+}
+
+// O envio assíncrono entrega o mesmo conteúdo, e o callback sai uma vez por quadro
+static void async_flush(const signal_plan_t *plan) {
+    display_frame_cache_init(&ssd, plan);
+    for (uint8_t step = 0; step < plan->step_count; ++step) {
+        bool done = false;
+        display_show_state(&ssd, false, step);
+        CHECK(ssd1306_flush_async(&ssd, flush_done, &done));
+        test_run_for_us(100000);
+        CHECK(done);
+        CHECK(!ssd1306_busy(&ssd));
+        CHECK(panel_matches());
+    }
+}
+
+int main(void) {
+    display_init(&ssd);
+    CHECK(panel_matches());
+
+    screens_of_plan(&signal_plan_pedestrian);
+    screens_of_plan(&signal_plan_nema8);
+    random_drawing();
+    async_flush(&signal_plan_pedestrian);
+    return test_finish("test_display");
+}
@@ -0,0 +1,634 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
+#include "hardware/pwm.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/sync.h"
+#include "hardware/clocks.h"
+#include "sim_hal.h"
+#include "test_hal.h"
+
+/*
+ * Uma thread só e nenhum escalonador: "interrupções" são os eventos que
+ * test_run_until_us dispara na ordem do prazo (empates pela ordem de criação),
+ * então desabilitar interrupções e seções críticas não precisam fazer nada.
+ */
+
+#define TEST_ALARM_MAX        32
+#define TEST_IRQ_HANDLERS_MAX 4
+#define TEST_PIO_SMS          8 // pio0 e pio1, 4 máquinas cada
+
+pio_hw_t sim_pio0_hw, sim_pio1_hw;
+
+static uint64_t now_us;
+static uint irq_depth;
+static int failures;
+
+// ------------------------------------------------------------------ tempo
+
+uint64_t time_us_64(void) {
+    return now_us;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)now_us;
+}
+
+uint32_t sim_host_time_us_32(void) {
+    return (uint32_t)(test_host_ns() / 1000u);
+}
+
+uint64_t test_host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(now_us / 1000u);
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+void sleep_us(uint64_t us) {
+    test_run_for_us(us);
+}
+
+// A CPU presa no laço: o relógio anda sem disparar eventos, que saem
+// atrasados depois que quem esperou retornar
+void busy_wait_us(uint64_t delay_us) {
+    now_us += delay_us;
+}
+
+void sleep_ms(uint32_t ms) {
+    test_run_for_us((uint64_t)ms * 1000u);
+}
+
+// ------------------------------------------------------------------ interrupções
+
+uint __get_current_exception(void) {
+    return irq_depth ? 16 : 0;
+}
+
+void sim_irq_enter(void) {
+    irq_depth++;
+}
+
+void sim_irq_exit(void) {
+    irq_depth--;
+}
+
+uint32_t save_and_disable_interrupts(void) { return 0; }
+void restore_interrupts(uint32_t status) { (void)status; }
+
+void critical_section_init(critical_section_t *crit_sec) { (void)crit_sec; }
+void critical_section_deinit(critical_section_t *crit_sec) { (void)crit_sec; }
+void critical_section_enter_blocking(critical_section_t *crit_sec) { (void)crit_sec; }
+void critical_section_exit(critical_section_t *crit_sec) { (void)crit_sec; }
+
+static struct {
+    irq_handler_t handlers[TEST_IRQ_HANDLERS_MAX];
+    uint count;
+    bool enabled;
+} irqs[NUM_IRQS];
+
+void irq_set_enabled(uint num, bool enabled) { irqs[num].enabled = enabled; }
+void irq_set_priority(uint num, uint8_t hardware_priority) { (void)num; (void)hardware_priority; }
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    irqs[num].handlers[0] = handler;
+    irqs[num].count = 1;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+    (void)order_priority;
+    if (irqs[num].count == TEST_IRQ_HANDLERS_MAX) {
+        panic("irq %u: handlers demais", num);
+    }
+    irqs[num].handlers[irqs[num].count++] = handler;
+}
+
+void sim_irq_dispatch(uint num) {
+    if (!irqs[num].enabled) {
+        return;
+    }
+    sim_irq_enter();
+    for (uint i = 0; i < irqs[num].count; ++i) {
+        irqs[num].handlers[i]();
+    }
+    sim_irq_exit();
+}
+
+// ------------------------------------------------------------------ alarmes
+
+static struct {
+    alarm_callback_t callback;
+    void *user_data;
+    uint64_t target_us;
+    uint64_t fire_us;   // prazo + latência sorteada (test_set_alarm_latency_us)
+    uint64_t order;     // desempate entre alarmes com o mesmo prazo
+    bool used;
+} alarms[TEST_ALARM_MAX];
+
+static uint64_t event_order;
+static uint32_t alarm_latency_max_us;
+static uint32_t latency_seed = 1;
+
+void test_set_alarm_latency_us(uint32_t max_us) {
+    alarm_latency_max_us = max_us;
+}
+
+// Atraso de 0..alarm_latency_max_us para o próximo disparo (xorshift, repetível)
+static uint64_t alarm_latency(void) {
+    if (alarm_latency_max_us == 0) {
+        return 0;
+    }
+    latency_seed ^= latency_seed << 13;
+    latency_seed ^= latency_seed >> 17;
+    latency_seed ^= latency_seed << 5;
+    return latency_seed % (alarm_latency_max_us + 1u);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)fire_if_past;
+    for (int slot = 0; slot < TEST_ALARM_MAX; ++slot) {
+        if (!alarms[slot].used) {
+            alarms[slot].used = true;
+            alarms[slot].callback = callback;
+            alarms[slot].user_data = user_data;
+            alarms[slot].target_us = now_us + us;
+            alarms[slot].fire_us = alarms[slot].target_us + alarm_latency();
+            alarms[slot].order = event_order++;
+            return slot + 1;
+        }
+    }
+    return -1;
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us((uint64_t)ms * 1000u, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    int slot = alarm_id - 1;
+    if (slot < 0 || slot >= TEST_ALARM_MAX || !alarms[slot].used) {
+        return false;
+    }
+    alarms[slot].used = false;
+    return true;
+}
+
+static void alarm_fire(int slot) {
+    sim_irq_enter();
+    int64_t ret = alarms[slot].callback(slot + 1, alarms[slot].user_data);
+    sim_irq_exit();
+
+    if (ret < 0) {
+        alarms[slot].target_us += (uint64_t)-ret; // relativo ao prazo anterior
+    } else if (ret > 0) {
+        alarms[slot].target_us = now_us + (uint64_t)ret;
+    } else {
+        alarms[slot].used = false;
+        return;
+    }
+    alarms[slot].fire_us = alarms[slot].target_us + alarm_latency();
+    alarms[slot].order = event_order++;
+}
+
+// ------------------------------------------------------------------ PIO
+
+// Palavras escritas no FIFO TX e ainda não retiradas pelo OSR, com o instante da retirada
+static struct {
+    uint64_t pull_us[TEST_PIO_FIFO_DEPTH + 1];
+    uint count;
+    uint64_t osr_free_us;   // fim dos bits da palavra em deslocamento
+} pio_sms[TEST_PIO_SMS];
+
+static test_pio_word_t pio_log[TEST_PIO_LOG_MAX];
+static size_t pio_log_count;
+
+static uint pio_sm_index(PIO pio, uint sm) {
+    return (pio == pio1 ? 4u : 0u) + sm;
+}
+
+// Descarta do FIFO as palavras que o OSR já retirou até agora
+static uint pio_fifo_level(uint index) {
+    while (pio_sms[index].count > 0 && pio_sms[index].pull_us[0] <= now_us) {
+        memmove(&pio_sms[index].pull_us[0], &pio_sms[index].pull_us[1],
+                --pio_sms[index].count * sizeof(uint64_t));
+    }
+    return pio_sms[index].count;
+}
+
+// Palavra entra no FIFO agora: sai na linha quando o OSR terminar a anterior
+static void pio_push(uint index, uint32_t word) {
+    uint64_t pull = pio_sms[index].osr_free_us > now_us ? pio_sms[index].osr_free_us : now_us;
+    pio_sms[index].osr_free_us = pull + TEST_PIO_WORD_US;
+    if (pio_fifo_level(index) >= TEST_PIO_FIFO_DEPTH) {
+        panic("pio sm %u: FIFO TX estourou", index);
+    }
+    pio_sms[index].pull_us[pio_sms[index].count++] = pull;
+    if (pio_log_count < TEST_PIO_LOG_MAX) {
+        pio_log[pio_log_count++] = (test_pio_word_t){ .start_us = pull, .word = word, .sm = index };
+    }
+}
+
+// Instante em que o FIFO terá lugar para mais uma palavra
+static uint64_t pio_fifo_room_us(uint index) {
+    if (pio_fifo_level(index) < TEST_PIO_FIFO_DEPTH) {
+        return now_us;
+    }
+    return pio_sms[index].pull_us[0]; // cheio: abre lugar quando o OSR retirar a da frente
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio; (void)program;
+    return 0;
+}
+
+// Máquinas entregues em ordem, 4 por PIO
+int pio_claim_unused_sm(PIO pio, bool required) {
+    static uint claimed[2];
+    uint *next = &claimed[pio == pio1 ? 1 : 0];
+    if (*next == 4) {
+        if (required) {
+            panic("pio: sem SM livre");
+        }
+        return -1;
+    }
+    return (int)(*next)++;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    (void)is_tx;
+    return (pio == pio1 ? 8u : 0u) + sm;
+}
+
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm) {
+    return pio_fifo_level(pio_sm_index(pio, sm));
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+    uint index = pio_sm_index(pio, sm);
+    test_run_until_us(pio_fifo_room_us(index));
+    pio->txf[sm] = data;
+    pio_push(index, data);
+}
+
+const test_pio_word_t *test_pio_log(size_t *count) {
+    *count = pio_log_count;
+    return pio_log;
+}
+
+void test_pio_log_clear(void) {
+    pio_log_count = 0;
+}
+
+// ------------------------------------------------------------------ DMA
+
+static struct {
+    bool claimed;
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint count;
+    uint done;          // transferências feitas na rodada atual
+    uint64_t next_us;   // prazo da próxima transferência
+    uint64_t order;
+    bool busy;
+    bool irq_enabled[2];
+    bool irq_status[2];
+} dma[NUM_DMA_CHANNELS];
+
+// Canal que escreve num FIFO TX de PIO: índice da máquina, ou -1
+static int dma_pio_target(uint channel) {
+    for (uint sm = 0; sm < 4; ++sm) {
+        if (dma[channel].write_addr == &sim_pio0_hw.txf[sm]) {
+            return (int)pio_sm_index(pio0, sm);
+        }
+        if (dma[channel].write_addr == &sim_pio1_hw.txf[sm]) {
+            return (int)pio_sm_index(pio1, sm);
+        }
+    }
+    return -1;
+}
+
+static void dma_finish(uint channel) {
+    dma[channel].busy = false;
+    for (int n = 0; n < 2; ++n) {
+        if (dma[channel].irq_enabled[n]) {
+            dma[channel].irq_status[n] = true;
+            sim_irq_dispatch(n ? DMA_IRQ_1 : DMA_IRQ_0);
+        }
+    }
+}
+
+// Uma transferência: para o PIO, uma palavra por vez no ritmo do DREQ; sem
+// modelo do destino, o bloco inteiro de uma vez
+static void dma_step(uint channel) {
+    int sm = dma_pio_target(channel);
+    if (sm < 0) {
+        dma[channel].done = dma[channel].count;
+        dma_finish(channel);
+        return;
+    }
+    const volatile uint32_t *words = dma[channel].read_addr;
+    uint32_t word = words[dma[channel].read_addr != NULL && dma[channel].config.read_increment ? dma[channel].done : 0];
+    pio_push((uint)sm, word);
+    if (++dma[channel].done == dma[channel].count) {
+        dma_finish(channel);
+        return;
+    }
+    dma[channel].next_us = pio_fifo_room_us((uint)sm);
+    dma[channel].order = event_order++;
+}
+
+static void dma_start(uint channel) {
+    if (dma[channel].busy) {
+        panic("dma %u: disparado em andamento", channel);
+    }
+    dma[channel].busy = dma[channel].count > 0;
+    dma[channel].done = 0;
+    dma[channel].next_us = now_us;
+    dma[channel].order = event_order++;
+    if (dma[channel].busy) {
+        int sm = dma_pio_target(channel);
+        if (sm >= 0) {
+            dma[channel].next_us = pio_fifo_room_us((uint)sm);
+        }
+    }
+}
+
+int dma_claim_unused_channel(bool required) {
+    for (int ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (!dma[ch].claimed) {
+            dma[ch].claimed = true;
+            return ch;
+        }
+    }
+    if (required) {
+        panic("sem canais DMA livres");
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    dma_channel_config c = { .size = DMA_SIZE_32, .read_increment = true, .write_increment = false, .dreq = 0x3f };
+    return c;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    dma[channel].config = *config;
+    dma[channel].write_addr = write_addr;
+    dma[channel].read_addr = read_addr;
+    dma[channel].count = transfer_count;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    dma[channel].read_addr = read_addr;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+bool dma_channel_is_busy(uint channel) { return dma[channel].busy; }
+void dma_channel_abort(uint channel) { dma[channel].busy = false; }
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) { dma[channel].irq_enabled[0] = enabled; }
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) { dma[channel].irq_enabled[1] = enabled; }
+bool dma_channel_get_irq0_status(uint channel) { return dma[channel].irq_status[0]; }
+bool dma_channel_get_irq1_status(uint channel) { return dma[channel].irq_status[1]; }
+void dma_channel_acknowledge_irq0(uint channel) { dma[channel].irq_status[0] = false; }
+void dma_channel_acknowledge_irq1(uint channel) { dma[channel].irq_status[1] = false; }
+
+// ------------------------------------------------------------------ eventos
+
+typedef enum { EVENT_NONE, EVENT_ALARM, EVENT_DMA } event_kind_t;
+
+static event_kind_t next_event(uint *index, uint64_t *time_us) {
+    event_kind_t kind = EVENT_NONE;
+    uint64_t best_order = 0;
+    for (uint slot = 0; slot < TEST_ALARM_MAX; ++slot) {
+        if (alarms[slot].used && (kind == EVENT_NONE || alarms[slot].fire_us < *time_us ||
+                                  (alarms[slot].fire_us == *time_us && alarms[slot].order < best_order))) {
+            kind = EVENT_ALARM;
+            *index = slot;
+            *time_us = alarms[slot].fire_us;
+            best_order = alarms[slot].order;
+        }
+    }
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ++ch) {
+        if (dma[ch].busy && (kind == EVENT_NONE || dma[ch].next_us < *time_us ||
+                             (dma[ch].next_us == *time_us && dma[ch].order < best_order))) {
+            kind = EVENT_DMA;
+            *index = ch;
+            *time_us = dma[ch].next_us;
+            best_order = dma[ch].order;
+        }
+    }
+    return kind;
+}
+
+bool test_events_pending(void) {
+    uint index;
+    uint64_t time_us;
+    return next_event(&index, &time_us) != EVENT_NONE;
+}
+
+void test_run_until_us(uint64_t time_us) {
+    uint index;
+    uint64_t event_us;
+    event_kind_t kind;
+    while ((kind = next_event(&index, &event_us)) != EVENT_NONE && event_us <= time_us) {
+        if (event_us > now_us) {
+            now_us = event_us;
+        }
+        if (kind == EVENT_ALARM) {
+            alarm_fire((int)index);
+        } else {
+            dma_step(index);
+        }
+    }
+    if (time_us > now_us) {
+        now_us = time_us;
+    }
+}
+
+void test_run_for_us(uint64_t us) {
+    test_run_until_us(now_us + us);
+}
+
+// ------------------------------------------------------------------ GPIO
+
+static struct {
+    bool out;
+    bool level;
+    enum gpio_function function;
+    uint32_t irq_events;
+} pins[NUM_BANK0_GPIOS];
+
+static gpio_irq_callback_t gpio_callback;
+
+void gpio_init(uint gpio) {
+    pins[gpio].out = false;
+    pins[gpio].level = false;
+    pins[gpio].function = GPIO_FUNC_SIO;
+}
+
+void gpio_set_dir(uint gpio, bool out) { pins[gpio].out = out; }
+void gpio_set_function(uint gpio, enum gpio_function fn) { pins[gpio].function = fn; }
+void gpio_pull_down(uint gpio) { if (!pins[gpio].out) pins[gpio].level = false; }
+void gpio_pull_up(uint gpio) { if (!pins[gpio].out) pins[gpio].level = true; }
+bool gpio_get(uint gpio) { return pins[gpio].level; }
+void gpio_put(uint gpio, bool value) { pins[gpio].level = value; }
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (enabled) {
+        pins[gpio].irq_events |= event_mask;
+    } else {
+        pins[gpio].irq_events &= ~event_mask;
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    gpio_callback = callback;
+}
+
+void sim_gpio_drive(uint gpio, bool level) {
+    if (pins[gpio].level == level) {
+        return;
+    }
+    pins[gpio].level = level;
+    sim_pio_debounce_pin(gpio, level);
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (gpio_callback && (pins[gpio].irq_events & event)) {
+        sim_irq_enter();
+        gpio_callback(gpio, event);
+        sim_irq_exit();
+    }
+}
+
+// ------------------------------------------------------------------ PWM
+
+static struct {
+    uint8_t div_int, div_frac;
+    uint16_t wrap;
+    uint16_t level[2];
+    bool enabled;
+} slices[NUM_PWM_SLICES];
+
+static double pin_pwm_hz[NUM_BANK0_GPIOS];
+static test_pwm_change_t pwm_log[TEST_PWM_LOG_MAX];
+static size_t pwm_log_count;
+
+static double pwm_pin_hz(uint gpio) {
+    uint slice_num = pwm_gpio_to_slice_num(gpio);
+    uint16_t level = slices[slice_num].level[pwm_gpio_to_channel(gpio)];
+    if (pins[gpio].function != GPIO_FUNC_PWM || !slices[slice_num].enabled || level == 0) {
+        return 0.0;
+    }
+    double div = slices[slice_num].div_int + slices[slice_num].div_frac / 16.0;
+    return (double)SYS_CLK_KHZ * 1000.0 / (div * (slices[slice_num].wrap + 1.0));
+}
+
+// Grava no log cada mudança da frequência audível de um pino
+static void pwm_update_outputs(uint slice_num) {
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; ++gpio) {
+        if (pwm_gpio_to_slice_num(gpio) != slice_num) {
+            continue;
+        }
+        double hz = pwm_pin_hz(gpio);
+        if (hz != pin_pwm_hz[gpio]) {
+            pin_pwm_hz[gpio] = hz;
+            if (pwm_log_count < TEST_PWM_LOG_MAX) {
+                pwm_log[pwm_log_count++] = (test_pwm_change_t){ .time_us = now_us, .gpio = gpio, .hz = hz };
+            }
+        }
+    }
+}
+
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract) {
+    slices[slice_num].div_int = integer;
+    slices[slice_num].div_frac = fract;
+    pwm_update_outputs(slice_num);
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    slices[slice_num].wrap = wrap;
+    pwm_update_outputs(slice_num);
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level) {
+    slices[slice_num].level[chan] = level;
+    pwm_update_outputs(slice_num);
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    slices[slice_num].enabled = enabled;
+    pwm_update_outputs(slice_num);
+}
+
+double test_pwm_hz(uint gpio) {
+    return pwm_pin_hz(gpio);
+}
+
+const test_pwm_change_t *test_pwm_log(size_t *count) {
+    *count = pwm_log_count;
+    return pwm_log;
+}
+
+void test_pwm_log_clear(void) {
+    pwm_log_count = 0;
+}
+
+// ------------------------------------------------------------------ sistema
+
+// O log CSV é da simulação; nos testes as saídas são lidas pelas funções test_*
+void sim_record(const char *channel, const char *fmt, ...) {
+    (void)channel; (void)fmt;
+}
+
+void panic(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "test: panic: ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    abort();
+}
+
+bool test_check(bool ok, const char *expr, const char *file, int line) {
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "%s:%d: falhou: %s\n", file, line, expr);
+    }
+    return ok;
+}
+
+int test_finish(const char *name) {
+    if (failures) {
+        printf("%s: %d falhas\n", name, failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
@@ -0,0 +1,71 @@
+#ifndef TEST_HAL_H
+#define TEST_HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+/*
+ * Periféricos do RP2040 para os testes de host (alvo traffic_tests), sem
+ * FreeRTOS: o firmware usa os mesmos cabeçalhos pico/ e hardware/ da
+ * simulação (sim/include), e o tempo é um relógio virtual em microssegundos
+ * que só anda com test_run_until_us/test_run_for_us. Alarmes e palavras de DMA
+ * são eventos disparados na ordem do prazo, marcados como interrupção.
+ *
+ * O PIO da matriz é modelado como o WS2812 na linha: FIFO TX de 4 palavras,
+ * cada palavra sai do OSR em TEST_PIO_WORD_US, e o DMA pausado pelo DREQ só
+ * escreve quando há lugar no FIFO. Cada palavra que começa a sair na linha vai
+ * para um log com o instante, para conferir quadros e o latch.
+ */
+
+#define TEST_PIO_FIFO_DEPTH  4
+#define TEST_PIO_WORD_US     30   // 24 bits a 800 kHz (led_matrix.pio)
+#define TEST_PIO_LOG_MAX     4096
+#define TEST_PWM_LOG_MAX     4096
+
+// ------------------------------------------------------------------ tempo
+
+void test_run_until_us(uint64_t time_us);
+void test_run_for_us(uint64_t us);
+bool test_events_pending(void);
+
+// Cada disparo de alarme passa a atrasar de 0 a max_us em relação ao prazo
+// (latência de interrupção); o prazo em si, base do reagendamento, não muda
+void test_set_alarm_latency_us(uint32_t max_us);
+
+// Relógio do host (ns), para os benchmarks
+uint64_t test_host_ns(void);
+
+// ------------------------------------------------------------------ saídas observadas
+
+typedef struct {
+    uint64_t start_us;  // início dos bits da palavra na linha
+    uint32_t word;
+    uint8_t sm;         // 0..3 = pio0, 4..7 = pio1
+} test_pio_word_t;
+
+const test_pio_word_t *test_pio_log(size_t *count);
+void test_pio_log_clear(void);
+
+typedef struct {
+    uint64_t time_us;
+    uint8_t gpio;
+    double hz;          // 0 = sem som (slice parado ou nível 0)
+} test_pwm_change_t;
+
+const test_pwm_change_t *test_pwm_log(size_t *count);
+void test_pwm_log_clear(void);
+double test_pwm_hz(uint gpio);
+
+// Bytes entregues ao I2C por i2c_write_blocking (contador cumulativo)
+size_t test_i2c_bytes(void);
+
+// ------------------------------------------------------------------ verificações
+
+bool test_check(bool ok, const char *expr, const char *file, int line);
+int test_finish(const char *name);
+
+#define CHECK(cond) test_check((cond), #cond, __FILE__, __LINE__)
+
+#endif // TEST_HAL_H
@@ -0,0 +1,30 @@
+#include "hardware/i2c.h"
+#include "sim_hal.h"
+#include "test_hal.h"
+
+/*
+ * I2C dos testes que usam o display: separado de test_hal.c para que os
+ * testes sem SSD1306 não precisem ligar o modelo do painel nem o driver.
+ */
+
+i2c_inst_t sim_i2c0_inst = { .index = 0 };
+i2c_inst_t sim_i2c1_inst = { .index = 1 };
+
+static size_t i2c_bytes;
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+// Cada chamada é uma transação completa; só o SSD1306 está no barramento
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)i2c; (void)addr; (void)nostop;
+    i2c_bytes += len;
+    sim_ssd1306_transaction(src, len);
+    return (int)len;
+}
+
+size_t test_i2c_bytes(void) {
+    return i2c_bytes;
+}
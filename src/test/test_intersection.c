@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "intersection.h"
+#include "config.h"
+#include "test_hal.h"
+
+/*
+ * Deriva das fronteiras de passo: INSTANCES cruzamentos em tempo fixo rodam
+ * pelo escalonador por pelo menos MIN_CYCLES ciclos cada, com a tarefa
+ * acordando atrasada por um valor sorteado (às vezes vários passos depois do
+ * prazo). Cada fronteira entregue às saídas é comparada com a base da partida
+ * mais a soma das durações da tabela do plano, calculada aqui, à parte. Um
+ * controle que reagendasse a partir da hora de acordar (como um vTaskDelay
+ * relativo) acumularia os atrasos e falharia. O relógio de ticks começa perto
+ * do fim para a contagem dar a volta no meio.
+ */
+
+#define INSTANCES    64
+#define MIN_CYCLES   10000
+#define OFFSET_MS    997    // defasagem entre cruzamentos (não divide o ciclo)
+#define TICK_START   ((TickType_t)0 - 3600000u)
+#define BENCH_INSTANCES 1000
+#define BENCH_CYCLES    200
+
+typedef struct {
+    const signal_plan_t *plan;
+    uint8_t step;           // passo esperado depois da próxima fronteira
+    TickType_t expected;    // próxima fronteira esperada
+    uint32_t boundaries;
+    uint32_t cycles;
+    uint32_t wrong_time;
+    uint32_t wrong_step;
+} expectation_t;
+
+static intersection_t intersections[INSTANCES];
+static intersection_t *heap_storage[INSTANCES];
+static intersection_scheduler_t scheduler;
+static expectation_t expectations[INSTANCES];
+static TickType_t worst_lateness;
+
+static TickType_t ms_to_ticks(uint32_t ms) {
+    return (TickType_t)((uint64_t)ms * configTICK_RATE_HZ / 1000u);
+}
+
+// Saídas de teste: confere cada fronteira contra a soma das durações da tabela
+static void check_boundary(intersection_t *intersection, TickType_t boundary, intersection_event_t event) {
+    expectation_t *e = &expectations[intersection - intersections];
+    if (event == INTERSECTION_EVENT_RESTART) {
+        return; // partida: a primeira fronteira já foi calculada em start_all
+    }
+    e->boundaries++;
+    if (event != INTERSECTION_EVENT_STEP || boundary != e->expected) {
+        e->wrong_time++;
+    }
+    if (intersection_step(intersection) != e->step) {
+        e->wrong_step++;
+    }
+    const signal_step_t *step = &e->plan->steps[e->step];
+    if (step->cycle_start) {
+        e->cycles++;
+    }
+    e->expected += ms_to_ticks(step->duration_ms);
+    e->step = step->next;
+}
+
+static void start_all(const signal_plan_t *plan, TickType_t now) {
+    intersection_scheduler_init(&scheduler, heap_storage, INSTANCES);
+    for (int i = 0; i < INSTANCES; ++i) {
+        intersection_init(&intersections[i], plan, NULL, check_boundary);
+        intersection_set_mode(&scheduler, &intersections[i], false, false, now);
+        uint8_t first = plan->start_step;
+        expectations[i] = (expectation_t){
+            .plan = plan,
+            .step = plan->steps[first].next,
+            .expected = now + ms_to_ticks(i * OFFSET_MS + plan->steps[first].duration_ms),
+        };
+        intersection_start(&scheduler, &intersections[i], now, i * OFFSET_MS);
+    }
+}
+
+// Atraso da tarefa ao acordar: quase sempre pequeno, às vezes vários passos
+static TickType_t wake_lateness(void) {
+    int draw = rand() % 100;
+    if (draw < 70) {
+        return rand() % 3;
+    }
+    if (draw < 95) {
+        return rand() % 50;
+    }
+    return rand() % 8000;
+}
+
+static bool all_done(void) {
+    for (int i = 0; i < INSTANCES; ++i) {
+        if (expectations[i].cycles < MIN_CYCLES) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void run_plan(const signal_plan_t *plan) {
+    srand(17);
+    TickType_t now = TICK_START;
+    start_all(plan, now);
+
+    uint64_t wakes = 0;
+    while (!all_done()) {
+        TickType_t deadline;
+        if (!CHECK(intersection_scheduler_next(&scheduler, &deadline))) {
+            return;
+        }
+        TickType_t late = wake_lateness();
+        now = deadline + late;
+        worst_lateness = late > worst_lateness ? late : worst_lateness;
+        intersection_scheduler_run(&scheduler, now);
+        wakes++;
+    }
+
+    uint64_t boundaries = 0, wrong_time = 0, wrong_step = 0;
+    uint32_t min_cycles = UINT32_MAX;
+    for (int i = 0; i < INSTANCES; ++i) {
+        boundaries += expectations[i].boundaries;
+        wrong_time += expectations[i].wrong_time;
+        wrong_step += expectations[i].wrong_step;
+        min_cycles = expectations[i].cycles < min_cycles ? expectations[i].cycles : min_cycles;
+    }
+    CHECK(wrong_time == 0);
+    CHECK(wrong_step == 0);
+    CHECK(now < TICK_START); // a contagem de ticks deu a volta
+    printf("plano \"%s\": %d cruzamentos, >= %lu ciclos cada, %llu fronteiras em %llu acordadas\n",
+           plan->name, INSTANCES, (unsigned long)min_cycles, (unsigned long long)boundaries,
+           (unsigned long long)wakes);
+    printf("  atraso ao acordar ate %lu ticks; fronteiras fora de base + soma das duracoes: %llu, passo errado: %llu\n",
+           (unsigned long)worst_lateness, (unsigned long long)wrong_time, (unsigned long long)wrong_step);
+}
+
+/*
+ * Custo do escalonador com BENCH_INSTANCES cruzamentos sem saídas (como os
+ * além do primeiro no firmware), acordando no prazo: tempo de host por
+ * fronteira e por passada, com os cruzamentos defasados de offset_ms ou
+ * todos na mesma fronteira (offset_ms = 0, uma passada vence os BENCH_INSTANCES).
+ */
+static intersection_t bench_intersections[BENCH_INSTANCES];
+static intersection_t *bench_heap[BENCH_INSTANCES];
+
+static void bench_plan(const signal_plan_t *plan, uint32_t offset_ms) {
+    intersection_scheduler_t bench;
+    TickType_t now = 0;
+    intersection_scheduler_init(&bench, bench_heap, BENCH_INSTANCES);
+    for (int i = 0; i < BENCH_INSTANCES; ++i) {
+        intersection_init(&bench_intersections[i], plan, NULL, NULL);
+        intersection_set_mode(&bench, &bench_intersections[i], false, false, now);
+        intersection_start(&bench, &bench_intersections[i], now, i * offset_ms);
+    }
+    TickType_t end = ms_to_ticks(BENCH_INSTANCES * offset_ms + BENCH_CYCLES * signal_plan_cycle_ms(plan));
+    uint32_t wakes = 0;
+    uint64_t start_ns = test_host_ns();
+    TickType_t deadline;
+    while (intersection_scheduler_next(&bench, &deadline) && (int32_t)(deadline - end) < 0) {
+        now = deadline;
+        intersection_scheduler_run(&bench, now);
+        wakes++;
+    }
+    double total_ns = (double)(test_host_ns() - start_ns);
+    CHECK(bench.transitions > (uint32_t)BENCH_INSTANCES * BENCH_CYCLES);
+    printf("plano \"%s\", %d cruzamentos %s: %lu fronteiras em %lu passadas (ate %u por passada);\n"
+           "  no host, %.0f ns por fronteira, %.1f us por passada\n",
+           plan->name, BENCH_INSTANCES, offset_ms ? "defasados" : "sem defasagem",
+           (unsigned long)bench.transitions, (unsigned long)wakes, (unsigned)bench.run_max_transitions,
+           total_ns / bench.transitions, total_ns / wakes / 1000.0);
+}
+
+int main(void) {
+    run_plan(&signal_plan_pedestrian);
+    run_plan(&signal_plan_nema8);
+    printf("RAM por cruzamento (host): %zu bytes (intersection_t) + %zu (lugar no heap)\n",
+           sizeof(intersection_t), sizeof(intersection_t *));
+    bench_plan(&signal_plan_pedestrian, OFFSET_MS);
+    bench_plan(&signal_plan_nema8, OFFSET_MS);
+    bench_plan(&signal_plan_pedestrian, 0);
+    bench_plan(&signal_plan_nema8, 0);
+    return test_finish("test_intersection");
+}
@@ -0,0 +1,344 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "led_matrix.h"
+#include "config.h"
+#include "test_hal.h"
+
+/*
+ * Matriz WS2812 por DMA: o modelo do PIO registra cada palavra que sai na
+ * linha. Confere o conteúdo de cada quadro (sprite, cor e lâmpada de chamada
+ * nas posições físicas da serpentina), as palavras coladas dentro do quadro,
+ * o latch de pelo menos MATRIX_LATCH_US em nível baixo depois do último bit e
+ * o quadro pendente, que só sai depois do latch do anterior, inclusive sem
+ * alarme livre para o latch (espera ocupada na interrupção). Também compara a
+ * paleta inteira (COLOR_LEVEL) com o antigo cálculo em float, bit a bit, e o
+ * custo das duas formas de montar as cores de um quadro.
+ */
+
+#define BENCH_FRAMES 200000
+
+// Palavras GRB dos ícones (cor 0.25 x brilho 0.25 x 255 = 15), conferidas
+// contra COLOR_LEVEL e o cálculo em float em palette()
+#define WORD_BLACK 0x00000000u
+#define WORD_GREEN 0x0F000000u
+#define WORD_RED   0x000F0000u
+#define WORD_AMBER 0x070F0000u  // lâmpada de chamada: R 15, G 7
+
+// Posição física de cada led da BitDogLab, linha 1 em cima
+static const uint8_t led_at[MATRIX_DIM][MATRIX_DIM] = {
+    { 24, 23, 22, 21, 20 },
+    { 15, 16, 17, 18, 19 },
+    { 14, 13, 12, 11, 10 },
+    {  5,  6,  7,  8,  9 },
+    {  4,  3,  2,  1,  0 },
+};
+
+typedef struct { uint8_t lin, col; } cell_t;
+
+static const cell_t walk_cells[] = {
+    {1, 3}, {1, 5}, {2, 2}, {2, 3}, {2, 4}, {3, 1}, {3, 3}, {4, 3}, {5, 2}, {5, 4},
+};
+static const cell_t stop_cells[] = {
+    {1, 3}, {2, 2}, {2, 3}, {2, 4}, {3, 3}, {4, 3}, {5, 2}, {5, 4},
+};
+static const cell_t lamp_cells[] = { {5, 1}, {5, 5} };
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+static void paint(uint32_t *frame, const cell_t *cells, size_t count, uint32_t word) {
+    for (size_t i = 0; i < count; ++i) {
+        frame[led_at[cells[i].lin - 1][cells[i].col - 1]] = word;
+    }
+}
+
+// Quadro esperado: sprite na cor dada, mais a lâmpada de chamada se acesa
+static void expected_frame(uint32_t *frame, const cell_t *cells, size_t count, uint32_t word, bool lamp) {
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        frame[i] = WORD_BLACK;
+    }
+    if (lamp) {
+        paint(frame, lamp_cells, COUNT(lamp_cells), WORD_AMBER);
+    }
+    paint(frame, cells, count, word);
+}
+
+// ------------------------------------------------------------------ linha
+
+typedef struct {
+    const test_pio_word_t *words;
+    size_t count;
+} frame_log_t;
+
+// Divide o log em quadros: palavras coladas (a cada TEST_PIO_WORD_US) são do mesmo quadro
+static size_t split_frames(frame_log_t *frames, size_t max) {
+    size_t count, n = 0;
+    const test_pio_word_t *log = test_pio_log(&count);
+    for (size_t i = 0; i < count && n < max; ++i) {
+        if (i == 0 || log[i].start_us != log[i - 1].start_us + TEST_PIO_WORD_US) {
+            frames[n++] = (frame_log_t){ .words = &log[i], .count = 0 };
+        }
+        frames[n - 1].count++;
+    }
+    return n;
+}
+
+static bool frame_is(const frame_log_t *frame, const uint32_t *expected) {
+    if (frame->count != MATRIX_SIZE) {
+        return false;
+    }
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        if (frame->words[i].word != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint64_t frame_end_us(const frame_log_t *frame) {
+    return frame->words[frame->count - 1].start_us + TEST_PIO_WORD_US;
+}
+
+// Anda o relógio de 1 em 1 us até a matriz ficar livre (no máximo 1 s); devolve o instante
+static uint64_t run_until_free(void) {
+    uint64_t give_up = time_us_64() + 1000000u;
+    while (led_matrix_busy() && time_us_64() < give_up) {
+        test_run_for_us(1);
+    }
+    CHECK(!led_matrix_busy());
+    return time_us_64();
+}
+
+// ------------------------------------------------------------------ casos
+
+// Um quadro isolado: começa na hora, 25 palavras coladas e o latch completo
+static void single_frame(void (*draw)(void), const cell_t *cells, size_t count, uint32_t word,
+                         bool lamp, const char *label) {
+    uint32_t expected[MATRIX_SIZE];
+    expected_frame(expected, cells, count, word, lamp);
+
+    test_pio_log_clear();
+    uint64_t start = time_us_64();
+    draw();
+    CHECK(led_matrix_busy());
+    uint64_t free_at = run_until_free();
+
+    frame_log_t frames[4];
+    size_t n = split_frames(frames, 4);
+    CHECK(n == 1);
+    CHECK(frame_is(&frames[0], expected));
+    CHECK(frames[0].words[0].start_us == start);
+    uint64_t latch = free_at - frame_end_us(&frames[0]);
+    CHECK(latch >= MATRIX_LATCH_US);
+    CHECK(latch < MATRIX_LATCH_US + TEST_PIO_WORD_US);
+    printf("%-24s 25 palavras em %llu us, linha baixa por %llu us antes de liberar\n", label,
+           (unsigned long long)(frame_end_us(&frames[0]) - start), (unsigned long long)latch);
+}
+
+static void draw_walk(void) { led_matrix_ped_walk(); }
+static void draw_stop(void) { led_matrix_ped_dont_walk(true); }
+static void draw_stop_dark(void) { led_matrix_ped_dont_walk(false); }
+static void draw_clear(void) { led_matrix_clear(); }
+
+// O mesmo sprite de novo não gera quadro
+static void repeated_frame(void) {
+    test_pio_log_clear();
+    led_matrix_ped_walk();
+    led_matrix_ped_walk();
+    CHECK(led_matrix_busy());
+    run_until_free();
+    led_matrix_ped_walk();
+    CHECK(!led_matrix_busy());
+    test_run_for_us(1000);
+    size_t count;
+    test_pio_log(&count);
+    CHECK(count == MATRIX_SIZE);
+}
+
+// Quadros pedidos durante o envio: só o último sai, e só depois do latch
+static void pending_frame(void) {
+    uint32_t stop[MATRIX_SIZE], black[MATRIX_SIZE];
+    expected_frame(stop, stop_cells, COUNT(stop_cells), WORD_RED, false);
+    expected_frame(black, NULL, 0, WORD_BLACK, false);
+
+    test_pio_log_clear();
+    led_matrix_ped_dont_walk(true);          // a matriz mostrava o pedestre andando
+    test_run_for_us(100);
+    led_matrix_ped_walk();                   // fica pendente
+    test_run_for_us(500);                    // no meio do quadro ou do latch
+    led_matrix_clear();                      // substitui o pendente
+    CHECK(led_matrix_busy());
+    uint64_t free_at = run_until_free();
+
+    frame_log_t frames[4];
+    size_t n = split_frames(frames, 4);
+    CHECK(n == 2);
+    if (n != 2) {
+        return;
+    }
+    CHECK(frame_is(&frames[0], stop));
+    CHECK(frame_is(&frames[1], black));
+    uint64_t gap = frames[1].words[0].start_us - frame_end_us(&frames[0]);
+    CHECK(gap >= MATRIX_LATCH_US);
+    CHECK(free_at - frame_end_us(&frames[1]) >= MATRIX_LATCH_US);
+    printf("quadro pendente          sai %llu us depois do ultimo bit do anterior\n",
+           (unsigned long long)gap);
+}
+
+// Sem alarme livre para o latch: os quadros continuam saindo, com o latch completo
+static int64_t never_fires(alarm_id_t id, void *user_data) {
+    return 0;
+}
+
+static void no_free_alarm(void) {
+    alarm_id_t fillers[64];
+    size_t filled = 0;
+    while (filled < COUNT(fillers)) {
+        alarm_id_t id = add_alarm_in_us(3600000000ull, never_fires, NULL, true);
+        if (id < 0) {
+            break;
+        }
+        fillers[filled++] = id;
+    }
+    CHECK(filled < COUNT(fillers));
+
+    uint32_t walk[MATRIX_SIZE], stop[MATRIX_SIZE];
+    expected_frame(walk, walk_cells, COUNT(walk_cells), WORD_GREEN, false);
+    expected_frame(stop, stop_cells, COUNT(stop_cells), WORD_RED, false);
+    test_pio_log_clear();
+    led_matrix_ped_walk();
+    test_run_for_us(100);
+    led_matrix_ped_dont_walk(true);          // pendente: sai do latch feito na interrupção
+    uint64_t free_at = run_until_free();
+
+    frame_log_t frames[4];
+    size_t n = split_frames(frames, 4);
+    CHECK(n == 2);
+    if (n == 2) {
+        CHECK(frame_is(&frames[0], walk));
+        CHECK(frame_is(&frames[1], stop));
+        uint64_t gap = frames[1].words[0].start_us - frame_end_us(&frames[0]);
+        CHECK(gap >= MATRIX_LATCH_US);
+        CHECK(free_at - frame_end_us(&frames[1]) >= MATRIX_LATCH_US);
+        printf("sem alarme livre         pendente sai %llu us depois do ultimo bit; matriz livre de novo\n",
+               (unsigned long long)gap);
+    }
+    for (size_t i = 0; i < filled; ++i) {
+        cancel_alarm(fillers[i]);
+    }
+    led_matrix_clear();                      // e volta a usar o alarme
+    run_until_free();
+}
+
+// ------------------------------------------------------------------ paleta
+
+typedef struct {
+    float r;
+    float g;
+    float b;
+} ws2812b_color_t;
+
+// Conversão usada antes da paleta pré-calculada (float, com saturação)
+static uint32_t color_to_pio_format(ws2812b_color_t color, float brightness) {
+    float r = fmaxf(0.0f, fminf(1.0f, color.r * brightness));
+    float g = fmaxf(0.0f, fminf(1.0f, color.g * brightness));
+    float b = fmaxf(0.0f, fminf(1.0f, color.b * brightness));
+    unsigned char R_val = (unsigned char)(r * 255.0f);
+    unsigned char G_val = (unsigned char)(g * 255.0f);
+    unsigned char B_val = (unsigned char)(b * 255.0f);
+    return ((uint32_t)(G_val) << 24) | ((uint32_t)(R_val) << 16) | ((uint32_t)(B_val) << 8);
+}
+
+// COLOR_LEVEL em todos os pares Q8 de cor e brilho (0..1.0), contra o float
+static void palette(void) {
+    int mismatches = 0;
+    for (uint32_t color = 0; color <= 256; ++color) {
+        for (uint32_t brightness = 0; brightness <= 256; ++brightness) {
+            ws2812b_color_t c = { color / 256.0f, 0.0f, 0.0f };
+            uint32_t expected = color_to_pio_format(c, brightness / 256.0f);
+            if (PIO_GRB(COLOR_LEVEL(color, brightness), 0, 0) != expected) {
+                mismatches++;
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+    printf("COLOR_LEVEL x float: %d de %d pares Q8 diferentes\n", mismatches, 257 * 257);
+
+    const ws2812b_color_t green = { 0.0f, 0.25f, 0.0f }, red = { 0.25f, 0.0f, 0.0f };
+    CHECK(WORD_GREEN == color_to_pio_format(green, 0.25f));
+    CHECK(WORD_RED == color_to_pio_format(red, 0.25f));
+    CHECK(WORD_GREEN == PIO_GRB(0, COLOR_LEVEL(64, 64), 0));
+    CHECK(WORD_AMBER == PIO_GRB(COLOR_LEVEL(64, 64), COLOR_LEVEL(64, 64) / 2, 0));
+}
+
+// Monta o quadro do pedestre andando como antes (duas conversões em float por
+// quadro) e com as palavras da paleta. Os brilhos vêm de variáveis para o
+// compilador não dobrar a conversão
+static volatile float bench_icon = 0.25f, bench_full = 1.0f;
+static uint32_t bench_sprite[MATRIX_SIZE];  // 1 onde o sprite acende
+static uint32_t bench_frame[MATRIX_SIZE];
+
+static void frame_float(void) {
+    const ws2812b_color_t green = { 0.0f, 0.25f, 0.0f }, black = { 0.0f, 0.0f, 0.0f };
+    uint32_t on = color_to_pio_format(green, bench_icon);
+    uint32_t off = color_to_pio_format(black, bench_full);
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        bench_frame[i] = bench_sprite[i] ? on : off;
+    }
+}
+
+static void frame_palette(void) {
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        bench_frame[i] = bench_sprite[i] ? WORD_GREEN : WORD_BLACK;
+    }
+}
+
+static double bench_ns(void (*build)(void)) {
+    uint64_t start = test_host_ns();
+    for (int i = 0; i < BENCH_FRAMES; ++i) {
+        build();
+        __asm__ volatile("" ::: "memory");
+    }
+    return (double)(test_host_ns() - start) / BENCH_FRAMES;
+}
+
+static void palette_cost(void) {
+    uint32_t expected[MATRIX_SIZE];
+    expected_frame(expected, walk_cells, COUNT(walk_cells), WORD_GREEN, false);
+    expected_frame(bench_sprite, walk_cells, COUNT(walk_cells), 1, false);
+    frame_float();
+    CHECK(memcmp(bench_frame, expected, sizeof(expected)) == 0);
+    frame_palette();
+    CHECK(memcmp(bench_frame, expected, sizeof(expected)) == 0);
+    double before = bench_ns(frame_float);
+    double after = bench_ns(frame_palette);
+    printf("montar o quadro do pedestre: %.1f ns (float) -> %.1f ns (paleta) no host\n", before, after);
+}
+
+int main(void) {
+    uint32_t black[MATRIX_SIZE];
+    expected_frame(black, NULL, 0, WORD_BLACK, false);
+
+    // led_matrix_init apaga a matriz
+    led_matrix_init();
+    run_until_free();
+    frame_log_t frames[4];
+    CHECK(split_frames(frames, 4) == 1 && frame_is(&frames[0], black));
+
+    single_frame(draw_walk, walk_cells, COUNT(walk_cells), WORD_GREEN, false, "pedestre anda");
+    single_frame(draw_stop, stop_cells, COUNT(stop_cells), WORD_RED, false, "pedestre pare");
+    single_frame(draw_stop_dark, NULL, 0, WORD_BLACK, false, "pare (pisca apagado)");
+    led_matrix_set_call_lamp(true);
+    single_frame(draw_stop, stop_cells, COUNT(stop_cells), WORD_RED, true, "pare + chamada");
+    single_frame(draw_stop_dark, NULL, 0, WORD_BLACK, true, "pisca apagado + chamada");
+    led_matrix_set_call_lamp(false);
+    single_frame(draw_clear, NULL, 0, WORD_BLACK, false, "apagada");
+
+    repeated_frame();
+    pending_frame();
+    no_free_alarm();
+    palette();
+    palette_cost();
+    return test_finish("test_led_matrix");
+}
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "intersection.h"
+#include "config.h"
+#include "test_hal.h"
+
+/*
+ * Acordadas das tarefas de saída e latência entre a publicação de uma fase e a
+ * saída, no desenho antigo (polling) e no atual (grupo de eventos de estado).
+ *
+ * O controle do firmware (intersection.c e o escalonador) roda uma hora
+ * virtual no plano da placa, em modo normal e com o modo noturno ligado em
+ * NIGHT_AT_MS; cada troca de passo entregue às saídas vira uma publicação,
+ * como em set_signal_step do main.c. As tarefas são modeladas sobre essa
+ * sequência, com a lógica de espera de cada uma:
+ *   - antes: LED RGB, matriz e buzzer acordavam a cada vTaskDelay fixo e só
+ *     viam a troca na primeira volta depois dela; o pisca era conferido nessas
+ *     voltas. O controle, no modo noturno, acordava a cada 100 ms;
+ *   - depois: todas bloqueiam no grupo de eventos e acordam na publicação ou no
+ *     próprio prazo (troca do pisca do LED RGB e da matriz, redesenho de
+ *     segurança do display); o controle dorme até a próxima fronteira.
+ * O display já era acordado por notificação antes, então é o mesmo nos dois.
+ * A latência é medida só nas publicações que mudam a saída de cada tarefa,
+ * em ticks de 1 ms. A fase entre a grade de polling e as fronteiras depende de
+ * quando cada tarefa começou, então o "antes" percorre todas as fases (1 ms
+ * de passo) e a média é sobre todas elas.
+ */
+
+#define RUN_MS          3600000u
+#define NIGHT_AT_MS     1000u       // como SIM_BUTTON_A_MS=1000 no traffic_sim
+#define PUBLISH_MAX     8192
+#define OLD_CONTROL_NIGHT_MS 100u   // vTaskDelay do controle no modo noturno
+#define NO_VALUE        0xFFFFu
+
+typedef enum {
+    OUTPUT_RGB_LED,
+    OUTPUT_MATRIX,
+    OUTPUT_BUZZER,
+    OUTPUT_DISPLAY,
+    OUTPUT_COUNT
+} output_task_t;
+
+// vTaskDelay de cada tarefa antes do grupo de eventos (0 = já acordava por evento)
+static const struct {
+    const char *name;
+    uint32_t poll_ms;
+} outputs[OUTPUT_COUNT] = {
+    [OUTPUT_RGB_LED] = { "LED RGB", 50 },
+    [OUTPUT_MATRIX]  = { "matriz", 100 },
+    [OUTPUT_BUZZER]  = { "buzzer", 50 },
+    [OUTPUT_DISPLAY] = { "display", 0 },
+};
+
+typedef struct {
+    TickType_t tick;
+    uint8_t step;
+} publish_t;
+
+typedef struct {
+    uint64_t wakeups;
+    uint32_t changes;       // mudanças de saída aplicadas (base da média)
+    uint64_t latency_sum_ms;
+    uint32_t latency_max_ms;
+} output_result_t;
+
+static const signal_plan_t *plan = &SIGNAL_PLAN;
+static intersection_t intersection;
+static intersection_t *heap_storage[1];
+static intersection_scheduler_t scheduler;
+static publish_t publishes[PUBLISH_MAX];
+static uint32_t publish_count;
+
+// Como set_signal_step: só publica quando o passo muda
+static void record_output(intersection_t *board, TickType_t boundary, intersection_event_t event) {
+    uint8_t step = board->engine.step;
+    if (publish_count > 0 && publishes[publish_count - 1].step == step) {
+        return;
+    }
+    if (CHECK(publish_count < PUBLISH_MAX)) {
+        publishes[publish_count++] = (publish_t){ .tick = boundary, .step = step };
+    }
+}
+
+/**
+ * @brief Roda o controle por RUN_MS e grava as publicações.
+ * @param old_wakeups Acordadas do controle antigo (fronteiras + polling noturno).
+ * @return Acordadas do controle atual (fronteiras + troca de modo).
+ */
+static uint64_t run_controller(bool night, uint64_t *old_wakeups) {
+    publish_count = 0;
+    intersection_scheduler_init(&scheduler, heap_storage, 1);
+    intersection_init(&intersection, plan, NULL, record_output);
+    intersection_set_mode(&scheduler, &intersection, false, false, 0);
+    intersection_start(&scheduler, &intersection, 0, 0);
+
+    TickType_t mode_tick = night ? pdMS_TO_TICKS(NIGHT_AT_MS) : RUN_MS;
+    uint64_t wakeups = 0;
+    uint64_t boundaries = 0;
+    while (true) {
+        TickType_t deadline;
+        bool queued = intersection_scheduler_next(&scheduler, &deadline);
+        TickType_t now = queued ? deadline : RUN_MS;
+        now = mode_tick < now ? mode_tick : now;
+        if (now >= RUN_MS) {
+            break;
+        }
+        wakeups++;
+        if (now == mode_tick) {
+            intersection_set_mode(&scheduler, &intersection, true, false, now);
+            mode_tick = RUN_MS;
+        }
+        if (queued && now == deadline) {
+            boundaries++;
+        }
+        intersection_scheduler_run(&scheduler, now);
+    }
+
+    *old_wakeups = boundaries;
+    if (night && CHECK(publishes[publish_count - 1].step == plan->night_step)) {
+        *old_wakeups += (RUN_MS - publishes[publish_count - 1].tick) / OLD_CONTROL_NIGHT_MS;
+    }
+    return wakeups;
+}
+
+// O que cada tarefa mostra no passo (o display redesenha a cada passo)
+static uint16_t output_value(output_task_t task, uint8_t step) {
+    switch (task) {
+        case OUTPUT_RGB_LED:
+            return signal_plan_indication(plan, step, plan->vehicle_group);
+        case OUTPUT_MATRIX:
+        case OUTPUT_BUZZER:
+            return signal_plan_indication(plan, step, plan->pedestrian_group);
+        default:
+            return step;
+    }
+}
+
+/*
+ * Saída vista por uma tarefa: consome as publicações até o instante em que
+ * ela acorda e guarda o tick da primeira que mudou a saída ainda não aplicada.
+ */
+typedef struct {
+    uint32_t next;          // próxima publicação a consumir
+    uint16_t applied;
+    uint16_t current;
+    bool pending;
+    TickType_t pending_tick;
+} output_view_t;
+
+static void view_consume(output_view_t *view, output_task_t task, TickType_t now) {
+    while (view->next < publish_count && publishes[view->next].tick <= now) {
+        view->current = output_value(task, publishes[view->next].step);
+        if (view->current == view->applied) {
+            view->pending = false;
+        } else if (!view->pending) {
+            view->pending = true;
+            view->pending_tick = publishes[view->next].tick;
+        }
+        view->next++;
+    }
+}
+
+// Acordada em now: aplica a saída pendente e mede a latência
+static bool view_apply(output_view_t *view, output_result_t *r, TickType_t now) {
+    r->wakeups++;
+    if (!view->pending) {
+        return false;
+    }
+    uint32_t latency_ms = (now - view->pending_tick) * portTICK_PERIOD_MS;
+    r->changes++;
+    r->latency_sum_ms += latency_ms;
+    r->latency_max_ms = latency_ms > r->latency_max_ms ? latency_ms : r->latency_max_ms;
+    view->applied = view->current;
+    view->pending = false;
+    return true;
+}
+
+// Antes: uma volta a cada poll_ms, a partir de phase_ms
+static void run_polling(output_task_t task, uint32_t phase_ms, output_result_t *r) {
+    output_view_t view = { .applied = NO_VALUE };
+    for (TickType_t now = pdMS_TO_TICKS(phase_ms); now < RUN_MS; now += pdMS_TO_TICKS(outputs[task].poll_ms)) {
+        view_consume(&view, task, now);
+        view_apply(&view, r, now);
+    }
+}
+
+// Prazo próprio da tarefa atual depois da volta em now (portMAX_DELAY = só eventos)
+static TickType_t own_deadline(output_task_t task, const output_view_t *view, bool changed,
+                               bool *flash_on, TickType_t *flash_tick, TickType_t now) {
+    switch (task) {
+        case OUTPUT_RGB_LED:
+            if (view->applied != SIGNAL_FLASH_YELLOW && view->applied != SIGNAL_FLASH_RED) {
+                return portMAX_DELAY;
+            }
+            if (changed || now >= *flash_tick) {
+                *flash_on = changed ? true : !*flash_on;
+                *flash_tick = now + pdMS_TO_TICKS(*flash_on ? TIME_NIGHT_FLASH_ON_MS : TIME_NIGHT_FLASH_OFF_MS);
+            }
+            return *flash_tick;
+        case OUTPUT_MATRIX:
+            if (view->applied != SIGNAL_FLASH_DONT_WALK) {
+                return portMAX_DELAY;
+            }
+            if (changed || now >= *flash_tick) {
+                *flash_tick = now + pdMS_TO_TICKS(TIME_PEDS_FLASH_INTERVAL_MS / 2);
+            }
+            return *flash_tick;
+        case OUTPUT_DISPLAY:
+            return now + pdMS_TO_TICKS(DISPLAY_REFRESH_FALLBACK_MS);
+        default:
+            return portMAX_DELAY;
+    }
+}
+
+// Depois (e o display nos dois): acorda na publicação ou no próprio prazo
+static void run_events(output_task_t task, output_result_t *r) {
+    output_view_t view = { .applied = NO_VALUE };
+    bool flash_on = false;
+    TickType_t flash_tick = 0;
+    TickType_t now = publishes[0].tick;     // bits ligados na partida
+    while (now < RUN_MS) {
+        view_consume(&view, task, now);
+        bool changed = view_apply(&view, r, now);
+        TickType_t deadline = own_deadline(task, &view, changed, &flash_on, &flash_tick, now);
+        TickType_t next_publish = view.next < publish_count ? publishes[view.next].tick : portMAX_DELAY;
+        now = next_publish < deadline ? next_publish : deadline;
+    }
+}
+
+static double per_second(uint64_t wakeups, uint32_t runs) {
+    return (double)wakeups * 1000.0 / ((double)RUN_MS * runs);
+}
+
+static double mean_ms(const output_result_t *r) {
+    return r->changes ? (double)r->latency_sum_ms / r->changes : 0.0;
+}
+
+static void run_mode(bool night) {
+    uint64_t old_control;
+    uint64_t new_control = run_controller(night, &old_control);
+    double old_total = per_second(old_control, 1);
+    double new_total = per_second(new_control, 1);
+
+    printf("plano \"%s\", %s, %u s virtuais: %lu publicacoes\n", plan->name,
+           night ? "modo noturno" : "modo normal", RUN_MS / 1000u, (unsigned long)publish_count);
+    printf("  %-8s antes %6.2f acordadas/s; depois %5.2f acordadas/s\n", "controle", old_total, new_total);
+    CHECK(new_control <= old_control + 1);  // +1: a troca de modo acorda o controle na hora
+
+    for (output_task_t task = 0; task < OUTPUT_COUNT; ++task) {
+        output_result_t before = { 0 };
+        output_result_t after = { 0 };
+        uint32_t phases = outputs[task].poll_ms ? outputs[task].poll_ms : 1;
+        for (uint32_t phase = 0; phase < phases; ++phase) {
+            if (outputs[task].poll_ms) {
+                run_polling(task, phase, &before);
+            } else {
+                run_events(task, &before);
+            }
+        }
+        run_events(task, &after);
+        double before_rate = per_second(before.wakeups, phases);
+        double after_rate = per_second(after.wakeups, 1);
+        old_total += before_rate;
+        new_total += after_rate;
+
+        CHECK(after.changes > 0 && after.latency_max_ms == 0);
+        CHECK(after_rate <= before_rate);
+        if (outputs[task].poll_ms) {
+            CHECK(before.latency_max_ms == outputs[task].poll_ms - 1);
+            CHECK(after_rate < before_rate);
+        }
+        printf("  %-8s antes %6.2f acordadas/s, latencia max/media %3lu/%4.1f ms; "
+               "depois %5.2f acordadas/s, latencia max/media %lu/%.1f ms\n",
+               outputs[task].name, before_rate, (unsigned long)before.latency_max_ms, mean_ms(&before),
+               after_rate, (unsigned long)after.latency_max_ms, mean_ms(&after));
+    }
+    printf("  %-8s antes %6.2f acordadas/s; depois %5.2f acordadas/s\n", "total", old_total, new_total);
+    CHECK(new_total * 10.0 < old_total);
+}
+
+int main(void) {
+    run_mode(false);
+    run_mode(true);
+    return test_finish("test_output_wakeups");
+}
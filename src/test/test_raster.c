@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ssd1306.h"
+#include "font.h"
+#include "test_hal.h"
+
+/*
+ * Rasterização do SSD1306: as primitivas por spans e o texto por colunas do
+ * glifo comparados, bit a bit, com a implementação anterior de um pixel por vez
+ * (abaixo, com recorte na borda, que a original não fazia), e o custo do layout
+ * da tarefa do display e de uma tela cheia de texto no host.
+ */
+
+#define FRAME_BYTES  (WIDTH * HEIGHT / 8)
+#define RANDOM_CALLS 200000
+#define RANDOM_TEXT  100000
+#define BENCH_FRAMES 20000
+#define TEXT_COLUMNS 15   // caracteres por linha que draw_string cabe em 128 px
+#define TEXT_ROWS    7
+
+static ssd1306_t ssd, ref;
+
+// ------------------------------------------------------------------ referência (um pixel por vez)
+
+static void ref_pixel(ssd1306_t *s, int x, int y, bool value) {
+    if (x < 0 || y < 0 || x >= s->width || y >= s->height) {
+        return;
+    }
+    uint16_t index = (y >> 3) + (x << 3) + 1;
+    if (value) {
+        s->ram_buffer[index] |= 1u << (y & 7);
+    } else {
+        s->ram_buffer[index] &= ~(1u << (y & 7));
+    }
+}
+
+static void ref_fill(ssd1306_t *s, bool value) {
+    for (int y = 0; y < s->height; ++y) {
+        for (int x = 0; x < s->width; ++x) {
+            ref_pixel(s, x, y, value);
+        }
+    }
+}
+
+static void ref_rect(ssd1306_t *s, int top, int left, int width, int height, bool value, bool fill) {
+    for (int x = left; x < left + width; ++x) {
+        ref_pixel(s, x, top, value);
+        ref_pixel(s, x, top + height - 1, value);
+    }
+    for (int y = top; y < top + height; ++y) {
+        ref_pixel(s, left, y, value);
+        ref_pixel(s, left + width - 1, y, value);
+    }
+    if (fill) {
+        for (int x = left + 1; x < left + width - 1; ++x) {
+            for (int y = top + 1; y < top + height - 1; ++y) {
+                ref_pixel(s, x, y, value);
+            }
+        }
+    }
+}
+
+static void ref_hline(ssd1306_t *s, int x0, int x1, int y, bool value) {
+    for (int x = x0; x <= x1; ++x) {
+        ref_pixel(s, x, y, value);
+    }
+}
+
+static void ref_vline(ssd1306_t *s, int x, int y0, int y1, bool value) {
+    for (int y = y0; y <= y1; ++y) {
+        ref_pixel(s, x, y, value);
+    }
+}
+
+static void ref_line(ssd1306_t *s, int x0, int y0, int x1, int y1, bool value) {
+    int dx = abs(x1 - x0), dy = abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int err = dx - dy;
+    while (true) {
+        ref_pixel(s, x0, y0, value);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int e2 = err * 2;
+        if (e2 > -dy) {
+            err -= dy;
+            x0 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// Versão anterior de ssd1306_draw_char: oito colunas de oito pixels
+static void ref_char(ssd1306_t *s, char c, uint8_t x, uint8_t y) {
+    uint16_t index = (c >= ' ' && c <= '~') ? (c - ' ') * 8 : 0;
+    for (uint8_t i = 0; i < 8; ++i) {
+        uint8_t line = font[index + i];
+        for (uint8_t j = 0; j < 8; ++j) {
+            ref_pixel(s, x + i, y + j, line & (1 << j));
+        }
+    }
+}
+
+// Mesma quebra de linha de ssd1306_draw_string
+static void ref_string(ssd1306_t *s, const char *str, uint8_t x, uint8_t y) {
+    while (*str) {
+        ref_char(s, *str++, x, y);
+        x += 8;
+        if (x + 8 >= s->width) {
+            x = 0;
+            y += 8;
+        }
+        if (y + 8 >= s->height) {
+            break;
+        }
+    }
+}
+
+// ------------------------------------------------------------------ conferência
+
+static bool same_frame(void) {
+    return memcmp(ssd.ram_buffer, ref.ram_buffer, FRAME_BYTES + 1) == 0;
+}
+
+// Todo byte alterado precisa estar dentro da janela suja da sua página
+static bool dirty_covers(const uint8_t *before) {
+    for (int page = 0; page < HEIGHT / 8; ++page) {
+        for (int x = 0; x < WIDTH; ++x) {
+            uint16_t index = 1 + (x << 3) + page;
+            if (ssd.ram_buffer[index] == before[index]) {
+                continue;
+            }
+            if (!(ssd.dirty_pages & (1u << page)) || x < ssd.dirty_x0[page] || x > ssd.dirty_x1[page]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Chamadas aleatórias, parte delas passando das bordas do painel
+static void random_primitives(void) {
+    uint8_t before[FRAME_BYTES + 1];
+    srand(3);
+    int mismatches = 0, uncovered = 0;
+    for (int i = 0; i < RANDOM_CALLS; ++i) {
+        int x0 = rand() % 140, y0 = rand() % 72, x1 = rand() % 140, y1 = rand() % 72;
+        int w = rand() % 100, h = rand() % 60;
+        bool value = rand() & 1;
+        memcpy(before, ssd.ram_buffer, sizeof(before));
+        ssd.dirty_pages = 0;
+        switch (rand() % 6) {
+            case 0:
+                ssd1306_fill(&ssd, value);
+                ref_fill(&ref, value);
+                break;
+            case 1:
+                if (w > 0 && h > 0) { // a referência desenha fora com largura ou altura 0
+                    bool fill = rand() & 1;
+                    ssd1306_rect(&ssd, y0, x0, w, h, value, fill);
+                    ref_rect(&ref, y0, x0, w, h, value, fill);
+                }
+                break;
+            case 2:
+                ssd1306_hline(&ssd, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, value);
+                ref_hline(&ref, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, value);
+                break;
+            case 3:
+                ssd1306_vline(&ssd, x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, value);
+                ref_vline(&ref, x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, value);
+                break;
+            case 4:
+                // Metade das linhas é reta (caminho dos spans), metade inclinada
+                if (rand() & 1) {
+                    x1 = x0;
+                } else if (rand() & 1) {
+                    y1 = y0;
+                }
+                x0 %= WIDTH, x1 %= WIDTH, y0 %= HEIGHT, y1 %= HEIGHT;
+                ssd1306_line(&ssd, x0, y0, x1, y1, value);
+                ref_line(&ref, x0, y0, x1, y1, value);
+                break;
+            default:
+                ssd1306_pixel(&ssd, x0, y0, value);
+                ref_pixel(&ref, x0, y0, value);
+                break;
+        }
+        if (!same_frame()) {
+            mismatches++;
+            memcpy(ref.ram_buffer, ssd.ram_buffer, sizeof(before));
+        }
+        if (!dirty_covers(before)) {
+            uncovered++;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(uncovered == 0);
+    printf("%d chamadas aleatorias: %d quadros diferentes da referencia, %d sem marca de sujo\n",
+           RANDOM_CALLS, mismatches, uncovered);
+}
+
+// Caracteres e strings aleatórios, com y alinhado ou não às páginas e parte
+// deles cortada pelas bordas direita e inferior
+static void random_text(void) {
+    uint8_t before[FRAME_BYTES + 1];
+    srand(4);
+    int mismatches = 0, uncovered = 0;
+    for (int i = 0; i < RANDOM_TEXT; ++i) {
+        uint8_t x = rand() % 140, y = rand() % 72;
+        if (rand() & 1) {
+            y &= ~7;
+        }
+        memcpy(before, ssd.ram_buffer, sizeof(before));
+        ssd.dirty_pages = 0;
+        if (rand() & 1) {
+            char c = (char)(rand() % 128); // inclui controles: viram espaço
+            ssd1306_draw_char(&ssd, c, x, y);
+            ref_char(&ref, c, x, y);
+        } else {
+            char str[24];
+            int len = rand() % (int)sizeof(str);
+            for (int n = 0; n < len; ++n) {
+                str[n] = (char)(' ' + rand() % 95);
+            }
+            str[len] = '\0';
+            ssd1306_draw_string(&ssd, str, x, y);
+            ref_string(&ref, str, x, y);
+        }
+        if (!same_frame()) {
+            mismatches++;
+            memcpy(ref.ram_buffer, ssd.ram_buffer, sizeof(before));
+        }
+        if (!dirty_covers(before)) {
+            uncovered++;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(uncovered == 0);
+    printf("%d textos aleatorios: %d quadros diferentes da referencia, %d sem marca de sujo\n",
+           RANDOM_TEXT, mismatches, uncovered);
+}
+
+// ------------------------------------------------------------------ custo
+
+// Layout fixo da tarefa do display: limpa, moldura e divisória (draw_state_frame)
+static void layout_new(void) {
+    ssd1306_fill(&ssd, false);
+    ssd1306_rect(&ssd, 0, 0, 127, 63, true, false);
+    ssd1306_hline(&ssd, 1, 126, 31, true);
+}
+
+static void layout_ref(void) {
+    ref_fill(&ref, false);
+    ref_rect(&ref, 0, 0, 127, 63, true, false);
+    ref_hline(&ref, 1, 126, 31, true);
+}
+
+static double bench_ns(void (*draw)(void)) {
+    uint64_t start = test_host_ns();
+    for (int i = 0; i < BENCH_FRAMES; ++i) {
+        draw();
+        __asm__ volatile("" ::: "memory");
+    }
+    return (double)(test_host_ns() - start) / BENCH_FRAMES;
+}
+
+static void layout_cost(void) {
+    layout_new();
+    layout_ref();
+    CHECK(same_frame());
+    double before = bench_ns(layout_ref);
+    double after = bench_ns(layout_new);
+    printf("layout da tarefa do display (limpa + moldura + divisoria): %.0f ns -> %.0f ns por quadro (%.0fx)\n",
+           before, after, before / after);
+}
+
+// Tela cheia de texto: TEXT_ROWS linhas de TEXT_COLUMNS caracteres, a partir
+// de y = 0 (páginas alinhadas) ou y = 3 (cada coluna dividida em duas páginas)
+static uint8_t text_top;
+
+static void text_new(void) {
+    for (uint8_t row = 0; row < TEXT_ROWS; ++row) {
+        for (uint8_t col = 0; col < TEXT_COLUMNS; ++col) {
+            ssd1306_draw_char(&ssd, 'A' + (row + col) % 26, col * 8, text_top + row * 8);
+        }
+    }
+}
+
+static void text_ref(void) {
+    for (uint8_t row = 0; row < TEXT_ROWS; ++row) {
+        for (uint8_t col = 0; col < TEXT_COLUMNS; ++col) {
+            ref_char(&ref, 'A' + (row + col) % 26, col * 8, text_top + row * 8);
+        }
+    }
+}
+
+static void text_cost(uint8_t top, const char *label) {
+    text_top = top;
+    ssd1306_fill(&ssd, false);
+    ref_fill(&ref, false);
+    text_new();
+    text_ref();
+    CHECK(same_frame());
+    double before = bench_ns(text_ref);
+    double after = bench_ns(text_new);
+    printf("tela cheia de texto (%dx%d, %s): %.0f ns -> %.0f ns por tela (%.0fx)\n",
+           TEXT_COLUMNS, TEXT_ROWS, label, before, after, before / after);
+}
+
+int main(void) {
+    ssd1306_init(&ssd, WIDTH, HEIGHT, false, 0x3C, i2c1);
+    ssd1306_init(&ref, WIDTH, HEIGHT, false, 0x3C, i2c1);
+
+    random_primitives();
+    random_text();
+    layout_cost();
+    text_cost(0, "y alinhado");
+    text_cost(3, "y = 3 mod 8");
+    return test_finish("test_raster");
+}
@@ -0,0 +1,247 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "intersection.h"
+#include "config.h"
+#include "test_hal.h"
+
+/*
+ * Tráfego no plano da placa (semáforo + travessia), um dia virtual por caso,
+ * pelo mesmo controle do firmware (intersection.c e o escalonador): chamadas
+ * de pedestre em chegadas de Poisson, tratadas como em pedestrian_call do
+ * main.c (ignoradas durante a travessia, registradas e acordando o controle
+ * nos demais passos). Para cada taxa de chamadas, em tempo fixo e no modo
+ * atuado, imprime a espera máxima e média dos pedestres e a fração do tempo
+ * em verde veicular, e confere a espera máxima contra o limite do plano:
+ *   - tempo fixo: o ciclo menos a travessia;
+ *   - atuado: o mesmo, com o verde no mínimo de PED_CALL_MIN_GREEN_MS.
+ *
+ * Com veículos, o modelo é o do traffic_sim: cada chegada passa pelo detector
+ * (a demanda do ajuste adaptativo) e entra numa fila que escoa no verde
+ * veicular, um veículo a cada 3600/ADAPTIVE_SAT_FLOW_VEH_PER_H s. Atraso =
+ * saída - chegada. Para cada fluxo, a mesma sequência de chegadas roda com os
+ * tempos da tabela e com os adaptativos (Webster), e o atraso médio é comparado.
+ * Por fim, o custo de uma atualização de adaptive_timing_cycle no host.
+ */
+
+#define TRAFFIC_HOURS   24
+#define CALL_RATES      { 30, 120, 600 }   // chamadas por hora
+#define VEHICLE_RATES   { 200, 400, 540 }  // veículos por hora (o plano fixo escoa ~570)
+#define VEHICLE_CALLS_PER_HOUR 60
+#define VEHICLE_HEADWAY_MS (3600000u / ADAPTIVE_SAT_FLOW_VEH_PER_H)
+#define VEHICLE_QUEUE_MAX  4096
+#define BENCH_UPDATES   100000
+
+typedef struct {
+    bool actuated;
+    bool adaptive;
+    uint32_t calls_per_hour;
+    uint32_t vehicles_per_hour;     // 0 = sem veículos
+} traffic_case_t;
+
+typedef struct {
+    uint32_t ignored;       // toques durante a travessia
+    ped_call_stats_t calls;
+    uint32_t vehicles;      // veículos que passaram
+    uint32_t queued;        // na fila no fim (não entram no atraso)
+    uint32_t queue_max;
+    uint64_t delay_sum_ms;
+} traffic_result_t;
+
+static intersection_t intersection;
+static intersection_t *heap_storage[1];
+static intersection_scheduler_t scheduler;
+static adaptive_timing_t timing;
+static TickType_t vehicle_queue[VEHICLE_QUEUE_MAX];  // chegadas, em fila circular
+static uint32_t vehicle_rng;
+
+// Uniforme em (0, 1): chamadas pelo rand(), veículos por um xorshift32 à parte,
+// para os veículos não mudarem a sequência de chamadas
+static double call_uniform(void) {
+    return (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+}
+
+static double vehicle_uniform(void) {
+    vehicle_rng ^= vehicle_rng << 13;
+    vehicle_rng ^= vehicle_rng >> 17;
+    vehicle_rng ^= vehicle_rng << 5;
+    return (vehicle_rng + 1.0) / 4294967297.0;
+}
+
+// Intervalo até a próxima chegada (exponencial), em ms, pelo menos 1
+static uint32_t next_arrival_ms(uint32_t per_hour, double u) {
+    uint32_t gap_ms = (uint32_t)(-log(u) * 3600000.0 / per_hour);
+    return gap_ms > 0 ? gap_ms : 1;
+}
+
+// Espera máxima possível: do fim da travessia até a próxima, com o verde em green_ms
+static uint32_t wait_bound_ms(const signal_plan_t *plan, uint32_t green_ms) {
+    return signal_plan_cycle_ms(plan) - plan->steps[plan->rest_step].duration_ms + green_ms
+           - plan->steps[plan->call_step].duration_ms;
+}
+
+static bool vehicle_green(const signal_plan_t *plan) {
+    return signal_plan_indication(plan, intersection_step(&intersection), plan->vehicle_group) == SIGNAL_GREEN;
+}
+
+static traffic_result_t run(const signal_plan_t *plan, const traffic_case_t *c) {
+    traffic_result_t r = { 0 };
+    // As mesmas chegadas com e sem ajuste
+    srand(c->calls_per_hour);
+    vehicle_rng = c->vehicles_per_hour + 1;
+    TickType_t now = (TickType_t)(time_us_64() / 1000u) + 1;
+    TickType_t end = now + pdMS_TO_TICKS((uint32_t)TRAFFIC_HOURS * 3600000u);
+    TickType_t never = end + 1;
+    test_run_until_us((uint64_t)now * 1000u);
+
+    adaptive_timing_init(&timing, plan, c->adaptive,
+                         (1u << plan->vehicle_group) | (1u << plan->pedestrian_group));
+    intersection_scheduler_init(&scheduler, heap_storage, 1);
+    intersection_init(&intersection, plan, &timing, NULL);
+    intersection_set_mode(&scheduler, &intersection, false, c->actuated, now);
+    intersection_start(&scheduler, &intersection, now, 0);
+
+    TickType_t next_call = now + pdMS_TO_TICKS(next_arrival_ms(c->calls_per_hour, call_uniform()));
+    TickType_t next_vehicle = never;
+    if (c->vehicles_per_hour > 0) {
+        next_vehicle = now + pdMS_TO_TICKS(next_arrival_ms(c->vehicles_per_hour, vehicle_uniform()));
+    }
+    uint32_t head = 0;
+    TickType_t last_departure = now - pdMS_TO_TICKS(VEHICLE_HEADWAY_MS);
+
+    while (true) {
+        // Próximo evento: fronteira de passo, saída da fila, chamada ou veículo
+        TickType_t deadline;
+        bool queued = intersection_scheduler_next(&scheduler, &deadline);
+        TickType_t next_departure = never;
+        if (r.queued > 0 && vehicle_green(plan)) {
+            next_departure = last_departure + pdMS_TO_TICKS(VEHICLE_HEADWAY_MS);
+            next_departure = next_departure > now ? next_departure : now;
+        }
+        now = queued ? deadline : never;
+        now = next_departure < now ? next_departure : now;
+        now = next_call < now ? next_call : now;
+        now = next_vehicle < now ? next_vehicle : now;
+        if (now >= end) {
+            break;
+        }
+        test_run_until_us((uint64_t)now * 1000u);
+
+        if (queued && now == deadline) {
+            intersection_scheduler_run(&scheduler, now);
+        } else if (now == next_departure) {
+            r.delay_sum_ms += now - vehicle_queue[head];
+            r.vehicles++;
+            head = (head + 1) % VEHICLE_QUEUE_MAX;
+            r.queued--;
+            last_departure = now;
+        } else if (now == next_call) {
+            adaptive_timing_arrival(&timing, plan->pedestrian_group);
+            if (intersection_step(&intersection) == plan->call_step) {
+                r.ignored++;
+            } else {
+                ped_call_register(&intersection.calls, time_us_32());
+                intersection_set_mode(&scheduler, &intersection, false, c->actuated, now);
+                intersection_scheduler_run(&scheduler, now);
+            }
+            next_call += pdMS_TO_TICKS(next_arrival_ms(c->calls_per_hour, call_uniform()));
+        } else {
+            // Detector antes da linha de retenção; com fila vazia e verde livre, passa direto
+            adaptive_timing_arrival(&timing, plan->vehicle_group);
+            if (r.queued == 0 && vehicle_green(plan) &&
+                now - last_departure >= pdMS_TO_TICKS(VEHICLE_HEADWAY_MS)) {
+                r.vehicles++;
+                last_departure = now;
+            } else if (CHECK(r.queued < VEHICLE_QUEUE_MAX)) {
+                vehicle_queue[(head + r.queued++) % VEHICLE_QUEUE_MAX] = now;
+                r.queue_max = r.queued > r.queue_max ? r.queued : r.queue_max;
+            }
+            next_vehicle += pdMS_TO_TICKS(next_arrival_ms(c->vehicles_per_hour, vehicle_uniform()));
+        }
+    }
+    ped_call_get(&intersection.calls, &r.calls);
+    return r;
+}
+
+// Custo de uma atualização (fronteira de ciclo) no host, com demanda em todos os grupos
+static void bench_update(const signal_plan_t *plan) {
+    adaptive_timing_init(&timing, plan, true, (uint16_t)((1u << plan->group_count) - 1));
+    uint32_t cycle_ms = signal_plan_cycle_ms(plan);
+    uint64_t start_ns = test_host_ns();
+    for (uint32_t i = 0; i < BENCH_UPDATES; ++i) {
+        for (uint8_t group = 0; group < plan->group_count; ++group) {
+            timing.arrivals[group] = (uint16_t)((i + group) % 7);
+        }
+        adaptive_timing_cycle(&timing, cycle_ms);
+        cycle_ms = timing.cycle_ms;
+    }
+    double update_ns = (double)(test_host_ns() - start_ns) / BENCH_UPDATES;
+    CHECK(timing.enabled && timing.updates == BENCH_UPDATES);
+    printf("plano \"%s\": %u grupos, %u passos ajustaveis; adaptive_timing_cycle %.0f ns por atualizacao no host\n",
+           plan->name, plan->group_count, timing.green_step_count, update_ns);
+}
+
+int main(void) {
+    const signal_plan_t *plan = &signal_plan_pedestrian;
+    const uint32_t rates[] = CALL_RATES;
+    uint32_t fixed_bound_ms = wait_bound_ms(plan, plan->steps[plan->rest_step].duration_ms);
+    uint32_t actuated_bound_ms = wait_bound_ms(plan, PED_CALL_MIN_GREEN_MS);
+    double fixed_green = 0.0;
+
+    printf("plano \"%s\", %d h por caso; espera maxima possivel: %lu ms (fixo), %lu ms (atuado)\n",
+           plan->name, TRAFFIC_HOURS, (unsigned long)fixed_bound_ms, (unsigned long)actuated_bound_ms);
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i) {
+        for (int actuated = 0; actuated <= 1; ++actuated) {
+            traffic_case_t c = { .actuated = actuated, .calls_per_hour = rates[i] };
+            traffic_result_t r = run(plan, &c);
+            const ped_call_stats_t *s = &r.calls;
+            double green = s->total_ms ? 100.0 * s->green_ms / s->total_ms : 0.0;
+            CHECK(s->calls > 0);
+            CHECK(s->served + 1 >= s->calls);   // no máximo uma pendente no fim
+            CHECK(s->wait_max_ms <= (actuated ? actuated_bound_ms : fixed_bound_ms));
+            if (!actuated) {
+                fixed_green = green;
+            } else if (rates[i] <= 120) {
+                CHECK(green > fixed_green); // pouca demanda: o verde descansa em vez de servir travessias vazias
+            }
+            printf("%3lu chamadas/h, %-10s: %lu chamadas (+%lu na travessia, +%lu repetidas), espera max/media %lu/%lu ms, "
+                   "verde veicular %.1f%%\n",
+                   (unsigned long)rates[i], actuated ? "atuado" : "tempo fixo", (unsigned long)s->calls,
+                   (unsigned long)r.ignored, (unsigned long)s->repeats, (unsigned long)s->wait_max_ms,
+                   (unsigned long)(s->served ? s->wait_sum_ms / s->served : 0), green);
+        }
+    }
+
+    // Tempo fixo x adaptativo: mesmas chegadas, atraso médio dos veículos
+    const uint32_t flows[] = VEHICLE_RATES;
+    for (size_t i = 0; i < sizeof(flows) / sizeof(flows[0]); ++i) {
+        double delay[2];
+        for (int adaptive = 0; adaptive <= 1; ++adaptive) {
+            traffic_case_t c = { .adaptive = adaptive, .calls_per_hour = VEHICLE_CALLS_PER_HOUR,
+                                 .vehicles_per_hour = flows[i] };
+            traffic_result_t r = run(plan, &c);
+            delay[adaptive] = r.vehicles ? r.delay_sum_ms / 1000.0 / r.vehicles : 0.0;
+            CHECK(r.vehicles > 0);
+            CHECK(!adaptive || timing.enabled);
+            CHECK(r.calls.wait_max_ms <= (adaptive ? ADAPTIVE_CYCLE_MAX_MS : fixed_bound_ms));
+            printf("%3lu veiculos/h, %-10s: %lu passaram, %lu na fila (max %lu), atraso medio %.1f s; "
+                   "pedestres: espera max/media %lu/%lu ms",
+                   (unsigned long)flows[i], adaptive ? "adaptativo" : "tabela", (unsigned long)r.vehicles,
+                   (unsigned long)r.queued, (unsigned long)r.queue_max, delay[adaptive],
+                   (unsigned long)r.calls.wait_max_ms,
+                   (unsigned long)(r.calls.served ? r.calls.wait_sum_ms / r.calls.served : 0));
+            if (adaptive) {
+                printf("; ciclo %lu ms, verde %u ms, travessia %u ms",
+                       (unsigned long)timing.cycle_ms, adaptive_timing_duration(&timing, plan->rest_step),
+                       adaptive_timing_duration(&timing, plan->call_step));
+            }
+            printf("\n");
+        }
+        CHECK(delay[1] < delay[0]);
+    }
+
+    bench_update(plan);
+    bench_update(&signal_plan_nema8);
+    return test_finish("test_traffic");
+}
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Relatório de RAM/flash por subsistema a partir do .map do linker (GNU ld).
+
+Soma cada seção de entrada (.text.*, .rodata.*, .data.*, .bss.*) pelo endereço:
+RAM do RP2040 (0x20000000, 264 KB) ou flash XIP (0x10000000). .data conta nas
+duas (cópia inicial na flash). O subsistema vem do objeto que definiu a seção,
+exceto pilhas e TCBs das tarefas (*_stack, *_tcb, ver static_memory.h), que
+formam um subsistema próprio.
+
+Sai com código 1 se algum subsistema ou o total passar do orçamento, ou, com
+--no-heap, se o heap do FreeRTOS (heap_N.c / ucHeap) estiver ligado.
+
+Uso: ram_budget.py [--no-heap] [--budget subsistema=ram_kb:flash_kb ...] main.elf.map
+"""
+
+import argparse
+import re
+import sys
+
+RAM = (0x20000000, 0x20042000)
+FLASH = (0x10000000, 0x11000000)
+
+# (RAM, flash) em bytes. Ajustar aqui quando um subsistema crescer de propósito.
+BUDGETS = {
+    "tarefas":      (32 * 1024, 0),
+    "freertos":     (4 * 1024, 32 * 1024),
+    "controle":     (4 * 1024, 16 * 1024),
+    "display":      (16 * 1024, 24 * 1024),
+    "perifericos":  (4 * 1024, 16 * 1024),
+    "estatisticas": (8 * 1024, 16 * 1024),
+    "aplicacao":    (8 * 1024, 24 * 1024),
+    "pico-sdk":     (16 * 1024, 64 * 1024),
+    "libc":         (8 * 1024, 64 * 1024),
+    "outros":       (4 * 1024, 16 * 1024),
+}
+TOTAL_BUDGET = (96 * 1024, 512 * 1024)
+
+# (trecho do caminho do objeto, subsistema), na ordem de prioridade
+OBJECT_RULES = [
+    ("FreeRTOS-Kernel", "freertos"),
+    ("static_memory.c", "tarefas"),
+    ("lib/ssd1306/", "display"),
+    ("display.c", "display"),
+    ("signal_plan.c", "controle"),
+    ("intersection.c", "controle"),
+    ("adaptive_timing.c", "controle"),
+    ("ped_call.c", "controle"),
+    ("led_matrix.c", "perifericos"),
+    ("buzzer.c", "perifericos"),
+    ("buttons.c", "perifericos"),
+    ("debouncer.c", "perifericos"),
+    ("task_stats.c", "estatisticas"),
+    ("power_stats.c", "estatisticas"),
+    ("cycle_stats.c", "estatisticas"),
+    ("trace.c", "estatisticas"),
+    ("main.c", "aplicacao"),
+    ("libc", "libc"),
+    ("libm", "libc"),
+    ("libg", "libc"),
+    ("libnosys", "libc"),
+    ("libstdc++", "libc"),
+    ("pico-sdk", "pico-sdk"),
+    ("pico_", "pico-sdk"),
+    ("rp2_common", "pico-sdk"),
+    ("boot2", "pico-sdk"),
+]
+
+HEAP_OBJECT = re.compile(r"MemMang/heap_\d\.c")
+INPUT_ONE_LINE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+INPUT_NAME_ONLY = re.compile(r"^ (\S+)$")
+INPUT_CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+
+
+def subsystem(section, obj):
+    symbol = section.split(".")[2] if section.count(".") >= 2 else ""
+    if symbol.endswith("_stack") or symbol.endswith("_tcb"):
+        return "tarefas"
+    for fragment, name in OBJECT_RULES:
+        if fragment in obj:
+            return name
+    return "outros"
+
+
+def input_sections(lines):
+    """Gera (seção, endereço, tamanho, objeto) do mapa de memória."""
+    in_map = False
+    pending = None
+    for line in lines:
+        if line.startswith("Linker script and memory map"):
+            in_map = True
+            continue
+        if not in_map:
+            continue
+        if pending is not None:
+            match = INPUT_CONTINUATION.match(line)
+            name, pending = pending, None
+            if match:
+                yield name, int(match.group(1), 16), int(match.group(2), 16), match.group(3).strip()
+                continue
+        match = INPUT_ONE_LINE.match(line)
+        if match:
+            yield match.group(1), int(match.group(2), 16), int(match.group(3), 16), match.group(4).strip()
+            continue
+        match = INPUT_NAME_ONLY.match(line)
+        if match and match.group(1).startswith("."):
+            pending = match.group(1)
+
+
+def parse_budget(text):
+    name, _, sizes = text.partition("=")
+    ram_kb, _, flash_kb = sizes.partition(":")
+    return name, (int(float(ram_kb) * 1024), int(float(flash_kb or 0) * 1024))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", help="arquivo .map (ex.: build/main.elf.map)")
+    parser.add_argument("--no-heap", action="store_true", help="falha se o heap do FreeRTOS estiver ligado")
+    parser.add_argument("--budget", action="append", default=[], metavar="SUB=RAM_KB:FLASH_KB",
+                        help="troca o orçamento de um subsistema (ou de 'total')")
+    args = parser.parse_args()
+
+    budgets = dict(BUDGETS)
+    total_budget = TOTAL_BUDGET
+    for text in args.budget:
+        name, sizes = parse_budget(text)
+        if name == "total":
+            total_budget = sizes
+        else:
+            budgets[name] = sizes
+
+    with open(args.map, encoding="utf-8", errors="replace") as f:
+        lines = f.read().splitlines()
+
+    usage = {name: [0, 0] for name in budgets}
+    heap_linked = []
+    for section, address, size, obj in input_sections(lines):
+        if size == 0 or "(" in obj and ".o" not in obj:
+            continue
+        if HEAP_OBJECT.search(obj) or section.endswith(".ucHeap"):
+            heap_linked.append(f"{section} ({obj})")
+        name = subsystem(section, obj)
+        entry = usage.setdefault(name, [0, 0])
+        if RAM[0] <= address < RAM[1]:
+            entry[0] += size
+            if section.startswith(".data") or section.startswith(".time_critical"):
+                entry[1] += size  # valor inicial copiado da flash
+        elif FLASH[0] <= address < FLASH[1]:
+            entry[1] += size
+
+    errors = []
+    print(f"{'subsistema':<14} {'RAM':>9} {'orcamento':>10} {'flash':>9} {'orcamento':>10}")
+    total = [0, 0]
+    for name, (ram, flash) in sorted(usage.items(), key=lambda item: -item[1][0]):
+        ram_budget, flash_budget = budgets.get(name, (0, 0))
+        print(f"{name:<14} {ram:>9} {ram_budget:>10} {flash:>9} {flash_budget:>10}")
+        total[0] += ram
+        total[1] += flash
+        if ram > ram_budget:
+            errors.append(f"{name}: RAM {ram} > {ram_budget} bytes")
+        if flash > flash_budget:
+            errors.append(f"{name}: flash {flash} > {flash_budget} bytes")
+    print(f"{'total':<14} {total[0]:>9} {total_budget[0]:>10} {total[1]:>9} {total_budget[1]:>10}")
+    print(f"RAM livre: {RAM[1] - RAM[0] - total[0]} de {RAM[1] - RAM[0]} bytes")
+    if total[0] > total_budget[0]:
+        errors.append(f"total: RAM {total[0]} > {total_budget[0]} bytes")
+    if total[1] > total_budget[1]:
+        errors.append(f"total: flash {total[1]} > {total_budget[1]} bytes")
+    if args.no_heap and heap_linked:
+        errors.append("heap do FreeRTOS ligado: " + ", ".join(heap_linked[:3]))
+
+    for error in errors:
+        print(f"ERRO: {error}", file=sys.stderr)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Decodifica os quadros de trace binário do semáforo em uma linha do tempo.
+
+Lê uma captura bruta da serial (arquivo ou stdin) ou, com --port, a própria
+porta (requer pyserial). Texto de printf e quadros de estatísticas misturados
+na mesma serial são ignorados.
+
+Quadro: A5 7E | ctx | n | descartados u16 | n * evento | checksum
+Evento (8 bytes, little-endian): timestamp_us u32 | tipo u8 | ctx u8 | arg u16
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b"\xa5\x7e"
+EVENT = struct.Struct("<IBBH")
+
+CONTEXTS = ["ISR", "CONTROL", "BUTTON", "DISPLAY", "MATRIX"]
+
+STATES = [
+    "CARS_GREEN_LIGHT",
+    "CARS_YELLOW_LIGHT",
+    "CARS_PED_RED_LIGHT",
+    "CARS_RED_PEDS_WALK",
+    "CARS_RED_PEDS_FLASH",
+    "CARS_NIGHT_FLASHING",
+]
+
+
+def describe(ev_type, arg):
+    if ev_type == 1:
+        return "PHASE", STATES[arg] if arg < len(STATES) else f"estado {arg}"
+    if ev_type == 2:
+        return "MODE", "noturno" if arg else "normal"
+    if ev_type == 3:
+        return "BUTTON_EDGE", f"gpio {arg}"
+    if ev_type == 4:
+        return "DEBOUNCE_REJECT", f"gpio {arg}"
+    if ev_type == 5:
+        return "DISPLAY_FLUSH", ""
+    if ev_type == 6:
+        return "DISPLAY_DONE", "ok" if arg else "erro"
+    if ev_type == 7:
+        return "MATRIX_FRAME", "pendente" if arg else "enviado"
+    if ev_type == 8:
+        return "MATRIX_LATCH", "pendente enviado" if arg else "livre"
+    if ev_type == 9:
+        gesture = {1: "toque", 2: "toque longo", 4: "toque duplo"}.get(arg & 0xFF, str(arg & 0xFF))
+        button = "AB"[arg >> 8] if (arg >> 8) < 2 else str(arg >> 8)
+        return "BUTTON_GESTURE", f"botao {button}: {gesture}"
+    return f"TIPO_{ev_type}", str(arg)
+
+
+def parse_frames(data):
+    """Extrai (ctx, descartados, [eventos]) de um buffer; devolve o resto não consumido."""
+    frames = []
+    pos = 0
+    while True:
+        start = data.find(SYNC, pos)
+        if start < 0:
+            return frames, data[max(len(data) - 1, pos):]
+        if len(data) < start + 6:
+            return frames, data[start:]
+        ctx, count, dropped = data[start + 2], data[start + 3], struct.unpack_from("<H", data, start + 4)[0]
+        end = start + 6 + count * EVENT.size
+        if len(data) < end + 1:
+            return frames, data[start:]
+        if (sum(data[start + 2:end + 1]) & 0xFF) != 0:
+            pos = start + 1  # sincronismo falso (ex.: bytes de outro quadro)
+            continue
+        events = [EVENT.unpack_from(data, start + 6 + i * EVENT.size) for i in range(count)]
+        frames.append((ctx, dropped, events))
+        pos = end + 1
+
+
+class Timeline:
+    """Ordena por tempo e desdobra o contador de 32 bits (volta a cada ~71 min)."""
+
+    def __init__(self):
+        self.events = []
+        self.dropped = [0] * len(CONTEXTS)
+        self.epoch = 0
+        self.last_ts = None
+
+    def add(self, ctx, dropped, events):
+        if ctx < len(self.dropped):
+            self.dropped[ctx] += dropped
+        for ts, ev_type, ev_ctx, arg in events:
+            if self.last_ts is not None and ts < self.last_ts and self.last_ts - ts > 0x80000000:
+                self.epoch += 1 << 32
+            self.last_ts = ts
+            self.events.append((self.epoch + ts, ev_ctx, ev_type, arg))
+
+    def print(self, out):
+        self.events.sort(key=lambda e: e[0])
+        t0 = self.events[0][0] if self.events else 0
+        prev = t0
+        for ts, ctx, ev_type, arg in self.events:
+            name, detail = describe(ev_type, arg)
+            ctx_name = CONTEXTS[ctx] if ctx < len(CONTEXTS) else str(ctx)
+            out.write(f"{(ts - t0) / 1000:12.3f} ms  +{(ts - prev) / 1000:9.3f}  {ctx_name:<8} {name:<16} {detail}\n")
+            prev = ts
+        for ctx, dropped in enumerate(self.dropped):
+            if dropped:
+                out.write(f"# {CONTEXTS[ctx]}: {dropped} eventos descartados (anel cheio)\n")
+
+
+def read_chunks(args):
+    if args.port:
+        import serial  # pyserial
+
+        with serial.Serial(args.port, args.baud, timeout=0.2) as port:
+            while True:
+                yield port.read(4096)
+    else:
+        stream = open(args.capture, "rb") if args.capture != "-" else sys.stdin.buffer
+        while True:
+            chunk = stream.read(4096)
+            if not chunk:
+                return
+            yield chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", default="-", help="captura binária da serial (- = stdin)")
+    parser.add_argument("--port", help="porta serial para ler ao vivo (ex.: /dev/ttyACM0)")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    timeline = Timeline()
+    pending = b""
+    try:
+        for chunk in read_chunks(args):
+            frames, pending = parse_frames(pending + chunk)
+            for frame in frames:
+                timeline.add(*frame)
+            if args.port:
+                timeline.print(sys.stdout)
+                timeline.events.clear()
+    except KeyboardInterrupt:
+        pass
+    timeline.print(sys.stdout)
+
+
+if __name__ == "__main__":
+    main()